@@ -270,6 +270,54 @@ size_t encode_opcode(std::string op) {
   return iter->second;
 }
 
+// look-up an elementwise instruction that a 'fuse' region can evaluate
+bool find_fused_opcode(size_t opcode, FusedOpcode& info) {
+  // only 64-bit arithmetic, where the operands and result share a type
+  static std::unordered_map<size_t, FusedOpcode> fusable_;
+  if (fusable_.empty()) {
+    struct BinaryOp {
+      std::string name;
+      SimdOp op;
+      bool ints;
+      bool floats;
+    };
+    const BinaryOp binops[] = {
+      {"add", SimdOp::kAdd, true, true},
+      {"sub", SimdOp::kSub, true, true},
+      {"mul", SimdOp::kMul, true, true},
+      {"div", SimdOp::kDiv, false, true},
+      {"bitand", SimdOp::kBitAnd, true, false},
+      {"bitor", SimdOp::kBitOr, true, false}
+    };
+    for (auto& b: binops) {
+      for (bool is_float: {false, true}) {
+        if (is_float ? !b.floats : !b.ints) {
+          continue;
+        }
+        std::string t = is_float ? "f64" : "i64";
+        std::string prefix = b.name + '_' + t;
+        fusable_[encode_opcode(prefix + "v_" + t + 'v')] =
+          FusedOpcode{b.op, is_float, 3, true, true};
+        fusable_[encode_opcode(prefix + "v_" + t + 's')] =
+          FusedOpcode{b.op, is_float, 3, true, false};
+        fusable_[encode_opcode(prefix + "s_" + t + 'v')] =
+          FusedOpcode{b.op, is_float, 3, false, true};
+      }
+    }
+    fusable_[encode_opcode("neg_i64v")] =
+      FusedOpcode{SimdOp::kNeg, false, 2, true, false};
+    fusable_[encode_opcode("neg_f64v")] =
+      FusedOpcode{SimdOp::kNeg, true, 2, true, false};
+  }
+
+  auto iter = fusable_.find(opcode);
+  if (iter == fusable_.end()) {
+    return false;
+  }
+  info = iter->second;
+  return true;
+}
+
 // disassemble a program
 std::string to_string(const Program& program) {
   std::string result;
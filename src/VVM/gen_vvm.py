@@ -61,6 +61,12 @@ def _make_opcodes():
       # (Value,Kind)->String
       ('', 'load',         '', 3),
       # (String,Kind)->Value
+      ('', 'loadproj',     '', 4),
+      # (String,Kind,Kind)->Value
+      ('', 'loadwhere',    '', 6),
+      # (String,Kind,Int64,Int64,Value)->Value
+      ('', 'loadrows',     '', 5),
+      # (String,Kind,Int64,Int64)->Value
       ('', 'store',        '', 4),
       # (Kind,Value,String)->()
       ('', 'where',        '', 4),
@@ -99,6 +105,8 @@ def _make_opcodes():
       # (Kind,Kind,Value)->Value
       ('', 'concat',       '', 4),
       # (Kind,Value,Value)->Value
+      ('', 'fuse',         '', 1),
+      # (Int64,...)
     ]
 
     opcodes += [('now', 'now', 'Timestamp', 1)]
@@ -607,7 +615,7 @@ class DispatchWriter(HeaderWriter):
                 self.emit('p = ip_;', 2)
                 self.emit('ip_ += %d;' % (o[3] + 1), 2)
                 args = ['code[p + %d]' % (i+1) for i in range(o[3])]
-                if oc in ['ret', 'call']:
+                if oc in ['ret', 'call', 'fuse']:
                     args += ['code']
                 s = ', '.join(args)
                 name = get_cpp_func(o[1], o[2])
@@ -629,7 +637,7 @@ class DispatchWriter(HeaderWriter):
                 self.emit('p = ip_;', 4)
                 self.emit('ip_ += %d;' % (o[3] + 1), 4)
                 args = ['code[p + %d]' % (i+1) for i in range(o[3])]
-                if oc in ['ret', 'call']:
+                if oc in ['ret', 'call', 'fuse']:
                     args += ['code']
                 s = ', '.join(args)
                 name = get_cpp_func(o[1], o[2])
@@ -666,20 +674,275 @@ class ReprWriter(HeaderWriter):
         self.emit('}', 1)
         self.emit('}')
         self.emit('')
+        self.emit('size_t column_trim(vvm_types t, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return column_trim<%s>(v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void format_cells(vvm_types t, Value v, size_t b,'
+                  ' size_t e, size_t n, std::vector<std::string>& c) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return format_cells<%s>(v, b, e, n, c);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
 
 
 class ParseWriter(HeaderWriter):
     """ Write parser logic """
 
     def run(self):
-        self.emit('void parse_array(vvm_types t,'
-                  ' const std::vector<std::string>& s, Value v) {')
+        self.emit('void parse_cells(vvm_types t,'
+                  ' std::vector<csvmonkey::CsvCell>& c, Value v,'
+                  ' const StrtimeFormat& f) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            if t[0] in time_ish_types:
+                call = 'return parse_times<%s>(c, v, f);' % t[2]
+            else:
+                call = 'return parse_cells<%s>(c, v);' % t[2]
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit(call, 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit(call, 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void match_cells(vvm_types t,'
+                  ' std::vector<csvmonkey::CsvCell>& c,'
+                  ' const StrtimeFormat& f, operand_t o, Comparison p,'
+                  ' std::vector<char>& k) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return match_cells<%s>(t, c, f, o, p, k);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return match_cells<%s>(t, c, f, o, p, k);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void match_values(vvm_types t, Value v, operand_t o,'
+                  ' Comparison p, std::vector<char>& k) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return match_values<%s>(v, o, p, k);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return match_values<%s>(v, o, p, k);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+
+
+class ColumnarWriter(HeaderWriter):
+    """ Write binary column logic """
+
+    def run(self):
+        self.emit('void read_column(vvm_types t,'
+                  ' const char* b, const char* e, size_t n, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return read_column<%s>(b, e, n, v);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return read_column<%s>(b, e, n, v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('bool mappable_column(vvm_types t,'
+                  ' const char* b, const char* e, size_t n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return mappable_column<%s>(b, e, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return mappable_column<%s>(b, e, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('size_t write_column(vvm_types t,'
+                  ' std::ostream& o, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return write_column<%s>(o, v);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return write_column<%s>(o, v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('size_t write_compressed(vvm_types t,'
+                  ' std::ostream& o, Value v, size_t p) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return write_compressed<%s>(o, v, p);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return write_compressed<%s>(o, v, p);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void read_compressed(vvm_types t, const char* d,'
+                  ' const CompressedColumn& c, size_t b, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return read_compressed<%s>(d, c, b, v);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return read_compressed<%s>(d, c, b, v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('ArrowField arrow_field(vvm_types t, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return arrow_field<%s>(v);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return arrow_field<%s>(v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void arrow_lengths(vvm_types t, Value v,'
+                  ' const ArrowField& f, ArrowNode& n,'
+                  ' std::vector<int64_t>& l) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return arrow_lengths<%s>(v, f, n, l);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return arrow_lengths<%s>(v, f, n, l);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void write_arrow(vvm_types t, std::ostream& o, Value v,'
+                  ' const ArrowField& f, const ArrowNode& n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return write_arrow<%s>(o, v, f, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return write_arrow<%s>(o, v, f, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void read_arrow(vvm_types t, const char* d,'
+                  ' const ArrowField& f, const ArrowNode& n,'
+                  ' const ArrowBuffer* b, size_t c, Value v,'
+                  ' Validity& a) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return read_arrow<%s>(d, f, n, b, c, v, a);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return read_arrow<%s>(d, f, n, b, c, v, a);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('bool mappable_arrow(vvm_types t, const char* d,'
+                  ' const ArrowField& f, const ArrowNode& n,'
+                  ' const ArrowBuffer* b) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return mappable_arrow<%s>(d, f, n, b);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return mappable_arrow<%s>(d, f, n, b);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('bool block_may_match(vvm_types t,'
+                  ' const CompressedBlock& b, operand_t v, Comparison c) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return block_may_match<%s>(b, v, c);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return block_may_match<%s>(b, v, c);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+
+
+class SpliceWriter(HeaderWriter):
+    """ Write splice logic """
+
+    def run(self):
+        self.emit('void splice_elem(vvm_types t,'
+                  ' Value s, Value d, size_t n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return splice_elem<%s>(s, d, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return splice_elem<%s>(s, d, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void reserve_elem(vvm_types t, Value v, size_t n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return reserve_elem<%s>(v, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return reserve_elem<%s>(v, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void fill_elem(vvm_types t, Value v, size_t n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return fill_elem<%s>(v, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return fill_elem<%s>(v, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void truncate_elem(vvm_types t, Value v, size_t n) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return truncate_elem<%s>(v, n);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return truncate_elem<%s>(v, n);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void replace_elem(vvm_types t, Value s, Value d) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return replace_elem<%s>(s, d);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return replace_elem<%s>(s, d);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void release_elem(vvm_types t, Value v) {')
+        self.emit('switch (t) {', 1)
+        for t in types:
+            self.emit('case vvm_types::%ss:' % t[1], 2)
+            self.emit('return release_elem<%s>(v);' % t[2], 3)
+            self.emit('case vvm_types::%sv:' % t[1], 2)
+            self.emit('return release_elem<%s>(v);' % t[2], 3)
+        self.emit('}', 1)
+        self.emit('}')
+        self.emit('')
+        self.emit('void check_nil_free_elem(vvm_types t, Value v) {')
         self.emit('switch (t) {', 1)
         for t in types:
             self.emit('case vvm_types::%ss:' % t[1], 2)
-            self.emit('return parse_array<%s>(s, v);' % t[2], 3)
+            self.emit('return check_nil_free_elem<%s>(v);' % t[2], 3)
             self.emit('case vvm_types::%sv:' % t[1], 2)
-            self.emit('return parse_array<%s>(s, v);' % t[2], 3)
+            self.emit('return check_nil_free_elem<%s>(v);' % t[2], 3)
         self.emit('}', 1)
         self.emit('}')
         self.emit('')
@@ -1006,6 +1269,8 @@ def main(output_directory):
           DispatchWriter('dispatch.h'),
           ReprWriter('repr.h'),
           ParseWriter('parse.h'),
+          SpliceWriter('splice.h'),
+          ColumnarWriter('columnar.h'),
           AssignWriter('assign.h'),
           AppendWriter('append.h'),
           WhereWriter('where.h'),
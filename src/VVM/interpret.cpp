@@ -8,15 +8,34 @@
  *
  */
 
+#include <chrono>
 #include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdio>
 #include <numeric>
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
+
+#include <sys/stat.h>
 
 #include <VVM/vvm.hpp>
 #include <VVM/utils/timestamp.hpp>
 #include <VVM/utils/conversion.hpp>
+#include <VVM/utils/csv_infer.hpp>
+#include <VVM/utils/csv_index.hpp>
+#include <VVM/utils/columnar.hpp>
+#include <VVM/utils/arrow.hpp>
+#include <VVM/utils/gzip.hpp>
+#include <VVM/utils/load_cache.hpp>
+#include <VVM/utils/compression.hpp>
+#include <VVM/utils/column_view.hpp>
+#include <VVM/utils/file_pattern.hpp>
 #include <VVM/utils/terminal.hpp>
+#include <VVM/utils/parallel.hpp>
+#include <VVM/utils/simd.hpp>
+#include <VVM/utils/validity.hpp>
 
 #include <csvmonkey/csvmonkey.hpp>
 
@@ -24,6 +43,12 @@
 #undef max
 #endif
 
+// libstdc++ packs std::vector<bool> into 64-bit words that its iterators
+// expose, so Bool columns can be read and written a word at a time
+#if defined(__GLIBCXX__) && __SIZEOF_LONG__ == 8
+#define VVM_BOOL_WORDS
+#endif
+
 namespace VVM {
 /*
  * The interpreter executes instructions and maintains registers.
@@ -98,9 +123,10 @@ class Interpreter {
     return reinterpret_cast<T**>(&bank[idx]);
   }
 
-  // get a reference to a register's value
+  // get a reference to a register's value, leaving mapped columns as-is;
+  // the caller must only read those columns through a view
   template<class T>
-  T& get_reference(operand_t op) {
+  T& get_lazy_reference(operand_t op) {
     T*& ptr = *get_register<T>(op);
     if (ptr == nullptr) {
       ptr = new T;
@@ -108,6 +134,21 @@ class Interpreter {
     return *ptr;
   }
 
+  // get a reference to a register's value; mapped columns are copied into
+  // their vectors first since the caller may modify them (and so they are no
+  // longer known to be nil-free, nor to match a validity bitmap)
+  template<class T>
+  T& get_reference(operand_t op) {
+    T& x = get_lazy_reference<T>(op);
+    if (!mapped_columns_.empty()) {
+      materialize(x);
+    }
+    if (!nil_free_columns_.empty() || !validity_columns_.empty()) {
+      forget_nil_free(x);
+    }
+    return x;
+  }
+
   // get scalar value, either from register or from immediate
   template<class T>
   typename std::enable_if<std::is_integral<T>::value, T>::type
@@ -129,12 +170,551 @@ class Interpreter {
   // a Dataframe is just an array of columns whose type is defined separately
   typedef std::vector<Value> Dataframe;
 
+  // a column whose values are still only in a mapped file; its vector is
+  // left empty until something needs to modify (or own) the values
+  struct MappedColumn {
+    vvm_types typee;
+    const char* begin;
+    const char* end;
+    size_t nrows;
+    std::string filename;
+  };
+  std::unordered_map<Value, MappedColumn> mapped_columns_;
+
+  // mapped files stay open for the life of the interpreter, so a view stays
+  // valid even after its column has been copied out
+  std::vector<std::shared_ptr<csvmonkey::MappedFileCursor>> mapped_files_;
+
+  // copy a mapped column into its vector
+  void materialize_value(Value v) {
+    auto iter = mapped_columns_.find(v);
+    if (iter != mapped_columns_.end()) {
+      MappedColumn& mc = iter->second;
+      read_column(mc.typee, mc.begin, mc.end, mc.nrows, v);
+      mapped_columns_.erase(iter);
+    }
+  }
+
+  // only vectors and Dataframes can have mapped columns
+  template<class T>
+  void materialize(T& x) {
+  }
+
+  template<class T>
+  void materialize(std::vector<T>& xs) {
+    materialize_value(&xs);
+  }
+
+  void materialize(Dataframe& df) {
+    for (Value v: df) {
+      materialize_value(v);
+    }
+  }
+
+  // forget a column that is about to be released
+  void unmap_value(Value v) {
+    if (!mapped_columns_.empty()) {
+      mapped_columns_.erase(v);
+    }
+  }
+
+  // have a column share another's mapping (if any)
+  void share_mapping(Value src, Value dst) {
+    unmap_value(dst);
+    auto iter = mapped_columns_.find(src);
+    if (iter != mapped_columns_.end()) {
+      mapped_columns_.emplace(dst, MappedColumn(iter->second));
+    }
+  }
+
+  // integer columns that are known to have no nil, so arithmetic on them can
+  // skip the nil check; a column is dropped from here whenever it may change
+  std::unordered_set<Value> nil_free_columns_;
+
+  // columns that idx has handed out a pointer into; an element can then be
+  // written without the column being looked-up, so they are never marked
+  std::unordered_set<Value> pinned_columns_;
+
+  // mark a column as having no nil, unless an element may change behind it
+  void mark_nil_free(Value v) {
+    if (pinned_columns_.empty() || pinned_columns_.count(v) == 0) {
+      nil_free_columns_.insert(v);
+    }
+  }
+
+  // forget a column's pin once the column itself is released
+  void unpin_value(Value v) {
+    if (!pinned_columns_.empty()) {
+      pinned_columns_.erase(v);
+    }
+  }
+
+  // whether a column is known to have no nil
+  bool is_nil_free_value(Value v) {
+    return !nil_free_columns_.empty() && nil_free_columns_.count(v) != 0;
+  }
+
+  bool is_nil_free(operand_t op) {
+    return is_nil_free_value(*get_register<void>(op));
+  }
+
+  // record that a column which was just written has no nil; only integers
+  // are tracked since only they check for nil element by element
+  template<class T>
+  void note_nil_free(std::vector<T>& xs, bool nil_free) {
+    if (is_int<T>::value && nil_free) {
+      mark_nil_free(&xs);
+    }
+  }
+
+  // forget a column that is about to be modified or released, along with
+  // its validity bitmap
+  void forget_nil_free_value(Value v) {
+    if (!nil_free_columns_.empty()) {
+      nil_free_columns_.erase(v);
+    }
+    if (!validity_columns_.empty()) {
+      validity_columns_.erase(v);
+    }
+  }
+
+  // only vectors and Dataframes have columns
+  template<class T>
+  void forget_nil_free(T& x) {
+  }
+
+  template<class T>
+  void forget_nil_free(std::vector<T>& xs) {
+    forget_nil_free_value(&xs);
+  }
+
+  void forget_nil_free(Dataframe& df) {
+    for (Value v: df) {
+      forget_nil_free_value(v);
+    }
+  }
+
+  // have a column share another's nil-free mark and validity bitmap (if any)
+  void share_nil_free(Value src, Value dst) {
+    if (src == dst) {
+      return;
+    }
+    forget_nil_free_value(dst);
+    if (is_nil_free_value(src)) {
+      mark_nil_free(dst);
+    }
+    const Validity* validity = find_validity(src);
+    if (validity != nullptr) {
+      mark_validity(dst, *validity);
+    }
+  }
+
+  // columns with missing rows that are also marked by a validity bitmap (see
+  // validity.hpp); like nil-free marks, a bitmap is dropped whenever its
+  // column may change, so an integer's bitmap always matches its nils
+  std::unordered_map<Value, Validity> validity_columns_;
+
+  // record a column's bitmap, unless an element may change behind it; an
+  // empty bitmap means that no row is missing, which isn't worth keeping
+  void mark_validity(Value v, Validity validity) {
+    if (!validity.empty() &&
+        (pinned_columns_.empty() || pinned_columns_.count(v) == 0)) {
+      validity_columns_[v] = std::move(validity);
+    }
+  }
+
+  // get a column's bitmap, which is null if there isn't one
+  const Validity* find_validity(Value v) {
+    if (validity_columns_.empty()) {
+      return nullptr;
+    }
+    auto iter = validity_columns_.find(v);
+    return (iter != validity_columns_.end()) ? &iter->second : nullptr;
+  }
+
+  const Validity* get_validity(operand_t op) {
+    return find_validity(*get_register<void>(op));
+  }
+
+  // get read-only access to a column, which may still be mapped
+  template<class T>
+  typename std::enable_if<!std::is_same<T, bool>::value, ColumnView<T>>::type
+  view_value(Value v) {
+    if (!mapped_columns_.empty()) {
+      auto iter = mapped_columns_.find(v);
+      if (iter != mapped_columns_.end()) {
+        const T* data = reinterpret_cast<const T*>(iter->second.begin);
+        return ColumnView<T>(data, iter->second.nrows);
+      }
+    }
+    return ColumnView<T>(*reinterpret_cast<std::vector<T>*>(v));
+  }
+
+  // booleans are never mapped
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, ColumnView<T>>::type
+  view_value(Value v) {
+    return ColumnView<T>(*reinterpret_cast<std::vector<T>*>(v));
+  }
+
+  // get read-only access to a vector register
+  template<class T>
+  ColumnView<T> get_view(operand_t op) {
+    return view_value<T>(&get_lazy_reference<std::vector<T>>(op));
+  }
+
   // Empirical's eval() wants a string of the user's last expression
   std::string saved_string_;
 
   /*** MATH ***/
 
-#define BINOP_SS(NAME, OP)  template<class T, class U, class V>\
+  // the time types just wrap a 64-bit integer, nil included
+  template<class T>
+  using is_int64_type = std::integral_constant<bool,
+    std::is_same<T, int64_t>::value || is_datetime<T>::value>;
+
+  // arithmetic is vectorized when the operands and result are all 64-bit
+  // integers or all floats
+  template<class T, class U, class V>
+  using is_simd_type = std::integral_constant<bool,
+    (is_int64_type<T>::value && is_int64_type<U>::value &&
+     is_int64_type<V>::value) ||
+    (std::is_same<T, double>::value && std::is_same<U, double>::value &&
+     std::is_same<V, double>::value)>;
+
+  // comparisons are vectorized for operands of the same such type
+  template<class T, class U, class V>
+  using is_simd_compare = std::integral_constant<bool,
+    std::is_same<T, U>::value && std::is_same<V, bool>::value &&
+    (is_int64_type<T>::value || std::is_same<T, double>::value)>;
+
+  // the raw values that a vectorized operand holds
+  template<class T>
+  using simd_base = typename std::conditional<std::is_same<T, double>::value,
+                                              double, int64_t>::type;
+
+  template<class T>
+  static const simd_base<T>* simd_data(const T& x) {
+    return reinterpret_cast<const simd_base<T>*>(&x);
+  }
+
+  template<class T>
+  static const simd_base<T>* simd_data(const ColumnView<T>& xs) {
+    return reinterpret_cast<const simd_base<T>*>(xs.begin());
+  }
+
+  // these return false if the loop must compute the result instead; given
+  // whether the operands are nil-free, they set whether the result is too
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_simd_type<T, U, V>::value, bool>::type
+  vector_binop(SimdOp op, const X& x, bool x_scalar, const Y& y, bool y_scalar,
+               std::vector<V>& zs, bool& nil_free) {
+    return simd_binop(op, simd_data<T>(x), x_scalar, simd_data<U>(y),
+                      y_scalar, reinterpret_cast<simd_base<V>*>(zs.data()),
+                      zs.size(), nil_free);
+  }
+
+  // a comparison writes a byte mask a block at a time, so that it stays in
+  // cache, and packs each block into the Bool column
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_simd_compare<T, U, V>::value, bool>::type
+  vector_binop(SimdOp op, const X& x, bool x_scalar, const Y& y, bool y_scalar,
+               std::vector<bool>& zs, bool& nil_free) {
+    static const size_t block_size = 4096;
+    uint8_t mask[block_size];
+    const simd_base<T>* xs = simd_data<T>(x);
+    const simd_base<U>* ys = simd_data<U>(y);
+    for (size_t i = 0; i < zs.size(); i += block_size) {
+      size_t m = std::min(zs.size() - i, block_size);
+      if (!compare_block(op, x_scalar ? xs : xs + i, x_scalar,
+                         y_scalar ? ys : ys + i, y_scalar, mask, m,
+                         nil_free)) {
+        return false;
+      }
+#ifdef VVM_BOOL_WORDS
+      simd_pack(mask, m, bool_words(zs) + i / 64);
+#else
+      std::copy(mask, mask + m, zs.begin() + i);
+#endif
+    }
+    return true;
+  }
+
+  static bool compare_block(SimdOp op, const int64_t* xs, bool x_scalar,
+                            const int64_t* ys, bool y_scalar, uint8_t* mask,
+                            size_t n, bool nil_free) {
+    return simd_compare(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+  }
+
+  static bool compare_block(SimdOp op, const double* xs, bool x_scalar,
+                            const double* ys, bool y_scalar, uint8_t* mask,
+                            size_t n, bool) {
+    return simd_compare(op, xs, x_scalar, ys, y_scalar, mask, n);
+  }
+
+#ifdef VVM_BOOL_WORDS
+  template<class T, class U, class V>
+  using is_simd_logical = std::integral_constant<bool,
+    std::is_same<T, bool>::value && std::is_same<U, bool>::value &&
+    std::is_same<V, bool>::value>;
+
+  // the words of a Bool column, or of a single Bool repeated
+  static uint64_t* bool_words(std::vector<bool>& xs) {
+    return reinterpret_cast<uint64_t*>(xs.begin()._M_p);
+  }
+
+  static const int64_t* bool_words(const ColumnView<bool>& xs, int64_t&) {
+    return reinterpret_cast<const int64_t*>(xs.begin()._M_p);
+  }
+
+  static const int64_t* bool_words(bool x, int64_t& word) {
+    word = x ? -1 : 0;
+    return &word;
+  }
+
+  // "and" and "or" of Bool columns are bitwise operations on their words,
+  // none of which can be nil
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_simd_logical<T, U, V>::value, bool>::type
+  vector_binop(SimdOp op, const X& x, bool x_scalar, const Y& y, bool y_scalar,
+               std::vector<bool>& zs, bool&) {
+    int64_t x_word, y_word;
+    bool nil_free = true;
+    return simd_binop(op, bool_words(x, x_word), x_scalar,
+                      bool_words(y, y_word), y_scalar,
+                      reinterpret_cast<int64_t*>(bool_words(zs)),
+                      (zs.size() + 63) / 64, nil_free);
+  }
+#else
+  template<class T, class U, class V>
+  using is_simd_logical = std::false_type;
+#endif  // VVM_BOOL_WORDS
+
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<!is_simd_type<T, U, V>::value &&
+                          !is_simd_compare<T, U, V>::value &&
+                          !is_simd_logical<T, U, V>::value, bool>::type
+  vector_binop(SimdOp, const X&, bool, const Y&, bool, std::vector<V>&,
+               bool&) {
+    return false;
+  }
+
+  template<class T, class U>
+  typename std::enable_if<is_simd_type<T, T, U>::value, bool>::type
+  vector_unop(SimdOp op, const ColumnView<T>& xs, std::vector<U>& ys,
+              bool& nil_free) {
+    return simd_unop(op, simd_data<T>(xs),
+                     reinterpret_cast<simd_base<U>*>(ys.data()), ys.size(),
+                     nil_free);
+  }
+
+  template<class T, class U>
+  typename std::enable_if<!is_simd_type<T, T, U>::value, bool>::type
+  vector_unop(SimdOp, const ColumnView<T>&, std::vector<U>&, bool&) {
+    return false;
+  }
+
+  // compute each element of a column; returns whether it has no integer nil
+  template<class V, class F>
+  bool fill_column(std::vector<V>& zs, F f) {
+    bool has_nil = false;
+    for (size_t i = 0; i < zs.size(); i++) {
+      zs[i] = f(i);
+      has_nil |= is_int<V>::value && is_int_nil(zs[i]);
+    }
+    return !has_nil;
+  }
+
+  /*
+   * Operands with a validity bitmap skip the nil check: their bitmaps are
+   * combined a word at a time and the kernel runs unchecked, then the missing
+   * rows are set back to nil. Every vector operand must either have a bitmap
+   * or be nil-free, and a single value mustn't be nil. Comparisons and Bool
+   * operations only carry the combined bitmap to their result, since their
+   * values are already what they have always been.
+   */
+
+  // integer operations that the kernels can run without a nil check
+  static bool is_unchecked_op(SimdOp op) {
+    return op == SimdOp::kAdd || op == SimdOp::kSub || op == SimdOp::kMul ||
+           op == SimdOp::kBitAnd || op == SimdOp::kBitOr;
+  }
+
+  template<class T, class U, class V>
+  using is_nullable_arith = std::integral_constant<bool,
+    is_simd_type<T, U, V>::value && is_int64_type<V>::value>;
+
+  template<class T, class U, class V>
+  using is_nullable_compare = std::integral_constant<bool,
+    is_simd_compare<T, U, V>::value && is_int64_type<T>::value>;
+
+  // the bitmap of an operand that has none, which means every row is valid
+  static const Validity& all_valid() {
+    static const Validity none;
+    return none;
+  }
+
+  template<class X>
+  static bool is_nil_operand(const X& x) {
+    return is_int_nil(x);
+  }
+
+  template<class T>
+  static bool is_nil_operand(const ColumnView<T>&) {
+    return false;
+  }
+
+  // find the bitmaps of an operation's operands; returns false unless one has
+  // a bitmap and the rest can be combined with it (a Bool has no nil, so its
+  // column is always valid without one)
+  template<class X, class Y>
+  bool operand_validity(const X& x, operand_t left, bool x_scalar, const Y& y,
+                        operand_t right, bool y_scalar, bool has_nil,
+                        const Validity*& vx, const Validity*& vy) {
+    if (validity_columns_.empty()) {
+      return false;
+    }
+    vx = x_scalar ? nullptr : get_validity(left);
+    vy = y_scalar ? nullptr : get_validity(right);
+    if (vx == nullptr && vy == nullptr) {
+      return false;
+    }
+    bool x_ok = x_scalar ? !is_nil_operand(x)
+                         : vx != nullptr || !has_nil || is_nil_free(left);
+    bool y_ok = y_scalar ? !is_nil_operand(y)
+                         : vy != nullptr || !has_nil || is_nil_free(right);
+    if (!x_ok || !y_ok) {
+      return false;
+    }
+    vx = (vx != nullptr) ? vx : &all_valid();
+    vy = (vy != nullptr) ? vy : &all_valid();
+    return true;
+  }
+
+  // these return whether the result has a bitmap, which is then set along
+  // with whether the kernel may skip the nil check
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_nullable_arith<T, U, V>::value, bool>::type
+  nullable_binop(SimdOp op, const X& x, operand_t left, bool x_scalar,
+                 const Y& y, operand_t right, bool y_scalar, size_t n,
+                 Validity& validity, bool& nil_free) {
+    const Validity* vx;
+    const Validity* vy;
+    if (!is_unchecked_op(op) || !operand_validity(x, left, x_scalar, y, right,
+                                                  y_scalar, true, vx, vy)) {
+      return false;
+    }
+    validity = combine_validity(*vx, *vy);
+    nil_free = true;
+    return true;
+  }
+
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_nullable_compare<T, U, V>::value, bool>::type
+  nullable_binop(SimdOp op, const X& x, operand_t left, bool x_scalar,
+                 const Y& y, operand_t right, bool y_scalar, size_t n,
+                 Validity& validity, bool& nil_free) {
+    const Validity* vx;
+    const Validity* vy;
+    if (!operand_validity(x, left, x_scalar, y, right, y_scalar, true, vx,
+                          vy)) {
+      return false;
+    }
+    validity = combine_validity(*vx, *vy);
+    return true;
+  }
+
+#ifdef VVM_BOOL_WORDS
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<is_simd_logical<T, U, V>::value, bool>::type
+  nullable_binop(SimdOp op, const X& x, operand_t left, bool x_scalar,
+                 const Y& y, operand_t right, bool y_scalar, size_t n,
+                 Validity& validity, bool& nil_free) {
+    const Validity* vx;
+    const Validity* vy;
+    if (!operand_validity(x, left, x_scalar, y, right, y_scalar, false, vx,
+                          vy)) {
+      return false;
+    }
+    int64_t x_word, y_word;
+    validity = logical_validity(
+      op == SimdOp::kBitAnd,
+      reinterpret_cast<const uint64_t*>(bool_words(x, x_word)), x_scalar, *vx,
+      reinterpret_cast<const uint64_t*>(bool_words(y, y_word)), y_scalar, *vy,
+      n);
+    return true;
+  }
+#endif  // VVM_BOOL_WORDS
+
+  template<class T, class U, class V, class X, class Y>
+  typename std::enable_if<!is_nullable_arith<T, U, V>::value &&
+                          !is_nullable_compare<T, U, V>::value &&
+                          !is_simd_logical<T, U, V>::value, bool>::type
+  nullable_binop(SimdOp, const X&, operand_t, bool, const Y&, operand_t, bool,
+                 size_t, Validity&, bool&) {
+    return false;
+  }
+
+  // negation runs unchecked, while "not" of a Bool keeps its bitmap as-is
+  template<class T, class U>
+  typename std::enable_if<is_nullable_arith<T, T, U>::value, bool>::type
+  nullable_unop(SimdOp op, operand_t left, Validity& validity,
+                bool& nil_free) {
+    const Validity* vx = get_validity(left);
+    if (op != SimdOp::kNeg || vx == nullptr) {
+      return false;
+    }
+    validity = *vx;
+    nil_free = true;
+    return true;
+  }
+
+  template<class T, class U>
+  typename std::enable_if<std::is_same<T, bool>::value &&
+                          std::is_same<U, bool>::value, bool>::type
+  nullable_unop(SimdOp op, operand_t left, Validity& validity,
+                bool& nil_free) {
+    const Validity* vx = get_validity(left);
+    if (vx == nullptr) {
+      return false;
+    }
+    validity = *vx;
+    return true;
+  }
+
+  template<class T, class U>
+  typename std::enable_if<!is_nullable_arith<T, T, U>::value &&
+                          !(std::is_same<T, bool>::value &&
+                            std::is_same<U, bool>::value), bool>::type
+  nullable_unop(SimdOp, operand_t, Validity&, bool&) {
+    return false;
+  }
+
+  // set an integer result's missing rows to nil; its bitmap is only kept if
+  // every other row has a value, since then the two still match
+  template<class V>
+  typename std::enable_if<is_int64_type<V>::value, void>::type
+  note_validity(std::vector<V>& zs, Validity& validity, bool& nil_free) {
+    apply_validity(validity, zs.data(), zs.size());
+    if (nil_free) {
+      mark_validity(&zs, std::move(validity));
+    }
+    nil_free = false;
+  }
+
+  template<class V>
+  typename std::enable_if<std::is_same<V, bool>::value, void>::type
+  note_validity(std::vector<V>& zs, Validity& validity, bool&) {
+    mark_validity(&zs, std::move(validity));
+  }
+
+  template<class V>
+  typename std::enable_if<!is_int64_type<V>::value &&
+                          !std::is_same<V, bool>::value, void>::type
+  note_validity(std::vector<V>&, Validity&, bool&) {
+  }
+
+#define BINOP_SS(NAME, OP, SIMD)  template<class T, class U, class V>\
   void NAME##_ss(operand_t left, operand_t right, operand_t result) {\
     T x = get_value<T>(left);\
     U y = get_value<U>(right);\
@@ -142,61 +722,102 @@ class Interpreter {
     z = (is_int_nil(x) || is_int_nil(y)) ? nil_value<V>() : x OP y;\
   }\
 
-#define BINOP_SV(NAME, OP)  template<class T, class U, class V>\
+#define BINOP_SV(NAME, OP, SIMD)  template<class T, class U, class V>\
   void NAME##_sv(operand_t left, operand_t right, operand_t result) {\
     T x = get_value<T>(left);\
-    std::vector<U>& ys = get_reference<std::vector<U>>(right);\
+    ColumnView<U> ys = get_view<U>(right);\
+    bool nil_free = !is_int_nil(x) && is_nil_free(right);\
+    Validity validity;\
+    bool nullable = nullable_binop<T, U, V>(SimdOp::SIMD, x, left, true,\
+                                            ys, right, false, ys.size(),\
+                                            validity, nil_free);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(ys.size());\
-    for (size_t i = 0; i < ys.size(); i++) {\
-      zs[i] = (is_int_nil(x) || is_int_nil(ys[i])) ? nil_value<V>() : x OP ys[i];\
+    if (!vector_binop<T, U, V>(SimdOp::SIMD, x, true, ys, false, zs, nil_free)) {\
+      nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+        return x OP ys[i];\
+      }) : fill_column(zs, [&](size_t i) {\
+        return (is_int_nil(x) || is_int_nil(ys[i])) ? nil_value<V>() : x OP ys[i];\
+      });\
+    }\
+    if (nullable) {\
+      note_validity(zs, validity, nil_free);\
     }\
+    note_nil_free(zs, nil_free);\
   }\
 
-#define BINOP_VS(NAME, OP)  template<class T, class U, class V>\
+#define BINOP_VS(NAME, OP, SIMD)  template<class T, class U, class V>\
   void NAME##_vs(operand_t left, operand_t right, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
+    ColumnView<T> xs = get_view<T>(left);\
     U y = get_value<U>(right);\
+    bool nil_free = is_nil_free(left) && !is_int_nil(y);\
+    Validity validity;\
+    bool nullable = nullable_binop<T, U, V>(SimdOp::SIMD, xs, left, false,\
+                                            y, right, true, xs.size(),\
+                                            validity, nil_free);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(xs.size());\
-    for (size_t i = 0; i < xs.size(); i++) {\
-      zs[i] = (is_int_nil(xs[i]) || is_int_nil(y)) ? nil_value<V>() : xs[i] OP y;\
+    if (!vector_binop<T, U, V>(SimdOp::SIMD, xs, false, y, true, zs, nil_free)) {\
+      nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+        return xs[i] OP y;\
+      }) : fill_column(zs, [&](size_t i) {\
+        return (is_int_nil(xs[i]) || is_int_nil(y)) ? nil_value<V>() : xs[i] OP y;\
+      });\
     }\
+    if (nullable) {\
+      note_validity(zs, validity, nil_free);\
+    }\
+    note_nil_free(zs, nil_free);\
   }\
 
-#define BINOP_VV(NAME, OP)  template<class T, class U, class V>\
+#define BINOP_VV(NAME, OP, SIMD)  template<class T, class U, class V>\
   void NAME##_vv(operand_t left, operand_t right, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
-    std::vector<U>& ys = get_reference<std::vector<U>>(right);\
+    ColumnView<T> xs = get_view<T>(left);\
+    ColumnView<U> ys = get_view<U>(right);\
     if (xs.size() != ys.size()) {\
       throw std::runtime_error("Mismatch array lengths");\
     }\
+    bool nil_free = is_nil_free(left) && is_nil_free(right);\
+    Validity validity;\
+    bool nullable = nullable_binop<T, U, V>(SimdOp::SIMD, xs, left, false,\
+                                            ys, right, false, xs.size(),\
+                                            validity, nil_free);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(xs.size());\
-    for (size_t i = 0; i < xs.size(); i++) {\
-      zs[i] = (is_int_nil(xs[i]) || is_int_nil(ys[i])) ? nil_value<V>() : xs[i] OP ys[i];\
+    if (!vector_binop<T, U, V>(SimdOp::SIMD, xs, false, ys, false, zs, nil_free)) {\
+      nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+        return xs[i] OP ys[i];\
+      }) : fill_column(zs, [&](size_t i) {\
+        return (is_int_nil(xs[i]) || is_int_nil(ys[i])) ? nil_value<V>() : xs[i] OP ys[i];\
+      });\
+    }\
+    if (nullable) {\
+      note_validity(zs, validity, nil_free);\
     }\
+    note_nil_free(zs, nil_free);\
   }\
 
-#define BINOP(NAME, OP) BINOP_SS(NAME, OP) BINOP_SV(NAME, OP)\
-                        BINOP_VS(NAME, OP) BINOP_VV(NAME, OP)
-
-BINOP(add,+)
-BINOP(sub,-)
-BINOP(mul,*)
-BINOP(div,/)
-BINOP(lt,<)
-BINOP(gt,>)
-BINOP(eq,==)
-BINOP(ne,!=)
-BINOP(lte,<=)
-BINOP(gte,>=)
-BINOP(and,&&)
-BINOP(or,||)
-BINOP(bitand,&)
-BINOP(bitor,|)
-BINOP(lshift,<<)
-BINOP(rshift,>>)
+#define BINOP(NAME, OP, SIMD) BINOP_SS(NAME, OP, SIMD)\
+                              BINOP_SV(NAME, OP, SIMD)\
+                              BINOP_VS(NAME, OP, SIMD)\
+                              BINOP_VV(NAME, OP, SIMD)
+
+BINOP(add,+,kAdd)
+BINOP(sub,-,kSub)
+BINOP(mul,*,kMul)
+BINOP(div,/,kDiv)
+BINOP(lt,<,kLt)
+BINOP(gt,>,kGt)
+BINOP(eq,==,kEq)
+BINOP(ne,!=,kNe)
+BINOP(lte,<=,kLte)
+BINOP(gte,>=,kGte)
+BINOP(and,&&,kBitAnd)
+BINOP(or,||,kBitOr)
+BINOP(bitand,&,kBitAnd)
+BINOP(bitor,|,kBitOr)
+BINOP(lshift,<<,kNone)
+BINOP(rshift,>>,kNone)
 
 #undef BINOP
 #undef BINOP_VV
@@ -220,37 +841,49 @@ T bar(T x, U y) {
 #define BINFUNC_SV(NAME, F)  template<class T, class U, class V>\
   void NAME##_sv(operand_t left, operand_t right, operand_t result) {\
     T x = get_value<T>(left);\
-    std::vector<U>& ys = get_reference<std::vector<U>>(right);\
+    ColumnView<U> ys = get_view<U>(right);\
+    bool nil_free = !is_int_nil(x) && is_nil_free(right);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(ys.size());\
-    for (size_t i = 0; i < ys.size(); i++) {\
-      zs[i] = (is_int_nil(x) || is_int_nil(ys[i])) ? nil_value<V>() : F(x, ys[i]);\
-    }\
+    nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+      return F(x, ys[i]);\
+    }) : fill_column(zs, [&](size_t i) {\
+      return (is_int_nil(x) || is_int_nil(ys[i])) ? nil_value<V>() : F(x, ys[i]);\
+    });\
+    note_nil_free(zs, nil_free);\
   }\
 
 #define BINFUNC_VS(NAME, F)  template<class T, class U, class V>\
   void NAME##_vs(operand_t left, operand_t right, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
+    ColumnView<T> xs = get_view<T>(left);\
     U y = get_value<U>(right);\
+    bool nil_free = is_nil_free(left) && !is_int_nil(y);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(xs.size());\
-    for (size_t i = 0; i < xs.size(); i++) {\
-      zs[i] = (is_int_nil(xs[i]) || is_int_nil(y)) ? nil_value<V>() : F(xs[i], y);\
-    }\
+    nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+      return F(xs[i], y);\
+    }) : fill_column(zs, [&](size_t i) {\
+      return (is_int_nil(xs[i]) || is_int_nil(y)) ? nil_value<V>() : F(xs[i], y);\
+    });\
+    note_nil_free(zs, nil_free);\
   }\
 
 #define BINFUNC_VV(NAME, F)  template<class T, class U, class V>\
   void NAME##_vv(operand_t left, operand_t right, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
-    std::vector<U>& ys = get_reference<std::vector<U>>(right);\
+    ColumnView<T> xs = get_view<T>(left);\
+    ColumnView<U> ys = get_view<U>(right);\
     if (xs.size() != ys.size()) {\
       throw std::runtime_error("Mismatch array lengths");\
     }\
+    bool nil_free = is_nil_free(left) && is_nil_free(right);\
     std::vector<V>& zs = get_reference<std::vector<V>>(result);\
     zs.resize(xs.size());\
-    for (size_t i = 0; i < xs.size(); i++) {\
-      zs[i] = (is_int_nil(xs[i]) || is_int_nil(ys[i])) ? nil_value<V>() : F(xs[i], ys[i]);\
-    }\
+    nil_free = nil_free ? fill_column(zs, [&](size_t i) {\
+      return F(xs[i], ys[i]);\
+    }) : fill_column(zs, [&](size_t i) {\
+      return (is_int_nil(xs[i]) || is_int_nil(ys[i])) ? nil_value<V>() : F(xs[i], ys[i]);\
+    });\
+    note_nil_free(zs, nil_free);\
   }\
 
 #define BINFUNC(NAME, F) BINFUNC_SS(NAME, F) BINFUNC_SV(NAME, F)\
@@ -264,33 +897,240 @@ BINFUNC(bar,bar)
 #undef BINFUNC_SV
 #undef BINFUNC_SS
 
-#define UNOP_S(NAME, OP)  template<class T, class U>\
+#define UNOP_S(NAME, OP, SIMD)  template<class T, class U>\
   void NAME##_s(operand_t left, operand_t result) {\
     T x = get_value<T>(left);\
     U& y = get_reference<T>(result);\
     y = is_int_nil(x) ? nil_value<U>() : OP(x);\
   }\
 
-#define UNOP_V(NAME, OP)  template<class T, class U>\
+#define UNOP_V(NAME, OP, SIMD)  template<class T, class U>\
   void NAME##_v(operand_t left, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
+    ColumnView<T> xs = get_view<T>(left);\
+    bool nil_free = is_nil_free(left);\
+    Validity validity;\
+    bool nullable = nullable_unop<T, U>(SimdOp::SIMD, left, validity,\
+                                        nil_free);\
     std::vector<U>& ys = get_reference<std::vector<U>>(result);\
     ys.resize(xs.size());\
-    for (size_t i = 0; i < xs.size(); i++) {\
-      ys[i] = is_int_nil(xs[i]) ? nil_value<U>() : OP(xs[i]);\
+    if (!vector_unop(SimdOp::SIMD, xs, ys, nil_free)) {\
+      nil_free = nil_free ? fill_column(ys, [&](size_t i) {\
+        return OP(xs[i]);\
+      }) : fill_column(ys, [&](size_t i) {\
+        return is_int_nil(xs[i]) ? nil_value<U>() : OP(xs[i]);\
+      });\
+    }\
+    if (nullable) {\
+      note_validity(ys, validity, nil_free);\
     }\
+    note_nil_free(ys, nil_free);\
   }\
 
-#define UNOP(NAME, OP) UNOP_S(NAME, OP) UNOP_V(NAME, OP)
+#define UNOP(NAME, OP, SIMD) UNOP_S(NAME, OP, SIMD) UNOP_V(NAME, OP, SIMD)
 
-UNOP(neg,-)
-UNOP(pos,+)
-UNOP(not,!)
+UNOP(neg,-,kNeg)
+UNOP(pos,+,kNone)
+UNOP(not,!,kNone)
 
 #undef UNOP
 #undef UNOP_V
 #undef UNOP_S
 
+  /*
+   * A 'fuse' instruction marks the elementwise instructions that follow it as
+   * one expression. Rather than run each instruction over the whole column,
+   * the expression is evaluated in tiles that fit in cache. Only the last
+   * instruction's result is stored; the intermediate registers are left unset
+   * since the code generator only fuses temporaries.
+   */
+
+  // number of elements evaluated at a time
+  static const size_t fused_tile_size = 1024;
+
+  // an operand of a fused instruction
+  template<class T>
+  struct FusedArg {
+    const T* data = nullptr;    // column from a register
+    bool scalar = false;
+    T value = T();
+    size_t step = size_t(-1);   // earlier instruction whose result this is
+    bool nil_free = false;      // whether a column or value has no nil
+  };
+
+  struct FusedStep {
+    FusedOpcode info;
+    const operand_t* operands;
+  };
+
+  // one element of a fused instruction, for when the operation has no
+  // vectorized form; a unary operation ignores its second operand
+  static int64_t fused_element(SimdOp op, int64_t x, int64_t y) {
+    if (is_int_nil(x) || (op != SimdOp::kNeg && is_int_nil(y))) {
+      return nil_value<int64_t>();
+    }
+    switch (op) {
+      case SimdOp::kAdd: return x + y;
+      case SimdOp::kSub: return x - y;
+      case SimdOp::kMul: return x * y;
+      case SimdOp::kBitAnd: return x & y;
+      case SimdOp::kBitOr: return x | y;
+      case SimdOp::kNeg: return -x;
+      default: throw std::logic_error("Instruction cannot be fused");
+    }
+  }
+
+  static double fused_element(SimdOp op, double x, double y) {
+    switch (op) {
+      case SimdOp::kAdd: return x + y;
+      case SimdOp::kSub: return x - y;
+      case SimdOp::kMul: return x * y;
+      case SimdOp::kDiv: return x / y;
+      case SimdOp::kNeg: return -x;
+      default: throw std::logic_error("Instruction cannot be fused");
+    }
+  }
+
+  template<class T>
+  void fuse_steps(const std::vector<FusedStep>& steps) {
+    // the result is taken first in case it is also a (mapped) operand
+    const FusedStep& last = steps.back();
+    operand_t result = last.operands[last.info.arity - 1];
+    std::vector<T>& zs = get_reference<std::vector<T>>(result);
+
+    // the last instruction gives the result; earlier ones each get a tile
+    std::unordered_map<operand_t, size_t> results;
+    std::vector<std::vector<FusedArg<T>>> args(steps.size());
+    std::vector<ColumnView<T>> views;
+    for (size_t i = 0; i < steps.size(); i++) {
+      const FusedStep& step = steps[i];
+      size_t nargs = step.info.arity - 1;
+      args[i].resize(nargs);
+      for (size_t j = 0; j < nargs; j++) {
+        operand_t op = step.operands[j];
+        bool is_vector = (j == 0) ? step.info.x_vector : step.info.y_vector;
+        FusedArg<T>& arg = args[i][j];
+        auto iter = results.find(op);
+        if (!is_vector) {
+          arg.scalar = true;
+          arg.value = get_value<T>(op);
+          arg.nil_free = !is_int_nil(arg.value);
+        }
+        else if (iter != results.end()) {
+          arg.step = iter->second;
+        }
+        else {
+          views.push_back(get_view<T>(op));
+          arg.data = views.back().begin();
+          arg.nil_free = is_nil_free(op);
+        }
+      }
+      results[step.operands[nargs]] = i;
+    }
+
+    // columns must all be the same length
+    if (views.empty()) {
+      throw std::logic_error("Fused instructions have no column operand");
+    }
+    size_t n = views[0].size();
+    for (auto& view: views) {
+      if (view.size() != n) {
+        throw std::runtime_error("Mismatch array lengths");
+      }
+    }
+
+    zs.resize(n);
+    std::vector<std::vector<T>> tiles(steps.size() - 1,
+                                      std::vector<T>(fused_tile_size));
+
+    // whether each instruction's tile has no nil; the result has none if no
+    // tile of the last instruction does
+    std::vector<char> tile_nil_free(steps.size());
+    bool nil_free = true;
+
+    for (size_t offset = 0; offset < n; offset += fused_tile_size) {
+      size_t m = (n - offset < fused_tile_size) ? n - offset
+                                                : fused_tile_size;
+      for (size_t i = 0; i < steps.size(); i++) {
+        const T* xs[2];
+        bool scalars[2] = {false, false};
+        bool nf = true;
+        for (size_t j = 0; j < args[i].size(); j++) {
+          const FusedArg<T>& arg = args[i][j];
+          nf = nf && ((arg.step != size_t(-1)) ? bool(tile_nil_free[arg.step])
+                                               : arg.nil_free);
+          if (arg.scalar) {
+            xs[j] = &arg.value;
+            scalars[j] = true;
+          }
+          else if (arg.step != size_t(-1)) {
+            xs[j] = tiles[arg.step].data();
+          }
+          else {
+            xs[j] = arg.data + offset;
+          }
+        }
+        T* dst = (i + 1 == steps.size()) ? zs.data() + offset
+                                         : tiles[i].data();
+        const SimdOp op = steps[i].info.op;
+        bool done;
+        if (args[i].size() == 1) {
+          done = simd_unop(op, xs[0], dst, m, nf);
+          scalars[1] = true;
+          xs[1] = xs[0];
+        }
+        else {
+          done = simd_binop(op, xs[0], scalars[0], xs[1], scalars[1], dst, m,
+                            nf);
+        }
+        if (!done) {
+          nf = true;
+          for (size_t k = 0; k < m; k++) {
+            dst[k] = fused_element(op, xs[0][scalars[0] ? 0 : k],
+                                   xs[1][scalars[1] ? 0 : k]);
+            nf = nf && !is_int_nil(dst[k]);
+          }
+        }
+        tile_nil_free[i] = nf;
+      }
+      nil_free = nil_free && tile_nil_free.back();
+    }
+    note_nil_free(zs, nil_free);
+  }
+
+  // fused expression
+  void fuse(operand_t count, const instructions_t& bytecode) {
+    int64_t n = get_value<int64_t>(count);
+    if (n <= 0) {
+      throw std::logic_error("Invalid instruction count for fuse");
+    }
+
+    // decode the instructions that follow
+    std::vector<FusedStep> steps(n);
+    size_t is_float = 0;
+    for (auto& step: steps) {
+      if (ip_ >= bytecode.size() ||
+          !find_fused_opcode(bytecode[ip_], step.info)) {
+        throw std::logic_error("Instruction cannot be fused");
+      }
+      if (ip_ + step.info.arity >= bytecode.size()) {
+        throw std::logic_error("Truncated fused instruction");
+      }
+      step.operands = &bytecode[ip_ + 1];
+      ip_ += step.info.arity + 1;
+      is_float += step.info.is_float;
+    }
+
+    if (is_float == 0) {
+      fuse_steps<int64_t>(steps);
+    }
+    else if (is_float == steps.size()) {
+      fuse_steps<double>(steps);
+    }
+    else {
+      throw std::logic_error("Fused instructions must share a type");
+    }
+  }
+
   // ordinarily just use the initial value...
   template<class T>
   typename std::enable_if<!std::is_same<T, std::string>::value, T>::type
@@ -307,7 +1147,7 @@ UNOP(not,!)
 
 #define REDUCE(NAME, OP, INIT)  template<class T, class U>\
   void NAME##_v(operand_t left, operand_t result) {\
-    std::vector<T>& xs = get_reference<std::vector<T>>(left);\
+    ColumnView<T> xs = get_view<T>(left);\
     U& y = get_reference<U>(result);\
     y = init_agg<U>(INIT);\
     for (auto x: xs) {\
@@ -403,21 +1243,30 @@ WRAPPER_V_S(count)
     return to_repr(x);
   }
 
-  // vector representation logic
+  // vector representation logic; a Bool has no nil of its own, so a missing
+  // row is only known from its column's validity bitmap
   template<class T>
   std::string represent_v(operand_t src) {
-    std::vector<T>& xs = get_reference<std::vector<T>>(src);
+    ColumnView<T> xs = get_view<T>(src);
+    const Validity* validity = std::is_same<T, bool>::value
+                             ? get_validity(src) : nullptr;
+    auto item = [&](size_t i) {
+      if (validity != nullptr && !is_valid(*validity, i)) {
+        return std::string("nil");
+      }
+      return to_repr(xs[i]);
+    };
     std::string ys;
     const size_t max_items = 25;
     size_t length = std::min(xs.size(), max_items);
     ys = "[";
-    if (!xs.empty()) {
-      ys += to_repr(xs[0]);
+    if (xs.size() != 0) {
+      ys += item(0);
     }
     for (size_t i = 1; i < length; i++) {
-      ys += ", " + to_repr(xs[i]);
+      ys += ", " + item(i);
     }
-    if (!xs.empty() && length < xs.size()) {
+    if (xs.size() != 0 && length < xs.size()) {
       ys += ", ...";
     }
     ys += "]";
@@ -438,9 +1287,7 @@ WRAPPER_V_S(count)
     std::vector<T>& xs = *static_cast<std::vector<T>*>(v);
     size_t length = std::min(xs.size(), max_items);
     std::vector<std::string> ys(length);
-    for (size_t i = 0; i < length; i++) {
-      ys[i] = to_string(xs[i]);
-    }
+    to_strings(xs, 0, length, ys.data());
     trim_trailing_zeros<T>(ys);
     ys.insert(ys.begin(), name);
     return ys;
@@ -456,6 +1303,52 @@ WRAPPER_V_S(count)
     return ys;
   }
 
+  // count the zeros a value's text could lose, or npos if it has no text
+  template<class T>
+  static size_t value_zeros(const T& x) {
+    std::string s = to_string(x);
+    return s.empty() ? std::string::npos : count_trailing_zeros<T>(s);
+  }
+
+  // floats are counted without being formatted, since they're formatted
+  // again once the column's trim is known
+  static size_t value_zeros(double x) {
+    return is_nil(x) ? std::string::npos : count_float64_zeros(x);
+  }
+
+  // count the zeros that every value of a column can lose, like a repr
+  template<class T>
+  size_t column_trim(Value v) {
+    std::vector<T>& xs = *static_cast<std::vector<T>*>(v);
+    size_t trim = std::string::npos;
+    for (auto x: xs) {
+      trim = std::min(trim, value_zeros(T(x)));
+      if (trim == 0) {
+        break;
+      }
+    }
+    return trim == std::string::npos ? 0 : trim;
+  }
+
+  // convert a range of a column's values into cells for a CSV file
+  template<class T>
+  void format_cells(Value v, size_t begin, size_t end, size_t trim,
+                    std::vector<std::string>& cells) {
+    std::vector<T>& xs = *static_cast<std::vector<T>*>(v);
+    cells.resize(end - begin);
+    size_t filled = std::min(end, std::max(begin, xs.size()));
+    to_strings(xs, begin, filled, cells.data());
+    for (size_t i = begin; i < end; i++) {
+      std::string& cell = cells[i - begin];
+      if (i >= filled) {
+        cell.clear();
+      }
+      else if (!cell.empty()) {
+        trim_zeros<T>(cell, trim);
+      }
+    }
+  }
+
 #include <VVM/repr.h>
 
   // pad a string with spaces to fit the desired length
@@ -498,78 +1391,2078 @@ WRAPPER_V_S(count)
         const size_t total_df_rows = len_df(cols, members);
         const size_t permitted_df_rows = std::min(max_df_rows, total_df_rows);
 
-        // avoid dotting if table is exactly the max length
-        const size_t dotted_row =
-          max_df_rows + (max_df_rows == total_df_rows ? 1 : 0);
+        // avoid dotting if table is exactly the max length
+        const size_t dotted_row =
+          max_df_rows + (max_df_rows == total_df_rows ? 1 : 0);
+
+        // convert each column to padded strings and tranpose to rows
+        std::vector<std::string> rows(permitted_df_rows + 1);
+        for (size_t col = 0; col < cols.size(); col++) {
+          // get string of each member
+          vvm_types vvm_typee =
+            static_cast<vvm_types>(members[col].typee >> 1);
+          auto results = stringify(vvm_typee, cols[col], members[col].name,
+                                   permitted_df_rows);
+
+          // get size of largest string member
+          size_t max_length = 0;
+          for (auto& r: results) {
+            max_length = std::max(max_length, r.size());
+          }
+          max_length++;
+
+          // append padded version of string members to corresponding row
+          for (size_t row = 0; row < rows.size(); row++) {
+            std::string input_str = results[row];
+            if (row == dotted_row) {
+              input_str = (max_length > 3) ? "..." : "..";
+            }
+            rows[row] += pad(input_str, max_length);
+          }
+
+          // correct if we've exceeded the max width
+          if (rows[0].size() > max_console_cols) {
+            size_t permitted_cols = max_console_cols - 3;
+            for (auto& r: rows) {
+              r = r.substr(0, permitted_cols) + "...";
+            }
+            break;
+          }
+        }
+
+        // join rows by a carriage return
+        std::string result = rows[0];
+        for (size_t row = 1; row < rows.size(); row++) {
+          result += '\n' + rows[row];
+        }
+        return result;
+      }
+    }
+  }
+
+  // repr operation
+  void repr(operand_t src, operand_t typee, operand_t dst) {
+    verify_is_type(typee);
+    std::string& y = get_reference<std::string>(dst);
+    y = represent(src, typee >> 2);
+  }
+
+  /*** LOAD ***/
+
+  // parse cells of text onto the end of an array of a given type
+  template<class T>
+  void parse_cells(std::vector<csvmonkey::CsvCell>& cells, Value arr) {
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(arr);
+    for (auto& cell: cells) {
+      if (cell.escaped) {
+        ys.push_back(from_string<T>(cell.as_str()));
+      }
+      else {
+        ys.push_back(from_string<T>(cell.ptr, cell.size));
+      }
+    }
+  }
+
+  // parse cells of text with a column's strtime format
+  template<class T>
+  void parse_times(std::vector<csvmonkey::CsvCell>& cells, Value arr,
+                   const StrtimeFormat& format) {
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(arr);
+    for (auto& cell: cells) {
+      if (cell.escaped) {
+        std::string text = cell.as_str();
+        ys.push_back(T(format.parse(text.data(), text.size())));
+      }
+      else {
+        ys.push_back(T(format.parse(cell.ptr, cell.size)));
+      }
+    }
+  }
+
+  // compare values to a constant, marking which rows to keep; the comparison
+  // has the same nil handling as the regular operators
+  template<class T>
+  void compare_values(const std::vector<T>& xs, operand_t value,
+                      Comparison cmp, std::vector<char>& keep) {
+    T y = get_value<T>(value);
+    keep.resize(xs.size());
+    for (size_t i = 0; i < xs.size(); i++) {
+      if (is_int_nil(xs[i]) || is_int_nil(y)) {
+        keep[i] = nil_value<bool>();
+        continue;
+      }
+      switch (cmp) {
+        case Comparison::kLt:  keep[i] = xs[i] < y;  break;
+        case Comparison::kGt:  keep[i] = xs[i] > y;  break;
+        case Comparison::kEq:  keep[i] = xs[i] == y; break;
+        case Comparison::kNe:  keep[i] = xs[i] != y; break;
+        case Comparison::kLte: keep[i] = xs[i] <= y; break;
+        case Comparison::kGte: keep[i] = xs[i] >= y; break;
+      }
+    }
+  }
+
+  // compare a block of cells to a value
+  template<class T>
+  void match_cells(vvm_types t, std::vector<csvmonkey::CsvCell>& cells,
+                   const StrtimeFormat& format, operand_t value,
+                   Comparison cmp, std::vector<char>& keep) {
+    std::vector<T> xs;
+    xs.reserve(cells.size());
+    parse_cells(t, cells, &xs, format);
+    compare_values(xs, value, cmp, keep);
+  }
+
+  // compare a column to a value
+  template<class T>
+  void match_values(Value src, operand_t value, Comparison cmp,
+                    std::vector<char>& keep) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    compare_values(xs, value, cmp, keep);
+  }
+
+#include <VVM/parse.h>
+
+  // move a chunk onto the end of a column and release the chunk
+  template<class T>
+  void splice_elem(Value src, Value dst, size_t capacity) {
+    std::vector<T>* xs = reinterpret_cast<std::vector<T>*>(src);
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    ys.insert(ys.end(), std::make_move_iterator(xs->begin()),
+              std::make_move_iterator(xs->end()));
+    forget_nil_free_value(dst);
+    release_elem<T>(src);
+  }
+
+  // make room for a column's expected rows
+  template<class T>
+  void reserve_elem(Value src, size_t nrows) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    xs.reserve(nrows);
+  }
+
+  // pad a column with nil up to the given count
+  template<class T>
+  void fill_elem(Value src, size_t nrows) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    xs.resize(std::max(xs.size(), nrows), nil_value<T>());
+  }
+
+  // drop a column's rows past the given count
+  template<class T>
+  void truncate_elem(Value src, size_t nrows) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    xs.resize(std::min(xs.size(), nrows));
+  }
+
+  // move a column's values into another column, then release it
+  template<class T>
+  void replace_elem(Value src, Value dst) {
+    std::vector<T>* xs = reinterpret_cast<std::vector<T>*>(src);
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.swap(*xs);
+    release_elem<T>(src);
+  }
+
+  // release a column
+  template<class T>
+  void release_elem(Value src) {
+    unmap_value(src);
+    forget_nil_free_value(src);
+    unpin_value(src);
+    delete reinterpret_cast<std::vector<T>*>(src);
+  }
+
+  // check a freshly loaded column for nil once; mapped columns are left
+  // unchecked so that they aren't read before they are needed
+  template<class T>
+  void check_nil_free_elem(Value v) {
+    if (!is_int<T>::value || mapped_columns_.count(v) != 0) {
+      return;
+    }
+    const std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(v);
+    bool has_nil = false;
+    for (size_t i = 0; i < xs.size(); i++) {
+      has_nil |= is_int_nil(xs[i]);
+    }
+    if (!has_nil) {
+      mark_nil_free(v);
+    }
+  }
+
+#include <VVM/splice.h>
+
+  // check each of a freshly loaded Dataframe's columns for nil
+  void check_nil_free(type_t typee, Dataframe& df) {
+    auto members = get_type_members(typee, types_);
+    for (size_t col = 0; col < df.size(); col++) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      check_nil_free_elem(vvm_typee, df[col]);
+    }
+  }
+
+  // ensure a column's block fits inside of a mapped file
+  void verify_block(const char* begin, const char* end, size_t count,
+                    size_t width) {
+    if (begin > end || count > size_t(end - begin) / width) {
+      throw std::logic_error("Invalid columnar file: truncated column");
+    }
+  }
+
+  // copy fixed-width values from a mapped file onto a column
+  template<class T>
+  typename std::enable_if<!std::is_same<T, bool>::value &&
+                          !std::is_same<T, std::string>::value, void>::type
+  read_column(const char* begin, const char* end, size_t nrows, Value dst) {
+    verify_block(begin, end, nrows, sizeof(T));
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    const T* xs = reinterpret_cast<const T*>(begin);
+    ys.assign(xs, xs + nrows);
+  }
+
+  // booleans are stored as one byte each
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, void>::type
+  read_column(const char* begin, const char* end, size_t nrows, Value dst) {
+    verify_block(begin, end, nrows, 1);
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.assign(begin, begin + nrows);
+  }
+
+  // strings are a length-prefixed block of end positions and characters
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, void>::type
+  read_column(const char* begin, const char* end, size_t nrows, Value dst) {
+    const size_t word = sizeof(uint64_t);
+    verify_block(begin, end, 1, word);
+    uint64_t nbytes;
+    memcpy(&nbytes, begin, word);
+    verify_block(begin + word, end, nbytes, 1);
+    verify_block(begin + word, begin + word + nbytes, nrows, word);
+
+    const uint64_t* ends = reinterpret_cast<const uint64_t*>(begin + word);
+    const char* chars = begin + word + nrows * word;
+    const uint64_t nchars = nbytes - nrows * word;
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(nrows);
+    uint64_t start = 0;
+    for (size_t i = 0; i < nrows; i++) {
+      if (ends[i] < start || ends[i] > nchars) {
+        throw std::logic_error("Invalid columnar file: bad string length");
+      }
+      ys.emplace_back(chars + start, ends[i] - start);
+      start = ends[i];
+    }
+  }
+
+  // check whether a column can be left in its mapped file (ie., it's stored
+  // just like its vector), ensuring that the column fits
+  template<class T>
+  typename std::enable_if<!std::is_same<T, bool>::value &&
+                          !std::is_same<T, std::string>::value, bool>::type
+  mappable_column(const char* begin, const char* end, size_t nrows) {
+    verify_block(begin, end, nrows, sizeof(T));
+    return true;
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value ||
+                          std::is_same<T, std::string>::value, bool>::type
+  mappable_column(const char* begin, const char* end, size_t nrows) {
+    return false;
+  }
+
+  // write a column's fixed-width values; returns the number of bytes
+  template<class T>
+  typename std::enable_if<!std::is_same<T, bool>::value &&
+                          !std::is_same<T, std::string>::value, size_t>::type
+  write_column(std::ostream& out, Value src) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    out.write(reinterpret_cast<const char*>(xs.data()), xs.size() * sizeof(T));
+    return xs.size() * sizeof(T);
+  }
+
+  // write a column of booleans as one byte each
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, size_t>::type
+  write_column(std::ostream& out, Value src) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    std::string bytes(xs.begin(), xs.end());
+    out.write(bytes.data(), bytes.size());
+    return bytes.size();
+  }
+
+  // write a column of strings as a length-prefixed block
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, size_t>::type
+  write_column(std::ostream& out, Value src) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    std::vector<uint64_t> ends(xs.size());
+    uint64_t position = 0;
+    for (size_t i = 0; i < xs.size(); i++) {
+      position += xs[i].size();
+      ends[i] = position;
+    }
+    uint64_t nbytes = ends.size() * sizeof(uint64_t) + position;
+    out.write(reinterpret_cast<const char*>(&nbytes), sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(ends.data()),
+              ends.size() * sizeof(uint64_t));
+    for (auto& x: xs) {
+      out.write(x.data(), x.size());
+    }
+    return sizeof(uint64_t) + nbytes;
+  }
+
+  /*** COMPRESSED COLUMNS ***/
+
+  // number of rows in each block of a compressed column
+  static const size_t rows_per_compressed_block = 1 << 16;
+
+  // most distinct strings that a dictionary-encoded column may have
+  static const size_t max_dictionary_size = 1 << 16;
+
+  // types stored as a 64-bit word get integer codecs and zone maps
+  template<class T> struct has_zone_map : public std::integral_constant<bool,
+    is_int<T>::value || std::is_floating_point<T>::value ||
+    is_datetime<T>::value> {};
+
+  // throw an error for a block whose codec doesn't suit its column's type
+  [[noreturn]] void bad_codec(Codec codec) {
+    std::ostringstream oss;
+    oss << "Invalid columnar file: codec " << uint64_t(codec)
+        << " does not match the column's type";
+    throw std::logic_error(oss.str());
+  }
+
+  // lay out the encoded blocks after the column's directory and write them;
+  // returns the number of bytes
+  size_t write_compressed_blocks(std::ostream& out, CompressedColumn& column,
+                                 const std::vector<std::string>& payloads,
+                                 size_t position) {
+    size_t offset = position + compressed_column_size(column);
+    for (size_t b = 0; b < payloads.size(); b++) {
+      column.blocks[b].offset = offset;
+      column.blocks[b].size = payloads[b].size();
+      offset += payloads[b].size() + columnar_padding(payloads[b].size());
+    }
+    out << write_compressed_column(column);
+    for (auto& payload: payloads) {
+      out << payload << std::string(columnar_padding(payload.size()), '\0');
+    }
+    return offset - position;
+  }
+
+  // encode a column of words; integers are packed relative to each block's
+  // minimum, times as delta-of-deltas, and floats are left as-is
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value, size_t>::type
+  write_compressed(std::ostream& out, Value src, size_t position) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    CompressedColumn column;
+    column.codec = is_int<T>::value ? Codec::kFrame :
+                   is_datetime<T>::value ? Codec::kDelta : Codec::kRaw;
+    size_t nblocks = (xs.size() + rows_per_compressed_block - 1) /
+                     rows_per_compressed_block;
+    column.blocks.resize(nblocks);
+    std::vector<std::string> payloads(nblocks);
+    parallel_for(nblocks, [&](size_t b) {
+      size_t first = b * rows_per_compressed_block;
+      size_t n = std::min(size_t(rows_per_compressed_block),
+                          xs.size() - first);
+      const T* ys = xs.data() + first;
+
+      // the zone map only considers non-nil values
+      CompressedBlock& block = column.blocks[b];
+      block.nrows = n;
+      block.count = 0;
+      T lo = nil_value<T>(), hi = nil_value<T>();
+      for (size_t i = 0; i < n; i++) {
+        if (!is_nil(ys[i])) {
+          lo = (block.count == 0 || ys[i] < lo) ? ys[i] : lo;
+          hi = (block.count == 0 || ys[i] > hi) ? ys[i] : hi;
+          block.count++;
+        }
+      }
+      memcpy(&block.min, &lo, sizeof(T));
+      memcpy(&block.max, &hi, sizeof(T));
+
+      std::vector<int64_t> words(n);
+      memcpy(words.data(), ys, n * sizeof(T));
+      switch (column.codec) {
+        case Codec::kFrame:
+          encode_frame(words.data(), n, nil_value<int64_t>(), payloads[b]);
+          break;
+        case Codec::kDelta:
+          encode_delta(words.data(), n, payloads[b]);
+          break;
+        default:
+          payloads[b].assign(reinterpret_cast<const char*>(ys), n * sizeof(T));
+          break;
+      }
+    });
+    return write_compressed_blocks(out, column, payloads, position);
+  }
+
+  // characters and booleans are already a byte each
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value ||
+                          std::is_same<T, char>::value, size_t>::type
+  write_compressed(std::ostream& out, Value src, size_t position) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    CompressedColumn column;
+    column.codec = Codec::kRaw;
+    size_t nblocks = (xs.size() + rows_per_compressed_block - 1) /
+                     rows_per_compressed_block;
+    column.blocks.resize(nblocks);
+    std::vector<std::string> payloads(nblocks);
+    for (size_t b = 0; b < nblocks; b++) {
+      size_t first = b * rows_per_compressed_block;
+      size_t n = std::min(size_t(rows_per_compressed_block),
+                          xs.size() - first);
+      column.blocks[b] = CompressedBlock{0, 0, n, 0, 0, 0};
+      payloads[b].assign(xs.begin() + first, xs.begin() + first + n);
+    }
+    return write_compressed_blocks(out, column, payloads, position);
+  }
+
+  // strings are dictionary encoded if there are few distinct values, and are
+  // otherwise stored like an uncompressed column (without the length prefix)
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, size_t>::type
+  write_compressed(std::ostream& out, Value src, size_t position) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    CompressedColumn column;
+    std::unordered_map<std::string, uint64_t> index;
+    size_t limit = std::min(size_t(max_dictionary_size), xs.size() / 2);
+    for (auto& x: xs) {
+      if (index.size() > limit) {
+        break;
+      }
+      if (index.emplace(x, column.dictionary.size()).second) {
+        column.dictionary.push_back(x);
+      }
+    }
+    if (index.size() > limit) {
+      column.dictionary.clear();
+      column.codec = Codec::kStrings;
+    }
+    else {
+      column.codec = Codec::kDictionary;
+    }
+
+    size_t nblocks = (xs.size() + rows_per_compressed_block - 1) /
+                     rows_per_compressed_block;
+    column.blocks.resize(nblocks);
+    std::vector<std::string> payloads(nblocks);
+    parallel_for(nblocks, [&](size_t b) {
+      size_t first = b * rows_per_compressed_block;
+      size_t n = std::min(size_t(rows_per_compressed_block),
+                          xs.size() - first);
+      column.blocks[b] = CompressedBlock{0, 0, n, 0, 0, 0};
+      std::string& payload = payloads[b];
+      if (column.codec == Codec::kDictionary) {
+        uint64_t width = bit_width(column.dictionary.size() - 1);
+        std::vector<uint64_t> codes(n);
+        for (size_t i = 0; i < n; i++) {
+          codes[i] = index.find(xs[first + i])->second;
+        }
+        payload.append(reinterpret_cast<const char*>(&width), sizeof(width));
+        pack_bits(codes, unsigned(width), payload);
+      }
+      else {
+        uint64_t position = 0;
+        for (size_t i = 0; i < n; i++) {
+          position += xs[first + i].size();
+          payload.append(reinterpret_cast<const char*>(&position),
+                         sizeof(position));
+        }
+        for (size_t i = 0; i < n; i++) {
+          payload += xs[first + i];
+        }
+      }
+    });
+    return write_compressed_blocks(out, column, payloads, position);
+  }
+
+  // decode a block of words onto a column
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value, void>::type
+  read_compressed(const char* data, const CompressedColumn& column,
+                  size_t b, Value dst) {
+    const CompressedBlock& block = column.blocks[b];
+    const char* begin = data + block.offset;
+    const char* end = begin + block.size;
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.resize(block.nrows);
+    std::vector<int64_t> words(block.nrows);
+    switch (column.codec) {
+      case Codec::kFrame:
+        decode_frame(begin, end, block.nrows, nil_value<int64_t>(),
+                     words.data());
+        break;
+      case Codec::kDelta:
+        decode_delta(begin, end, block.nrows, words.data());
+        break;
+      case Codec::kRaw:
+        verify_block(begin, end, block.nrows, sizeof(T));
+        memcpy(words.data(), begin, block.nrows * sizeof(T));
+        break;
+      default:
+        bad_codec(column.codec);
+    }
+    memcpy(reinterpret_cast<char*>(ys.data()), words.data(),
+           block.nrows * sizeof(T));
+  }
+
+  // decode a block of bytes onto a column
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value ||
+                          std::is_same<T, char>::value, void>::type
+  read_compressed(const char* data, const CompressedColumn& column,
+                  size_t b, Value dst) {
+    const CompressedBlock& block = column.blocks[b];
+    const char* begin = data + block.offset;
+    if (column.codec != Codec::kRaw) {
+      bad_codec(column.codec);
+    }
+    verify_block(begin, begin + block.size, block.nrows, 1);
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.assign(begin, begin + block.nrows);
+  }
+
+  // decode a block of strings onto a column
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, void>::type
+  read_compressed(const char* data, const CompressedColumn& column,
+                  size_t b, Value dst) {
+    const CompressedBlock& block = column.blocks[b];
+    const char* begin = data + block.offset;
+    const char* end = begin + block.size;
+    const size_t word = sizeof(uint64_t);
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(block.nrows);
+    if (column.codec == Codec::kDictionary) {
+      verify_block(begin, end, 1, word);
+      uint64_t width;
+      memcpy(&width, begin, word);
+      std::vector<uint64_t> codes(block.nrows);
+      unpack_bits(begin + word, end, block.nrows, unsigned(width),
+                  codes.data());
+      for (uint64_t code: codes) {
+        if (code >= column.dictionary.size()) {
+          throw std::logic_error("Invalid columnar file: bad dictionary code");
+        }
+        ys.push_back(column.dictionary[code]);
+      }
+    }
+    else if (column.codec == Codec::kStrings) {
+      verify_block(begin, end, block.nrows, word);
+      const char* chars = begin + block.nrows * word;
+      const uint64_t nchars = end - chars;
+      uint64_t start = 0;
+      for (size_t i = 0; i < block.nrows; i++) {
+        uint64_t stop;
+        memcpy(&stop, begin + i * word, word);
+        if (stop < start || stop > nchars) {
+          throw std::logic_error("Invalid columnar file: bad string length");
+        }
+        ys.emplace_back(chars + start, stop - start);
+        start = stop;
+      }
+    }
+    else {
+      bad_codec(column.codec);
+    }
+  }
+
+  // check whether a block's zone map allows any row to match a constant;
+  // this mirrors the nil handling of compare_values()
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value, bool>::type
+  block_may_match(const CompressedBlock& block, operand_t value,
+                  Comparison cmp) {
+    T y = get_value<T>(value);
+    if (is_int_nil(y)) {
+      return false;
+    }
+    // a floating-point nil is unequal to everything
+    if (std::is_floating_point<T>::value && cmp == Comparison::kNe &&
+        (block.count < block.nrows || is_nil(y))) {
+      return true;
+    }
+    if (block.count == 0) {
+      return false;
+    }
+    T lo, hi;
+    memcpy(reinterpret_cast<char*>(&lo), &block.min, sizeof(T));
+    memcpy(reinterpret_cast<char*>(&hi), &block.max, sizeof(T));
+    switch (cmp) {
+      case Comparison::kLt:  return lo < y;
+      case Comparison::kGt:  return hi > y;
+      case Comparison::kEq:  return lo <= y && y <= hi;
+      case Comparison::kNe:  return !(lo == y && hi == y);
+      case Comparison::kLte: return lo <= y;
+      case Comparison::kGte: return hi >= y;
+    }
+    return true;
+  }
+
+  // other types have no zone map, so every block must be read
+  template<class T>
+  typename std::enable_if<!has_zone_map<T>::value, bool>::type
+  block_may_match(const CompressedBlock& block, operand_t value,
+                  Comparison cmp) {
+    return true;
+  }
+
+  /*** ARROW COLUMNS ***/
+
+  // types whose vector is laid out just like an Arrow column of 64-bit
+  // values (Dates are days in Arrow, so they must always be converted)
+  template<class T> struct is_arrow_word : public std::integral_constant<bool,
+    has_zone_map<T>::value && !std::is_same<T, Date>::value> {};
+
+  // describe a column's type in an Arrow schema
+  template<class T>
+  typename std::enable_if<is_int<T>::value, ArrowField>::type
+  arrow_field(Value src) {
+    return ArrowField{std::string(), ArrowType::kInt, 64, true, 0};
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_floating_point<T>::value, ArrowField>::type
+  arrow_field(Value src) {
+    return ArrowField{std::string(), ArrowType::kFloatingPoint, 64, true, 0};
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, ArrowField>::type
+  arrow_field(Value src) {
+    return ArrowField{std::string(), ArrowType::kBool, 1, false, 0};
+  }
+
+  // strings need 64-bit offsets once their characters pass 2GB
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value,
+                          ArrowField>::type
+  arrow_field(Value src) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    uint64_t nchars = 0;
+    for (auto& x: xs) {
+      nchars += x.size();
+    }
+    bool large = nchars > uint64_t(std::numeric_limits<int32_t>::max());
+    return ArrowField{std::string(),
+                      large ? ArrowType::kLargeUtf8 : ArrowType::kUtf8,
+                      0, false, 0};
+  }
+
+  // Arrow has no single-character type, so a Char is a string of one
+  template<class T>
+  typename std::enable_if<std::is_same<T, char>::value, ArrowField>::type
+  arrow_field(Value src) {
+    return ArrowField{std::string(), ArrowType::kUtf8, 0, false, 0};
+  }
+
+  template<class T>
+  typename std::enable_if<is_datetime<T>::value, ArrowField>::type
+  arrow_field(Value src) {
+    ArrowField field{std::string(), ArrowType::kTimestamp, 64, true,
+                     int16_t(ArrowTimeUnit::kNanosecond)};
+    if (std::is_same<T, Timedelta>::value) {
+      field.type = ArrowType::kDuration;
+    }
+    else if (std::is_same<T, Time>::value) {
+      field.type = ArrowType::kTime;
+    }
+    else if (std::is_same<T, Date>::value) {
+      field.type = ArrowType::kDate;
+      field.bit_width = 32;
+      field.unit = int16_t(ArrowDateUnit::kDay);
+    }
+    return field;
+  }
+
+  // count a column's nils, which become nulls in Arrow
+  template<class T>
+  int64_t count_nils(const std::vector<T>& xs) {
+    return std::count_if(xs.begin(), xs.end(), [](const T& x) {
+      return is_nil(x);
+    });
+  }
+
+  // size of a bitmap with one bit per row
+  static int64_t bitmap_size(size_t nrows) {
+    return int64_t((nrows + 7) / 8);
+  }
+
+  // find a column's null count and the length of each of its buffers, which
+  // always start with the validity bitmap (left empty if there are no nulls);
+  // a column's own bitmap saves looking for nil
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value, void>::type
+  arrow_lengths(Value src, const ArrowField& field, ArrowNode& node,
+                std::vector<int64_t>& lengths) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    const Validity* validity = find_validity(src);
+    node = ArrowNode{int64_t(xs.size()),
+                     (validity != nullptr)
+                       ? int64_t(count_missing(*validity, xs.size()))
+                       : count_nils(xs)};
+    lengths.push_back(node.null_count > 0 ? bitmap_size(xs.size()) : 0);
+    lengths.push_back(int64_t(xs.size()) * field.bit_width / 8);
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, void>::type
+  arrow_lengths(Value src, const ArrowField& field, ArrowNode& node,
+                std::vector<int64_t>& lengths) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    const Validity* validity = find_validity(src);
+    node = ArrowNode{int64_t(xs.size()),
+                     (validity != nullptr)
+                       ? int64_t(count_missing(*validity, xs.size())) : 0};
+    lengths.push_back(node.null_count > 0 ? bitmap_size(xs.size()) : 0);
+    lengths.push_back(bitmap_size(xs.size()));
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, void>::type
+  arrow_lengths(Value src, const ArrowField& field, ArrowNode& node,
+                std::vector<int64_t>& lengths) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    node = ArrowNode{int64_t(xs.size()), 0};
+    int64_t nchars = 0;
+    for (auto& x: xs) {
+      nchars += x.size();
+    }
+    int64_t width = (field.type == ArrowType::kLargeUtf8) ? 8 : 4;
+    lengths.push_back(0);
+    lengths.push_back((int64_t(xs.size()) + 1) * width);
+    lengths.push_back(nchars);
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, char>::value, void>::type
+  arrow_lengths(Value src, const ArrowField& field, ArrowNode& node,
+                std::vector<int64_t>& lengths) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    node = ArrowNode{int64_t(xs.size()), count_nils(xs)};
+    lengths.push_back(node.null_count > 0 ? bitmap_size(xs.size()) : 0);
+    lengths.push_back((int64_t(xs.size()) + 1) * 4);
+    lengths.push_back(int64_t(xs.size()) - node.null_count);
+  }
+
+  // write a buffer's bytes and pad it to the next eight-byte boundary
+  void write_arrow_buffer(std::ostream& out, const char* data, size_t n) {
+    out.write(data, n);
+    out << std::string(arrow_padding(n), '\0');
+  }
+
+  // write a bitmap whose bits are set by a predicate of each row
+  template<class F>
+  void write_arrow_bitmap(std::ostream& out, size_t nrows, F is_set) {
+    std::string bits(bitmap_size(nrows), '\0');
+    for (size_t i = 0; i < nrows; i++) {
+      bits[i >> 3] |= char(is_set(i) << (i & 7));
+    }
+    write_arrow_buffer(out, bits.data(), bits.size());
+  }
+
+  // write a validity bitmap, which is already in Arrow's order
+  void write_arrow_validity(std::ostream& out, const Validity& validity,
+                            size_t nrows) {
+    std::string bits(bitmap_size(nrows), '\0');
+    write_validity(validity, nrows, &bits[0]);
+    write_arrow_buffer(out, bits.data(), bits.size());
+  }
+
+  // write a column's buffers as laid out by arrow_lengths(); values that are
+  // already in Arrow's representation are written directly from the vector
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value, void>::type
+  write_arrow(std::ostream& out, Value src, const ArrowField& field,
+              const ArrowNode& node) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    if (node.null_count > 0) {
+      const Validity* validity = find_validity(src);
+      if (validity != nullptr) {
+        write_arrow_validity(out, *validity, xs.size());
+      }
+      else {
+        write_arrow_validity(out, sentinel_validity(xs.data(), xs.size()),
+                             xs.size());
+      }
+    }
+    if (is_arrow_word<T>::value) {
+      write_arrow_buffer(out, reinterpret_cast<const char*>(xs.data()),
+                         xs.size() * sizeof(T));
+      return;
+    }
+
+    // Dates are converted to days a block of rows at a time
+    static const int64_t ns_per_day = 86400000000000;
+    std::vector<int32_t> days;
+    for (size_t first = 0; first < xs.size(); first += store_block_rows) {
+      size_t last = std::min(first + store_block_rows, xs.size());
+      days.clear();
+      for (size_t i = first; i < last; i++) {
+        int64_t x = static_cast<int64_t>(xs[i]);
+        days.push_back(is_nil(xs[i]) ? 0 : int32_t(x / ns_per_day));
+      }
+      out.write(reinterpret_cast<const char*>(days.data()),
+                days.size() * sizeof(int32_t));
+    }
+    out << std::string(arrow_padding(xs.size() * sizeof(int32_t)), '\0');
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, void>::type
+  write_arrow(std::ostream& out, Value src, const ArrowField& field,
+              const ArrowNode& node) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    if (node.null_count > 0) {
+      write_arrow_validity(out, *find_validity(src), xs.size());
+    }
+    write_arrow_bitmap(out, xs.size(), [&](size_t i) { return bool(xs[i]); });
+  }
+
+  // strings are end positions (starting from zero) followed by characters
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, void>::type
+  write_arrow(std::ostream& out, Value src, const ArrowField& field,
+              const ArrowNode& node) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    if (field.type == ArrowType::kLargeUtf8) {
+      std::vector<int64_t> offsets(1, 0);
+      for (auto& x: xs) {
+        offsets.push_back(offsets.back() + int64_t(x.size()));
+      }
+      write_arrow_buffer(out, reinterpret_cast<const char*>(offsets.data()),
+                         offsets.size() * sizeof(int64_t));
+    }
+    else {
+      std::vector<int32_t> offsets(1, 0);
+      for (auto& x: xs) {
+        offsets.push_back(offsets.back() + int32_t(x.size()));
+      }
+      write_arrow_buffer(out, reinterpret_cast<const char*>(offsets.data()),
+                         offsets.size() * sizeof(int32_t));
+    }
+    size_t nchars = 0;
+    for (auto& x: xs) {
+      out.write(x.data(), x.size());
+      nchars += x.size();
+    }
+    out << std::string(arrow_padding(nchars), '\0');
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_same<T, char>::value, void>::type
+  write_arrow(std::ostream& out, Value src, const ArrowField& field,
+              const ArrowNode& node) {
+    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    std::vector<int32_t> offsets(1, 0);
+    std::string chars;
+    if (node.null_count > 0) {
+      write_arrow_validity(out, sentinel_validity(xs.data(), xs.size()),
+                           xs.size());
+    }
+    for (char x: xs) {
+      if (!is_nil(x)) {
+        chars.push_back(x);
+      }
+      offsets.push_back(int32_t(chars.size()));
+    }
+    write_arrow_buffer(out, reinterpret_cast<const char*>(offsets.data()),
+                       offsets.size() * sizeof(int32_t));
+    write_arrow_buffer(out, chars.data(), chars.size());
+  }
+
+  // throw an error for an Arrow column that a member can't hold
+  [[noreturn]] void bad_arrow_field(const ArrowField& field,
+                                    const char* expected) {
+    std::ostringstream oss;
+    oss << "Arrow column " << field.name << " is "
+        << arrow_type_name(field) << ", but type expects " << expected;
+    throw std::logic_error(oss.str());
+  }
+
+  // get a column's buffer from a record batch's body, ensuring that it holds
+  // the given number of bytes
+  const char* arrow_buffer(const char* body, const ArrowBuffer& buffer,
+                           int64_t nbytes) {
+    if (buffer.length < nbytes) {
+      throw std::logic_error("Invalid Arrow file: truncated buffer");
+    }
+    return body + buffer.offset;
+  }
+
+  // get a column's validity bitmap, which is null if every row is valid
+  const char* arrow_bitmap(const char* body, const ArrowNode& node,
+                           const ArrowBuffer& buffer) {
+    if (node.null_count == 0) {
+      return nullptr;
+    }
+    return arrow_buffer(body, buffer, bitmap_size(node.length));
+  }
+
+  // get the end positions of a batch's strings, which must stay within the
+  // characters; returns the characters
+  const char* arrow_strings(const char* body, const ArrowField& field,
+                            const ArrowNode& node, const ArrowBuffer* buffers,
+                            std::vector<int64_t>& offsets) {
+    size_t n = size_t(node.length);
+    int32_t width = (field.type == ArrowType::kLargeUtf8) ? 64 : 32;
+    const char* data = arrow_buffer(body, buffers[1], (node.length + 1) *
+                                                      (width / 8));
+    offsets.resize(n + 1);
+    for (size_t i = 0; i <= n; i++) {
+      offsets[i] = arrow_int_at(data, width, true, i);
+      if (offsets[i] < (i > 0 ? offsets[i - 1] : 0) ||
+          offsets[i] > buffers[2].length) {
+        throw std::logic_error("Invalid Arrow file: bad string offset");
+      }
+    }
+    return body + buffers[2].offset;
+  }
+
+  // append a record batch's column of integers or times, scaling the units
+  // to nanoseconds; nulls become nil once the values are in place, and every
+  // nil is marked in the column's validity bitmap
+  template<class T>
+  typename std::enable_if<has_zone_map<T>::value &&
+                          !std::is_floating_point<T>::value, void>::type
+  read_arrow(const char* body, const ArrowField& field, const ArrowNode& node,
+             const ArrowBuffer* buffers, size_t capacity, Value dst,
+             Validity& column_validity) {
+    ArrowType expected = arrow_field<T>(nullptr).type;
+    if (field.type != expected) {
+      bad_arrow_field(field, arrow_type_name(arrow_field<T>(nullptr)));
+    }
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    Validity validity = read_validity(arrow_bitmap(body, node, buffers[0]),
+                                      node.length);
+    const char* data = arrow_buffer(body, buffers[1],
+                                    node.length * (field.bit_width / 8));
+    // times beyond what nanoseconds can hold become nil as well
+    int64_t scale = arrow_nanos_per_unit(field);
+    int64_t limit = std::numeric_limits<int64_t>::max() / scale;
+    size_t first = ys.size();
+    bool has_nil = false;
+    for (int64_t i = 0; i < node.length; i++) {
+      int64_t x = arrow_int_at(data, field.bit_width, field.is_signed, i);
+      bool valid = x <= limit && x >= -limit;
+      ys.push_back(valid ? T(x * scale) : nil_value<T>());
+      has_nil |= is_nil(ys.back());
+    }
+    apply_validity(validity, ys.data() + first, node.length);
+
+    // a valid row may still be nil (eg., a time beyond nanoseconds)
+    if (has_nil) {
+      validity = sentinel_validity(ys.data() + first, node.length);
+    }
+    append_validity(column_validity, first, validity, node.length);
+  }
+
+  template<class T>
+  typename std::enable_if<std::is_floating_point<T>::value, void>::type
+  read_arrow(const char* body, const ArrowField& field, const ArrowNode& node,
+             const ArrowBuffer* buffers, size_t capacity, Value dst,
+             Validity& column_validity) {
+    if (field.type != ArrowType::kFloatingPoint) {
+      bad_arrow_field(field, "Float64");
+    }
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    Validity validity = read_validity(arrow_bitmap(body, node, buffers[0]),
+                                      node.length);
+    const char* data = arrow_buffer(body, buffers[1],
+                                    node.length * (field.bit_width / 8));
+    size_t first = ys.size();
+    for (int64_t i = 0; i < node.length; i++) {
+      T y;
+      if (field.bit_width == 32) {
+        float x;
+        memcpy(&x, data + 4 * i, 4);
+        y = x;
+      }
+      else {
+        memcpy(&y, data + 8 * i, 8);
+      }
+      ys.push_back(y);
+    }
+    apply_validity(validity, ys.data() + first, node.length);
+  }
+
+  // booleans are never nil, so a null is false and is only marked in the
+  // column's validity bitmap
+  template<class T>
+  typename std::enable_if<std::is_same<T, bool>::value, void>::type
+  read_arrow(const char* body, const ArrowField& field, const ArrowNode& node,
+             const ArrowBuffer* buffers, size_t capacity, Value dst,
+             Validity& column_validity) {
+    if (field.type != ArrowType::kBool) {
+      bad_arrow_field(field, "Bool");
+    }
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    const char* bitmap = arrow_bitmap(body, node, buffers[0]);
+    const char* data = arrow_buffer(body, buffers[1],
+                                    bitmap_size(node.length));
+    size_t first = ys.size();
+    for (int64_t i = 0; i < node.length; i++) {
+      ys.push_back(arrow_is_valid(bitmap, i) && arrow_is_valid(data, i));
+    }
+    append_validity(column_validity, first,
+                    read_validity(bitmap, node.length), node.length);
+  }
+
+  // strings are never nil either, so a null is just empty
+  template<class T>
+  typename std::enable_if<std::is_same<T, std::string>::value, void>::type
+  read_arrow(const char* body, const ArrowField& field, const ArrowNode& node,
+             const ArrowBuffer* buffers, size_t capacity, Value dst,
+             Validity& column_validity) {
+    if (field.type != ArrowType::kUtf8 && field.type != ArrowType::kLargeUtf8) {
+      bad_arrow_field(field, "String");
+    }
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    const char* bitmap = arrow_bitmap(body, node, buffers[0]);
+    std::vector<int64_t> offsets;
+    const char* chars = arrow_strings(body, field, node, buffers, offsets);
+    for (int64_t i = 0; i < node.length; i++) {
+      if (arrow_is_valid(bitmap, i)) {
+        ys.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+      }
+      else {
+        ys.emplace_back();
+      }
+    }
+  }
+
+  // a Char column is a string column with at most one character per row
+  template<class T>
+  typename std::enable_if<std::is_same<T, char>::value, void>::type
+  read_arrow(const char* body, const ArrowField& field, const ArrowNode& node,
+             const ArrowBuffer* buffers, size_t capacity, Value dst,
+             Validity& column_validity) {
+    if (field.type != ArrowType::kUtf8 && field.type != ArrowType::kLargeUtf8) {
+      bad_arrow_field(field, "Char");
+    }
+    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
+    ys.reserve(capacity);
+    const char* bitmap = arrow_bitmap(body, node, buffers[0]);
+    std::vector<int64_t> offsets;
+    const char* chars = arrow_strings(body, field, node, buffers, offsets);
+    for (int64_t i = 0; i < node.length; i++) {
+      int64_t n = offsets[i + 1] - offsets[i];
+      if (n > 1) {
+        std::ostringstream oss;
+        oss << "Arrow column " << field.name << " has a string that is not"
+            << " a Char";
+        throw std::logic_error(oss.str());
+      }
+      bool valid = arrow_is_valid(bitmap, i) && n == 1;
+      ys.push_back(valid ? chars[offsets[i]] : nil_value<T>());
+    }
+  }
+
+  // check whether a record batch's column can be left in its mapped file
+  // (ie., it has no nulls and is stored just like its vector)
+  template<class T>
+  typename std::enable_if<is_arrow_word<T>::value, bool>::type
+  mappable_arrow(const char* body, const ArrowField& field,
+                 const ArrowNode& node, const ArrowBuffer* buffers) {
+    const char* data = body + buffers[1].offset;
+    return field.type == arrow_field<T>(nullptr).type &&
+           field.bit_width == 64 && field.is_signed &&
+           arrow_nanos_per_unit(field) == 1 && node.null_count == 0 &&
+           buffers[1].length >= node.length * int64_t(sizeof(T)) &&
+           reinterpret_cast<uintptr_t>(data) % sizeof(T) == 0;
+  }
+
+  template<class T>
+  typename std::enable_if<!is_arrow_word<T>::value, bool>::type
+  mappable_arrow(const char* body, const ArrowField& field,
+                 const ArrowNode& node, const ArrowBuffer* buffers) {
+    return false;
+  }
+
+#include <VVM/columnar.h>
+
+  // cursor over a range of mapped bytes; the range must either end on a
+  // record boundary or be the tail of the mapping (which is NUL-guarded)
+  class RangeCursor: public csvmonkey::StreamCursor {
+    const char* p_;
+    const char* endp_;
+
+   public:
+    RangeCursor(const char* begin, const char* end): p_(begin), endp_(end) {
+    }
+
+    const char* buf() {
+      return p_;
+    }
+
+    size_t size() {
+      return endp_ - p_;
+    }
+
+    void consume(size_t n) {
+      p_ += std::min(n, size());
+    }
+
+    bool fill() {
+      return false;
+    }
+  };
+
+  // smallest amount of text worth handing to its own worker
+  static const size_t kMinChunkSize = 1 << 20;
+
+  // split text into chunks that begin and end on record boundaries; a
+  // newline only ends a record if it is outside of a quoted cell
+  std::vector<const char*> split_records(const char* begin, const char* end,
+                                         size_t nchunks) {
+    std::vector<const char*> bounds{begin};
+    size_t quotes = 0;
+    const char* scanned = begin;
+    for (size_t i = 1; i < nchunks; i++) {
+      const char* p = begin + (end - begin) * i / nchunks;
+      if (p < scanned) {
+        continue;
+      }
+      quotes += std::count(scanned, p, '"');
+      while (p < end && (*p != '\n' || quotes % 2 != 0)) {
+        quotes += (*p == '"');
+        p++;
+      }
+      if (p >= end) {
+        break;
+      }
+      scanned = ++p;
+      bounds.push_back(p);
+    }
+    bounds.push_back(end);
+    return bounds;
+  }
+
+  // number of rows whose cells are gathered before parsing each column
+  static const size_t kRowsPerBlock = 4096;
+
+  // number of rows sampled to infer a column's strtime format
+  static const size_t kInferSampleRows = 10;
+
+  // a comparison of one column to a constant, applied while loading
+  struct RowFilter {
+    size_t column;
+    Comparison cmp;
+    operand_t value;
+  };
+
+  // parse rows of text onto the end of the given columns (other columns are
+  // skipped entirely); rows that fail the filter (if any) are dropped before
+  // the rest of their cells are parsed; the start of every stride-th row is
+  // marked if asked; returns false if the text did not end on a record
+  // boundary
+  bool load_chunk(const char* begin, const char* end,
+                  const std::vector<named_type_t>& members,
+                  const std::vector<StrtimeFormat>& formats,
+                  const std::vector<size_t>& columns,
+                  const RowFilter* filter, Dataframe& df, size_t& nrows,
+                  std::vector<const char*>* marks = nullptr) {
+    RangeCursor cursor(begin, end);
+    csvmonkey::CsvReader reader(cursor);
+
+    // gather a block of cells for each column; the cells point directly into
+    // the mapped file, so nothing is copied until the typed parse
+    std::vector<std::vector<csvmonkey::CsvCell>> cells(columns.size());
+    for (auto& column: cells) {
+      column.reserve(kRowsPerBlock);
+    }
+    const csvmonkey::CsvCell missing{nullptr, 0, false};
+
+    // the filter's column is matched first, then every block is compacted
+    size_t filter_idx = 0;
+    if (filter != nullptr) {
+      filter_idx = std::find(columns.begin(), columns.end(), filter->column) -
+                   columns.begin();
+    }
+    std::vector<char> keep;
+    size_t pending = 0;
+
+    auto flush = [&]() {
+      if (filter != nullptr && pending != 0) {
+        size_t col = filter->column;
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        match_cells(vvm_typee, cells[filter_idx], formats[col],
+                    filter->value, filter->cmp, keep);
+        for (auto& column: cells) {
+          size_t kept = 0;
+          for (size_t row = 0; row < column.size(); row++) {
+            if (keep[row]) {
+              column[kept++] = column[row];
+            }
+          }
+          column.resize(kept);
+        }
+        pending = std::count(keep.begin(), keep.end(), char(1));
+      }
+      nrows += pending;
+      pending = 0;
+      for (size_t i = 0; i < cells.size(); i++) {
+        size_t col = columns[i];
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        parse_cells(vvm_typee, cells[i], df[col], formats[col]);
+        cells[i].clear();
+      }
+    };
+
+    nrows = 0;
+    size_t nread = 0;
+    const char* start = cursor.buf();
+    while (reader.read_row()) {
+      if (marks != nullptr && nread++ % csv_index_stride == 0) {
+        marks->push_back(start);
+      }
+      start = cursor.buf();
+      auto& row = reader.row();
+      for (size_t i = 0; i < cells.size(); i++) {
+        size_t col = columns[i];
+        cells[i].push_back(col < row.count ? row.cells[col] : missing);
+      }
+      if (++pending == kRowsPerBlock) {
+        flush();
+      }
+    }
+    flush();
+
+    // only blank lines may be left over
+    const char* p = cursor.buf();
+    return std::all_of(p, p + cursor.size(),
+                       [](char c) { return c == '\r' || c == '\n'; });
+  }
+
+  // narrow every loaded column to the rows that pass the filter
+  void narrow_rows(const type_definition_t& members,
+                   const std::vector<size_t>& columns,
+                   const RowFilter& filter, Dataframe& df) {
+    vvm_types vvm_typee =
+      static_cast<vvm_types>(members[filter.column].typee >> 1);
+    std::vector<char> keep;
+    match_values(vvm_typee, df[filter.column], filter.value, filter.cmp, keep);
+    std::vector<bool> truths(keep.begin(), keep.end());
+    for (size_t col: columns) {
+      vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      Value narrowed = allocate(members[col].typee);
+      where_elem(vvm_typee, df[col], truths, narrowed);
+      release_elem(vvm_typee, df[col]);
+      df[col] = narrowed;
+    }
+  }
+
+  // load a compressed file; blocks whose zone map rules out the filter are
+  // skipped, and the rest are decoded in parallel
+  void load_compressed(const char* begin, const char* end,
+                       const ColumnarHeader& header,
+                       const type_definition_t& members,
+                       const std::vector<size_t>& columns,
+                       const RowFilter* filter, Dataframe& df) {
+    if (columns.empty()) {
+      return;
+    }
+    std::vector<CompressedColumn> compressed;
+    for (size_t col: columns) {
+      compressed.push_back(read_compressed_column(begin, end - begin,
+                                                  header.offsets[col]));
+    }
+
+    // every column must be split into the same blocks of rows
+    auto& layout = compressed[0].blocks;
+    size_t nrows = 0;
+    for (auto& block: layout) {
+      nrows += block.nrows;
+    }
+    bool consistent = (nrows == header.nrows);
+    for (auto& column: compressed) {
+      consistent = consistent && column.blocks.size() == layout.size();
+      for (size_t b = 0; consistent && b < layout.size(); b++) {
+        consistent = column.blocks[b].nrows == layout[b].nrows;
+      }
+    }
+    if (!consistent) {
+      throw std::logic_error("Invalid columnar file: mismatched blocks");
+    }
+
+    // find the blocks that could have matching rows
+    std::vector<size_t> blocks;
+    size_t total_rows = 0;
+    size_t filter_idx = 0;
+    if (filter != nullptr) {
+      filter_idx = std::find(columns.begin(), columns.end(), filter->column) -
+                   columns.begin();
+    }
+    for (size_t b = 0; b < layout.size(); b++) {
+      if (filter == nullptr ||
+          block_may_match(
+            static_cast<vvm_types>(members[filter->column].typee >> 1),
+            compressed[filter_idx].blocks[b], filter->value, filter->cmp)) {
+        blocks.push_back(b);
+        total_rows += layout[b].nrows;
+      }
+    }
+
+    // decode every block of every column independently
+    size_t nblocks = blocks.size();
+    std::vector<Value> pieces(columns.size() * nblocks);
+    for (size_t i = 0; i < pieces.size(); i++) {
+      pieces[i] = allocate(members[columns[i / nblocks]].typee);
+    }
+    parallel_for(pieces.size(), [&](size_t i) {
+      size_t col = columns[i / nblocks];
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      read_compressed(vvm_typee, begin, compressed[i / nblocks],
+                      blocks[i % nblocks], pieces[i]);
+    });
+
+    // stitch the blocks together in order
+    for (size_t i = 0; i < pieces.size(); i++) {
+      size_t col = columns[i / nblocks];
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      splice_elem(vvm_typee, pieces[i], df[col], total_rows);
+    }
+  }
+
+  // load a file in the native binary format; like the CSV loader, only the
+  // given columns are read; lazy columns may be left in the mapped file
+  void load_columnar(const std::string& filename,
+                     const type_definition_t& members,
+                     const std::vector<size_t>& columns,
+                     const RowFilter* filter, Dataframe& df, bool lazy) {
+    auto cursor = std::make_shared<csvmonkey::MappedFileCursor>();
+    try {
+      cursor->open(filename.c_str());
+    }
+    catch (csvmonkey::Error& e) {
+      throw std::logic_error(e.what());
+    }
+    const char* begin = cursor->buf();
+    const char* end = begin + cursor->size();
+    ColumnarHeader header = read_columnar_header(begin, end - begin);
+    if (header.offsets.size() != members.size()) {
+      std::ostringstream oss;
+      oss << "Columnar file " << filename << " has "
+          << header.offsets.size() << " columns, but type expects "
+          << members.size();
+      throw std::logic_error(oss.str());
+    }
+
+    // compressed columns must be decoded, so nothing stays mapped
+    if (header.compressed) {
+      load_compressed(begin, end, header, members, columns, filter, df);
+      if (filter != nullptr) {
+        narrow_rows(members, columns, *filter, df);
+      }
+      return;
+    }
+
+    // fixed-width columns are left in the mapped file, so their pages are
+    // only read once a computation touches them; the rest are copied
+    std::vector<size_t> copied;
+    for (size_t col: columns) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      const char* block = begin + header.offsets[col];
+      if (lazy && filter == nullptr &&
+          mappable_column(vvm_typee, block, end, header.nrows)) {
+        mapped_columns_[df[col]] =
+          MappedColumn{vvm_typee, block, end, header.nrows, filename};
+      }
+      else {
+        copied.push_back(col);
+      }
+    }
+    if (copied.size() != columns.size()) {
+      mapped_files_.push_back(cursor);
+    }
+
+    // columns are independent blocks, so copy them in parallel
+    parallel_for(copied.size(), [&](size_t i) {
+      size_t col = copied[i];
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      read_column(vvm_typee, begin + header.offsets[col], end, header.nrows,
+                  df[col]);
+    });
+
+    if (filter != nullptr) {
+      narrow_rows(members, columns, *filter, df);
+    }
+  }
+
+  // load a file in the Arrow IPC format; like the native binary format,
+  // lazy columns may be left in the mapped file if nothing needs converting
+  void load_arrow(const std::string& filename,
+                  const type_definition_t& members,
+                  const std::vector<size_t>& columns,
+                  const RowFilter* filter, Dataframe& df, bool lazy) {
+    auto cursor = std::make_shared<csvmonkey::MappedFileCursor>();
+    try {
+      cursor->open(filename.c_str());
+    }
+    catch (csvmonkey::Error& e) {
+      throw std::logic_error(e.what());
+    }
+    ArrowFile file = read_arrow_file(cursor->buf(), cursor->size());
+    if (file.fields.size() != members.size()) {
+      std::ostringstream oss;
+      oss << "Arrow file " << filename << " has " << file.fields.size()
+          << " columns, but type expects " << members.size();
+      throw std::logic_error(oss.str());
+    }
+
+    // find where each column's buffers begin within a record batch
+    std::vector<size_t> first_buffer;
+    size_t nbuffers = 0;
+    for (auto& field: file.fields) {
+      first_buffer.push_back(nbuffers);
+      nbuffers += arrow_buffer_count(field.type);
+    }
+    size_t nrows = 0;
+    for (auto& batch: file.batches) {
+      nrows += size_t(batch.nrows);
+    }
+
+    // a column of a single batch may be left in the mapped file
+    std::vector<size_t> copied;
+    for (size_t col: columns) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      if (lazy && filter == nullptr && file.batches.size() == 1) {
+        ArrowBatch& batch = file.batches[0];
+        const char* body = cursor->buf() + batch.body;
+        const ArrowBuffer* buffers = &batch.buffers[first_buffer[col]];
+        if (mappable_arrow(vvm_typee, body, file.fields[col],
+                           batch.nodes[col], buffers)) {
+          const char* begin = body + buffers[1].offset;
+          mapped_columns_[df[col]] =
+            MappedColumn{vvm_typee, begin, begin + buffers[1].length,
+                         nrows, filename};
+          continue;
+        }
+      }
+      copied.push_back(col);
+    }
+    if (copied.size() != columns.size()) {
+      mapped_files_.push_back(cursor);
+    }
+
+    // convert the rest in parallel, appending each batch in order
+    std::vector<Validity> validities(copied.size());
+    parallel_for(copied.size(), [&](size_t i) {
+      size_t col = copied[i];
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      for (auto& batch: file.batches) {
+        read_arrow(vvm_typee, cursor->buf() + batch.body, file.fields[col],
+                   batch.nodes[col], &batch.buffers[first_buffer[col]], nrows,
+                   df[col], validities[i]);
+      }
+    });
+
+    // only Bools and integers fill in a bitmap, which is kept as long as
+    // every row is still in place
+    if (filter != nullptr) {
+      narrow_rows(members, columns, *filter, df);
+      return;
+    }
+    for (size_t i = 0; i < copied.size(); i++) {
+      mark_validity(df[copied[i]], std::move(validities[i]));
+    }
+  }
+
+  // binary files are read whole rather than split into chunks; a compressed
+  // CSV file is streamed a block at a time instead
+  static bool is_binary_file(const std::string& filename) {
+    return is_columnar_file(filename) || is_arrow_file(filename) ||
+           is_gzip_file(filename);
+  }
+
+  void load_binary(const std::string& filename,
+                   const type_definition_t& members,
+                   const std::vector<size_t>& columns,
+                   const RowFilter* filter, Dataframe& df, bool lazy) {
+    if (is_arrow_file(filename)) {
+      load_arrow(filename, members, columns, filter, df, lazy);
+    }
+    else if (is_gzip_file(filename)) {
+      load_gzip(filename, members, columns, filter, df);
+    }
+    else {
+      load_columnar(filename, members, columns, filter, df, lazy);
+    }
+  }
+
+  // a CSV file whose body has been split into chunks for workers to parse;
+  // the file stays mapped until the chunks have been parsed
+  struct CsvFile {
+    std::unique_ptr<csvmonkey::MappedFileCursor> cursor;
+    const char* start;
+    const char* body;
+    const char* end;
+    std::vector<StrtimeFormat> formats;
+    std::vector<const char*> bounds;
+    std::vector<Dataframe> chunks;
+    std::vector<size_t> chunk_rows;
+    std::vector<char> completed;
+    CsvIndex index;
+    bool indexed = false;
+    std::vector<std::vector<const char*>> marks;  // if building an index
+  };
+
+  // map a CSV file without reading anything yet
+  void open_csv(const std::string& filename, CsvFile& file) {
+    file.cursor.reset(new csvmonkey::MappedFileCursor);
+    try {
+      file.cursor->open(filename.c_str());
+    }
+    catch (csvmonkey::Error& e) {
+      throw std::logic_error(e.what());
+    }
+    file.start = file.cursor->buf();
+    file.end = file.start + file.cursor->size();
+  }
+
+  // map a CSV file, infer its strtime formats, and allocate its chunks; a
+  // large file without an index gets one built if every row will be read
+  void prepare_csv(const std::string& filename,
+                   const type_definition_t& members,
+                   const std::vector<size_t>& columns, bool build_index,
+                   CsvFile& file) {
+    // prepare reader
+    open_csv(filename, file);
+
+    // skip the header
+    csvmonkey::CsvReader reader(*file.cursor);
+    reader.read_row();
+    const char* begin = file.cursor->buf();
+    const char* end = begin + file.cursor->size();
+    file.body = begin;
+
+    infer_csv_formats(begin, end, members, columns, file);
+    if (read_index(filename, file)) {
+      split_indexed(members, columns, file);
+    }
+    else {
+      if (build_index && size_t(end - begin) >= min_indexed_file_size) {
+        file.marks.resize(1);
+      }
+      split_csv(begin, end, members, columns, file);
+    }
+  }
+
+  // every CSV file of a pattern must have the same header as the first one,
+  // or else the columns would be spliced together by position regardless
+  void check_csv_headers(const std::vector<std::string>& filenames,
+                         const std::vector<CsvFile>& files) {
+    const CsvFile* first = nullptr;
+    size_t first_idx = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+      if (files[i].cursor == nullptr) {
+        continue;
+      }
+      if (first == nullptr) {
+        first = &files[i];
+        first_idx = i;
+      }
+      else if (csv_header(files[i]) != csv_header(*first)) {
+        throw std::logic_error("Header of " + filenames[i] +
+                               " doesn't match " + filenames[first_idx]);
+      }
+    }
+  }
+
+  // return a CSV file's header without its line ending
+  static std::string csv_header(const CsvFile& file) {
+    const char* end = file.body;
+    while (end > file.start && (end[-1] == '\n' || end[-1] == '\r')) {
+      end--;
+    }
+    return std::string(file.start, end);
+  }
+
+  // read a file's row index if it has an up-to-date one
+  bool read_index(const std::string& filename, CsvFile& file) {
+    file.indexed = read_csv_index(filename, file.index) &&
+                   file.index.file_size == uint64_t(file.end - file.start) &&
+                   file.index.entries[0].offset == file.body - file.start;
+    return file.indexed;
+  }
+
+  // infer each column's strtime format once from the first few rows
+  void infer_csv_formats(const char* begin, const char* end,
+                         const type_definition_t& members,
+                         const std::vector<size_t>& columns, CsvFile& file) {
+    file.formats.resize(members.size());
+    std::vector<std::vector<std::string>> samples(members.size());
+    RangeCursor sample_cursor(begin, end);
+    csvmonkey::CsvReader sampler(sample_cursor);
+    for (size_t i = 0; i < kInferSampleRows && sampler.read_row(); i++) {
+      auto& row = sampler.row();
+      for (size_t col: columns) {
+        if (col < row.count) {
+          samples[col].push_back(row.cells[col].as_str());
+        }
+      }
+    }
+    for (size_t col: columns) {
+      std::string format = infer_common_strtime_format(samples[col]);
+      file.formats[col] = StrtimeFormat(format);
+    }
+  }
+
+  // split text that begins on a record boundary into chunks for each worker
+  void split_csv(const char* begin, const char* end,
+                 const type_definition_t& members,
+                 const std::vector<size_t>& columns, CsvFile& file) {
+    size_t nchunks = std::min(max_threads(),
+                              size_t(end - begin) / kMinChunkSize);
+    file.bounds = split_records(begin, end, std::max(nchunks, size_t(1)));
+    allocate_chunks(members, columns, file);
+  }
+
+  // split a file's body on the rows in its index, which needs no scan for
+  // quotes and gives the exact number of rows in each chunk
+  void split_indexed(const type_definition_t& members,
+                     const std::vector<size_t>& columns, CsvFile& file) {
+    auto& entries = file.index.entries;
+    size_t nchunks = std::min(max_threads(),
+                              size_t(file.end - file.body) / kMinChunkSize);
+    nchunks = std::max(std::min(nchunks, entries.size()), size_t(1));
+    file.bounds.clear();
+    std::vector<uint64_t> rows;
+    for (size_t j = 0; j < nchunks; j++) {
+      auto& entry = entries[j * entries.size() / nchunks];
+      file.bounds.push_back(file.start + entry.offset);
+      rows.push_back(entry.row);
+    }
+    file.bounds.push_back(file.end);
+    rows.push_back(file.index.nrows);
+    allocate_chunks(members, columns, file);
+
+    for (size_t j = 0; j < nchunks; j++) {
+      for (size_t col: columns) {
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        reserve_elem(vvm_typee, file.chunks[j][col], rows[j + 1] - rows[j]);
+      }
+    }
+  }
+
+  // each chunk is parsed into its own columns
+  void allocate_chunks(const type_definition_t& members,
+                       const std::vector<size_t>& columns, CsvFile& file) {
+    size_t nchunks = file.bounds.size() - 1;
+    file.chunks.assign(nchunks, Dataframe(members.size()));
+    file.chunk_rows.resize(nchunks);
+    file.completed.resize(nchunks);
+    for (auto& chunk: file.chunks) {
+      for (size_t col: columns) {
+        chunk[col] = allocate(members[col].typee);
+      }
+    }
+    if (!file.marks.empty()) {
+      file.marks.assign(nchunks, {});
+    }
+  }
+
+  // marks for a chunk, if an index is being built
+  static std::vector<const char*>* chunk_marks(CsvFile& file, size_t j) {
+    return file.marks.empty() ? nullptr : &file.marks[j];
+  }
+
+  // a stray quote inside an unquoted cell can throw off the record
+  // boundaries, so reparse the body serially if that happened
+  void repair_csv(const type_definition_t& members,
+                  const std::vector<size_t>& columns,
+                  const RowFilter* filter, CsvFile& file) {
+    if (std::all_of(file.completed.begin(), file.completed.end() - 1,
+                    [](char c) { return c != 0; })) {
+      return;
+    }
+    for (auto& chunk: file.chunks) {
+      for (size_t col: columns) {
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        release_elem(vvm_typee, chunk[col]);
+      }
+    }
+    file.chunks.resize(1);
+    file.chunk_rows.resize(1);
+    for (size_t col: columns) {
+      file.chunks[0][col] = allocate(members[col].typee);
+    }
+    if (!file.marks.empty()) {
+      file.marks.assign(1, {});
+    }
+    load_chunk(file.bounds.front(), file.bounds.back(), members, file.formats,
+               columns, filter, file.chunks[0], file.chunk_rows[0],
+               chunk_marks(file, 0));
+  }
+
+  // index the rows that were marked while parsing a whole file, and save the
+  // index beside the file if asked (and if the file hasn't since changed)
+  void finish_index(const std::string& filename, CsvFile& file, bool save) {
+    CsvIndex& index = file.index;
+    index.entries.clear();
+    index.nrows = 0;
+    for (size_t j = 0; j < file.marks.size(); j++) {
+      for (size_t k = 0; k < file.marks[j].size(); k++) {
+        index.entries.push_back(
+          CsvIndexEntry{uint64_t(file.marks[j][k] - file.start),
+                        index.nrows + k * csv_index_stride});
+      }
+      index.nrows += file.chunk_rows[j];
+    }
+    file.indexed = true;
+
+    index.file_size = file.end - file.start;
+    uint64_t size;
+    if (save && !index.entries.empty() &&
+        stat_csv_file(filename, size, index.mtime) &&
+        size == index.file_size) {
+      write_csv_index(filename, index);
+    }
+  }
+
+  // find where a row begins; a row past the end is the end of the last row
+  const char* seek_row(CsvFile& file, uint64_t row) {
+    auto& entries = file.index.entries;
+    if (entries.empty()) {
+      return file.body;
+    }
+    auto& entry = entries[find_csv_index_entry(file.index, row)];
+    RangeCursor cursor(file.start + entry.offset, file.end);
+    csvmonkey::CsvReader reader(cursor);
+    for (uint64_t i = entry.row; i < row && reader.read_row(); i++) {
+    }
+    return cursor.buf();
+  }
+
+  // parse text that begins on a record boundary into chunks in parallel
+  void parse_csv(const char* begin, const char* end,
+                 const type_definition_t& members,
+                 const std::vector<size_t>& columns,
+                 const RowFilter* filter, CsvFile& file) {
+    split_csv(begin, end, members, columns, file);
+    parallel_for(file.chunks.size(), [&](size_t j) {
+      file.completed[j] = load_chunk(file.bounds[j], file.bounds[j + 1],
+                                     members, file.formats, columns, filter,
+                                     file.chunks[j], file.chunk_rows[j]);
+    });
+    repair_csv(members, columns, filter, file);
+  }
+
+  // move parsed chunks onto the end of columns that already have some rows;
+  // capacity grows geometrically so that repeatedly appending a few rows
+  // doesn't copy every column each time; returns the new number of rows
+  size_t splice_csv(const type_definition_t& members,
+                    const std::vector<size_t>& columns, CsvFile& file,
+                    size_t nrows, Dataframe& df) {
+    size_t total_rows = std::accumulate(file.chunk_rows.begin(),
+                                        file.chunk_rows.end(), nrows);
+    size_t capacity = std::max(total_rows, nrows + nrows / 2);
+    for (size_t col: columns) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      for (auto& chunk: file.chunks) {
+        splice_elem(vvm_typee, chunk[col], df[col], capacity);
+      }
+    }
+    return total_rows;
+  }
+
+  // what a CSV load saw, so that loading the same file into the same
+  // Dataframe again only has to parse what was appended since; the text
+  // before the offset is hashed so that any other change is caught
+  struct CsvTail {
+    std::string filename;
+    type_definition_t members;
+    std::vector<size_t> columns;
+    Dataframe df;
+    std::vector<StrtimeFormat> formats;
+    size_t header_size;  // text before the body
+    size_t size;         // size of the file when it was parsed
+    int64_t mtime;       // modification time then, in nanoseconds
+    bool settled;        // whether mtime was well before it was parsed
+    uint64_t header;     // hash of the header
+    uint64_t digest;     // hash of samples of the text before the offset
+    size_t offset;       // end of the last complete record
+    size_t nrows;        // rows before the offset
+    size_t partial;      // rows from an unterminated last line
+  };
+
+  // keyed by the Dataframe that was loaded into
+  std::unordered_map<Value, CsvTail> csv_tails_;
+
+  // hash text a word at a time (FNV-1a on 64-bit words), which is much
+  // cheaper than parsing it again; a hash may be continued with more text
+  static uint64_t hash_text(const char* begin, const char* end,
+                            uint64_t h = 14695981039346656037ULL) {
+    static const uint64_t prime = 1099511628211ULL;
+    const char* p = begin;
+    for (; end - p >= 8; p += 8) {
+      uint64_t word;
+      memcpy(&word, p, sizeof(word));
+      h = (h ^ word) * prime;
+    }
+    for (; p < end; p++) {
+      h = (h ^ uint64_t(static_cast<unsigned char>(*p))) * prime;
+    }
+    return h;
+  }
+
+  // a reload checks the end of the parsed text (which holds the last record)
+  // and this many blocks spread evenly over the rest, so that its cost
+  // doesn't grow with the file; EMPIRICAL_RELOAD_CHECK=full hashes it all
+  static const size_t kReloadTailSize = 1 << 16;
+  static const size_t kReloadBlocks = 16;
+  static const size_t kReloadBlockSize = 1 << 12;
+
+  static bool full_reload_check() {
+    char* env = getenv("EMPIRICAL_RELOAD_CHECK");
+    return env != nullptr && std::string(env) == "full";
+  }
+
+  // hash the parsed body of a CSV file, or just samples of it
+  static uint64_t hash_body(const char* body, const char* offset) {
+    size_t n = offset - body;
+    size_t tail_size = kReloadTailSize;
+    size_t block_size = kReloadBlockSize;
+    if (full_reload_check() ||
+        n <= tail_size + kReloadBlocks * block_size) {
+      return hash_text(body, offset);
+    }
+    size_t rest = n - tail_size;
+    uint64_t h = hash_text(offset - tail_size, offset);
+    for (size_t i = 0; i < kReloadBlocks; i++) {
+      const char* block = body + (rest - block_size) * i / (kReloadBlocks - 1);
+      h = hash_text(block, block + block_size, h);
+    }
+    return h;
+  }
+
+  // a file's size and modification time, to the nanosecond where the system
+  // has it; false if the file is gone
+  static bool file_status(const std::string& filename, size_t& size,
+                          int64_t& mtime) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+      return false;
+    }
+    size = size_t(st.st_size);
+#if defined(__APPLE__)
+    mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 +
+            st.st_mtimespec.tv_nsec;
+#elif defined(WIN32)
+    mtime = int64_t(st.st_mtime) * 1000000000;
+#else
+    mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+  }
 
-        // convert each column to padded strings and tranpose to rows
-        std::vector<std::string> rows(permitted_df_rows + 1);
-        for (size_t col = 0; col < cols.size(); col++) {
-          // get string of each member
-          vvm_types vvm_typee =
-            static_cast<vvm_types>(members[col].typee >> 1);
-          auto results = stringify(vvm_typee, cols[col], members[col].name,
-                                   permitted_df_rows);
+  // find the end of the last record that ends with a newline
+  static const char* last_record_end(const char* begin, const char* end) {
+    const char* last = begin;
+    size_t quotes = 0;
+    for (const char* p = begin; p < end; p++) {
+      if (*p == '"') {
+        quotes++;
+      }
+      else if (*p == '\n' && quotes % 2 == 0) {
+        last = p + 1;
+      }
+    }
+    return last;
+  }
 
-          // get size of largest string member
-          size_t max_length = 0;
-          for (auto& r: results) {
-            max_length = std::max(max_length, r.size());
-          }
-          max_length++;
+  // remember where a parsed CSV file ended; a last line without a newline
+  // may still be being written, so its rows are parsed again next time
+  void record_tail(const std::string& filename,
+                   const type_definition_t& members,
+                   const std::vector<size_t>& columns, const CsvFile& file,
+                   const Dataframe& df, size_t nrows, CsvTail& tail) {
+    if (file.body == file.start || file.body[-1] != '\n') {
+      tail.filename.clear();
+      return;
+    }
 
-          // append padded version of string members to corresponding row
-          for (size_t row = 0; row < rows.size(); row++) {
-            std::string input_str = results[row];
-            if (row == dotted_row) {
-              input_str = (max_length > 3) ? "..." : "..";
-            }
-            rows[row] += pad(input_str, max_length);
-          }
+    // the last chunk begins on a record boundary unless it was repaired
+    const char* end = file.bounds.back();
+    const char* scan = file.chunks.size() + 1 == file.bounds.size()
+                       ? file.bounds[file.bounds.size() - 2]
+                       : file.bounds.front();
+    const char* offset = last_record_end(scan, end);
+    size_t partial = 0;
+    if (offset != end) {
+      Dataframe scratch(members.size());
+      for (size_t col: columns) {
+        scratch[col] = allocate(members[col].typee);
+      }
+      load_chunk(offset, end, members, file.formats, columns, nullptr,
+                 scratch, partial);
+      for (size_t col: columns) {
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        release_elem(vvm_typee, scratch[col]);
+      }
+    }
 
-          // correct if we've exceeded the max width
-          if (rows[0].size() > max_console_cols) {
-            size_t permitted_cols = max_console_cols - 3;
-            for (auto& r: rows) {
-              r = r.substr(0, permitted_cols) + "...";
-            }
-            break;
-          }
-        }
+    tail.filename = filename;
+    tail.members = members;
+    tail.columns = columns;
+    tail.df = df;
+    tail.formats = file.formats;
+    tail.header_size = file.body - file.start;
+    if (!file_status(filename, tail.size, tail.mtime)) {
+      tail.filename.clear();
+      return;
+    }
+    // like git's "racy" index entries, a file written within the clock's
+    // granularity of being read could be written again with the same mtime
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    tail.settled = now - tail.mtime > 2000000000;
+    tail.header = hash_text(file.start, file.body);
+    tail.digest = hash_body(file.body, offset);
+    tail.offset = offset - file.start;
+    tail.nrows = nrows - partial;
+    tail.partial = partial;
+  }
 
-        // join rows by a carriage return
-        std::string result = rows[0];
-        for (size_t row = 1; row < rows.size(); row++) {
-          result += '\n' + rows[row];
-        }
-        return result;
+  // a column that is modified in place no longer matches its file
+  void forget_csv_tail(Value v) {
+    for (auto iter = csv_tails_.begin(); iter != csv_tails_.end();) {
+      Dataframe& df = iter->second.df;
+      if (iter->first == v || std::find(df.begin(), df.end(), v) != df.end()) {
+        iter = csv_tails_.erase(iter);
+      }
+      else {
+        ++iter;
       }
     }
   }
 
-  // repr operation
-  void repr(operand_t src, operand_t typee, operand_t dst) {
-    verify_is_type(typee);
-    std::string& y = get_reference<std::string>(dst);
-    y = represent(src, typee >> 2);
+  // text handed to the tokenizer must be followed by this much padding
+  static const size_t csv_padding = 16;
+
+  // a compressed CSV file is decompressed on another thread a block at a
+  // time, so that each block is parsed while the next is decompressed
+  void load_gzip(const std::string& filename,
+                 const type_definition_t& members,
+                 const std::vector<size_t>& columns,
+                 const RowFilter* filter, Dataframe& df) {
+    GzipStream stream(filename);
+    CsvFile file;
+    std::string text;
+    bool header = true;
+    bool more = true;
+    size_t nrows = 0;
+    while (more) {
+      more = stream.next(text);
+
+      // a record that continues into the next block waits for it
+      size_t size = text.size();
+      text.append(csv_padding, '\0');
+      const char* begin = text.data();
+      const char* end = more ? last_record_end(begin, begin + size)
+                             : begin + size;
+
+      // the header and formats come from the first complete records
+      if (header && begin != end) {
+        RangeCursor cursor(begin, end);
+        csvmonkey::CsvReader reader(cursor);
+        reader.read_row();
+        begin = cursor.buf();
+        infer_csv_formats(begin, end, members, columns, file);
+        header = false;
+      }
+      if (!header && begin != end) {
+        parse_csv(begin, end, members, columns, filter, file);
+        nrows = splice_csv(members, columns, file, nrows, df);
+      }
+      text.resize(size);
+      text.erase(0, end - text.data());
+    }
   }
 
-  /*** LOAD ***/
+  // the load cache's snapshot of a text file, or blank if there is none
+  std::string find_snapshot(const std::string& filename,
+                            const type_definition_t& members) {
+    std::string dir = load_cache_dir();
+    if (dir.empty() || is_columnar_file(filename) || is_arrow_file(filename)) {
+      return std::string();
+    }
+    return snapshot_filename(dir, filename, columnar_type_def(members));
+  }
 
-  // parse array of text into a given type
-  template<class T>
-  void parse_array(const std::vector<std::string>& text, Value arr) {
-    std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(arr);
-    ys.resize(text.size());
-    for (size_t i = 0; i < text.size(); i++) {
-      ys[i] = from_string<T>(text[i]);
+  // read a snapshot like any binary file; returns false if there isn't one
+  bool load_snapshot(const std::string& snapshot,
+                     const type_definition_t& members,
+                     const std::vector<size_t>& columns,
+                     const RowFilter* filter, Dataframe& df) {
+    if (snapshot.empty()) {
+      return false;
+    }
+    try {
+      if (read_columnar_type(snapshot) != columnar_type_def(members)) {
+        return false;
+      }
+    }
+    catch (std::logic_error& e) {
+      return false;
     }
+    touch_snapshot(snapshot);
+    load_columnar(snapshot, members, columns, filter, df, true);
+    return true;
   }
 
-#include <VVM/parse.h>
+  // save a whole file's columns for the next load; the snapshot is renamed
+  // into place so that a concurrent load never reads a partial one, and
+  // failing to save it isn't an error
+  void save_snapshot(const std::string& snapshot,
+                     const type_definition_t& members,
+                     const std::vector<size_t>& columns,
+                     const RowFilter* filter, Dataframe& df) {
+    if (snapshot.empty() || filter != nullptr ||
+        columns.size() != members.size()) {
+      return;
+    }
+    std::string temp = snapshot_temp_filename(snapshot);
+    try {
+      store_columnar(temp, members, df, len_df(df, members), false);
+    }
+    catch (std::logic_error& e) {
+      std::remove(temp.c_str());
+      return;
+    }
+    if (!rename_snapshot(temp, snapshot)) {
+      std::remove(temp.c_str());
+      return;
+    }
+    evict_snapshots(load_cache_dir(), load_cache_size());
+  }
 
-  // load and parse file contents
-  Dataframe loader(operand_t src, type_t typee, size_t max_rows = -1) {
+  // load and parse file contents; only the given columns are parsed, so the
+  // rest are left empty; the filename may be a pattern of several files with
+  // the same columns, which are concatenated in order
+  Dataframe loader(operand_t src, type_t typee,
+                   const std::vector<size_t>& columns,
+                   const RowFilter* filter = nullptr,
+                   CsvTail* tail = nullptr) {
     // check tag
     TypeMask mask = TypeMask(typee & 1);
     type_t num = typee >> 1;
@@ -581,55 +3474,701 @@ WRAPPER_V_S(count)
       }
       case TypeMask::kUserDefined: {
         auto members = get_type_members(typee, types_);
-        Dataframe& df = *reinterpret_cast<Dataframe*>(allocate(typee));
+        std::unique_ptr<Dataframe> allocated(
+          reinterpret_cast<Dataframe*>(allocate(typee)));
+        Dataframe& df = *allocated;
+
+        // a lone text file may have been parsed before
+        std::string pattern = get_value<std::string>(src);
+        std::vector<std::string> filenames = expand_file_pattern(pattern);
+        std::string snapshot;
+        if (filenames.size() == 1) {
+          snapshot = find_snapshot(filenames[0], members);
+          if (load_snapshot(snapshot, members, columns, filter, df)) {
+            return df;
+          }
+        }
 
-        // prepare reader
-        std::string filename = get_value<std::string>(src);
-        csvmonkey::MappedFileCursor cursor;
-        try {
-          cursor.open(filename.c_str());
+        // a single binary file doesn't need any parsing
+        if (filenames.size() == 1 && is_binary_file(filenames[0])) {
+          load_binary(filenames[0], members, columns, filter, df, true);
+          save_snapshot(snapshot, members, columns, filter, df);
+          return df;
         }
-        catch (csvmonkey::Error& e) {
-          throw std::logic_error(e.what());
+
+        // split every CSV file into chunks
+        std::vector<CsvFile> files(filenames.size());
+        std::vector<std::pair<size_t, size_t>> tasks;
+        for (size_t i = 0; i < filenames.size(); i++) {
+          if (!is_binary_file(filenames[i])) {
+            prepare_csv(filenames[i], members, columns, filter == nullptr,
+                        files[i]);
+            for (size_t j = 0; j < files[i].chunks.size(); j++) {
+              tasks.emplace_back(i, j);
+            }
+          }
         }
-        csvmonkey::CsvReader reader(cursor);
 
-        // read and transpose table
-        std::vector<std::vector<std::string>> columns(df.size());
-        bool is_header = true;
-        size_t nrows = 0;
-        while (reader.read_row() && (nrows++ < max_rows)) {
-          if (!is_header) {
-            auto& row = reader.row();
-            for (size_t col = 0; col < columns.size(); col++) {
-              columns[col].push_back(
-                col < row.count ? row.cells[col].as_str() : "");
+        check_csv_headers(filenames, files);
+
+        // parse the chunks of all files together, so that many small files
+        // are spread across workers just like one large file
+        parallel_for(tasks.size(), [&](size_t k) {
+          CsvFile& file = files[tasks[k].first];
+          size_t j = tasks[k].second;
+          file.completed[j] = load_chunk(file.bounds[j], file.bounds[j + 1],
+                                         members, file.formats, columns,
+                                         filter, file.chunks[j],
+                                         file.chunk_rows[j],
+                                         chunk_marks(file, j));
+        });
+
+        // gather every file's pieces in order; binary files are read whole
+        std::vector<Dataframe> pieces;
+        std::vector<size_t> piece_rows;
+        for (size_t i = 0; i < filenames.size(); i++) {
+          if (is_binary_file(filenames[i])) {
+            Dataframe piece(df.size());
+            for (size_t col: columns) {
+              piece[col] = allocate(members[col].typee);
+            }
+            load_binary(filenames[i], members, columns, filter, piece, false);
+            size_t nrows = 0;
+            if (!columns.empty()) {
+              size_t col = columns[0];
+              nrows = len(static_cast<vvm_types>(members[col].typee >> 1),
+                          piece[col]);
+            }
+            pieces.push_back(piece);
+            piece_rows.push_back(nrows);
+          }
+          else {
+            repair_csv(members, columns, filter, files[i]);
+            if (!files[i].marks.empty()) {
+              finish_index(filenames[i], files[i], true);
             }
+            pieces.insert(pieces.end(), files[i].chunks.begin(),
+                          files[i].chunks.end());
+            piece_rows.insert(piece_rows.end(), files[i].chunk_rows.begin(),
+                              files[i].chunk_rows.end());
           }
-          is_header = false;
         }
 
-        // parse each column
-        for (size_t col = 0; col < columns.size(); col++) {
+        // stitch the pieces together in order
+        size_t total_rows = std::accumulate(piece_rows.begin(),
+                                            piece_rows.end(), size_t(0));
+        for (size_t col: columns) {
           vvm_types vvm_typee =
             static_cast<vvm_types>(members[col].typee >> 1);
-          parse_array(vvm_typee, columns[col], df[col]);
+          for (auto& piece: pieces) {
+            splice_elem(vvm_typee, piece[col], df[col], total_rows);
+          }
         }
 
+        // a lone CSV file can be appended to and loaded again
+        if (tail != nullptr && filter == nullptr && filenames.size() == 1) {
+          record_tail(filenames[0], members, columns, files[0], df,
+                      total_rows, *tail);
+        }
+
+        save_snapshot(snapshot, members, columns, filter, df);
         return df;
       }
     }
   }
 
+  // parse only what was appended to a CSV file since it was last loaded
+  // into the Dataframe; returns false if anything else has changed
+  bool append_csv(operand_t src, type_t typee,
+                  const std::vector<size_t>& columns, Dataframe& df,
+                  CsvTail& tail) {
+    // the same file must be loaded into the same, untouched columns
+    auto members = get_type_members(typee, types_);
+    std::string pattern = get_value<std::string>(src);
+    std::vector<std::string> filenames = expand_file_pattern(pattern);
+    if (filenames.size() != 1 || filenames[0] != tail.filename ||
+        columns != tail.columns || df != tail.df ||
+        members.size() != tail.members.size()) {
+      return false;
+    }
+    for (size_t col = 0; col < members.size(); col++) {
+      if (members[col].name != tail.members[col].name ||
+          members[col].typee != tail.members[col].typee) {
+        return false;
+      }
+    }
+    for (size_t col: columns) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      if (len(vvm_typee, df[col]) != tail.nrows + tail.partial) {
+        return false;
+      }
+    }
+
+    // an untouched file has nothing new
+    size_t size;
+    int64_t mtime;
+    if (!file_status(tail.filename, size, mtime) || size < tail.offset) {
+      return false;
+    }
+    if (tail.settled && size == tail.size && mtime == tail.mtime) {
+      return true;
+    }
+
+    // otherwise the text that was already parsed must still be there; the
+    // header, the last record, and samples of the rest are compared
+    CsvFile file;
+    open_csv(tail.filename, file);
+    size = file.cursor->size();
+    const char* body = file.start + tail.header_size;
+    if (size < tail.offset ||
+        hash_text(file.start, body) != tail.header ||
+        hash_body(body, file.start + tail.offset) != tail.digest) {
+      return false;
+    }
+
+    // parse the new records, including any that were previously incomplete
+    file.body = file.start + tail.header_size;
+    file.formats = tail.formats;
+    parse_csv(file.start + tail.offset, file.start + size, members, columns,
+              nullptr, file);
+
+    // replace the incomplete rows
+    for (size_t col: columns) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      truncate_elem(vvm_typee, df[col], tail.nrows);
+    }
+    size_t total_rows = splice_csv(members, columns, file, tail.nrows, df);
+
+    record_tail(tail.filename, members, columns, file, df, total_rows, tail);
+    return true;
+  }
+
+  // load into an existing Dataframe; loading a CSV file into the same
+  // Dataframe again just appends whatever rows were added to the file
+  void reload(operand_t src, type_t typee, const std::vector<size_t>& columns,
+              Dataframe& df) {
+    auto iter = csv_tails_.find(&df);
+    if (iter != csv_tails_.end()) {
+      // appending modifies the columns in place
+      if (!mapped_columns_.empty()) {
+        materialize(df);
+      }
+      if (append_csv(src, typee, columns, df, iter->second)) {
+        return;
+      }
+    }
+    csv_tails_.erase(&df);
+    CsvTail tail;
+    Dataframe loaded = loader(src, typee, columns, nullptr, &tail);
+
+    // the old columns take the new values, since other registers may still
+    // refer to them; the new columns are released along with any mapping
+    if (df.size() == loaded.size()) {
+      auto members = get_type_members(typee, types_);
+      for (size_t col = 0; col < df.size(); col++) {
+        vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+        share_nil_free(loaded[col], df[col]);
+        share_mapping(loaded[col], df[col]);
+        replace_elem(vvm_typee, loaded[col], df[col]);
+      }
+      tail.df = df;
+    }
+    else {
+      df = loaded;
+    }
+    if (!tail.filename.empty()) {
+      csv_tails_.emplace(&df, std::move(tail));
+    }
+  }
+
+  // a Dataframe that a load is about to replace; unlike get_reference(), any
+  // mapped columns are left unread since their values are thrown away
+  Dataframe& load_destination(operand_t dst) {
+    Dataframe& y = get_lazy_reference<Dataframe>(dst);
+    if (!nil_free_columns_.empty() || !validity_columns_.empty()) {
+      forget_nil_free(y);
+    }
+    return y;
+  }
+
   // load operation
   void load(operand_t src, operand_t typee, operand_t dst) {
     verify_is_type(typee);
-    Dataframe& y = get_reference<Dataframe>(dst);
-    y = loader(src, typee >> 2);
+    Dataframe& y = load_destination(dst);
+    std::vector<size_t> columns(get_type_members(typee >> 2, types_).size());
+    std::iota(columns.begin(), columns.end(), 0);
+    reload(src, typee >> 2, columns, y);
+    check_nil_free(typee >> 2, y);
+  }
+
+  // find the columns of a Dataframe type that a projection refers to
+  std::vector<size_t> project_columns(type_t typee, type_t proj_type) {
+    verify_user_defined(typee);
+    verify_user_defined(proj_type);
+
+    auto members = get_type_members(typee, types_);
+    auto proj_members = get_type_members(proj_type, types_);
+
+    // index member names
+    std::unordered_map<std::string, size_t> m(members.size());
+    for (size_t i = 0; i < members.size(); i++) {
+      m[members[i].name] = i;
+    }
+
+    // look-up projected names in file order
+    std::vector<size_t> columns;
+    for (auto& pm: proj_members) {
+      auto iter = m.find(pm.name);
+      if (iter == m.end()) {
+        std::string msg = "Unknown projected column " + pm.name;
+        throw std::logic_error(msg);
+      }
+      columns.push_back(iter->second);
+    }
+    std::sort(columns.begin(), columns.end());
+    return columns;
+  }
+
+  // load operation that only parses the projected columns
+  void loadproj(operand_t src, operand_t typee, operand_t proj_type,
+                operand_t dst) {
+    verify_is_type(typee);
+    verify_is_type(proj_type);
+    Dataframe& y = load_destination(dst);
+    auto columns = project_columns(typee >> 2, proj_type >> 2);
+    reload(src, typee >> 2, columns, y);
+
+    // the other columns are nil, so that every column has the same length
+    auto members = get_type_members(typee >> 2, types_);
+    size_t nrows = 0;
+    if (!columns.empty()) {
+      size_t col = columns[0];
+      nrows = len(static_cast<vvm_types>(members[col].typee >> 1), y[col]);
+    }
+    for (size_t col = 0; col < members.size(); col++) {
+      if (!std::binary_search(columns.begin(), columns.end(), col)) {
+        fill_elem(static_cast<vvm_types>(members[col].typee >> 1), y[col],
+                  nrows);
+      }
+    }
+    check_nil_free(typee >> 2, y);
+  }
+
+  // load operation that only keeps rows whose column matches a constant
+  void loadwhere(operand_t src, operand_t typee, operand_t column,
+                 operand_t cmp, operand_t value, operand_t dst) {
+    verify_is_type(typee);
+    Dataframe& y = load_destination(dst);
+    std::vector<size_t> columns(get_type_members(typee >> 2, types_).size());
+    std::iota(columns.begin(), columns.end(), 0);
+    RowFilter filter{size_t(get_value<int64_t>(column)),
+                     Comparison(get_value<int64_t>(cmp)), value};
+    if (filter.column >= columns.size()) {
+      std::ostringstream oss;
+      oss << "Invalid column " << filter.column << " for loadwhere";
+      throw std::logic_error(oss.str());
+    }
+    y = loader(src, typee >> 2, columns, &filter);
+    check_nil_free(typee >> 2, y);
+  }
+
+  // load a range of rows from a CSV file; the first row is found with the
+  // file's row index, which is built if the file doesn't have one yet
+  Dataframe rows_loader(operand_t src, type_t typee, uint64_t first,
+                        uint64_t count) {
+    verify_user_defined(typee);
+    auto members = get_type_members(typee, types_);
+    std::vector<size_t> columns(members.size());
+    std::iota(columns.begin(), columns.end(), 0);
+    Dataframe& df = *reinterpret_cast<Dataframe*>(allocate(typee));
+
+    std::string pattern = get_value<std::string>(src);
+    std::vector<std::string> filenames = expand_file_pattern(pattern);
+    if (filenames.size() != 1 || is_binary_file(filenames[0])) {
+      std::string msg = "Can only load rows from a single CSV file: " +
+                        pattern;
+      throw std::logic_error(msg);
+    }
+    const std::string& filename = filenames[0];
+
+    // skip the header
+    CsvFile file;
+    open_csv(filename, file);
+    csvmonkey::CsvReader reader(*file.cursor);
+    reader.read_row();
+    file.body = file.cursor->buf();
+    infer_csv_formats(file.body, file.end, members, columns, file);
+
+    // index every row without parsing any cells
+    if (!read_index(filename, file)) {
+      file.marks.resize(1);
+      split_csv(file.body, file.end, members, {}, file);
+      parallel_for(file.chunks.size(), [&](size_t j) {
+        file.completed[j] = load_chunk(file.bounds[j], file.bounds[j + 1],
+                                       members, file.formats, {}, nullptr,
+                                       file.chunks[j], file.chunk_rows[j],
+                                       chunk_marks(file, j));
+      });
+      repair_csv(members, {}, nullptr, file);
+      size_t size = file.end - file.body;
+      finish_index(filename, file, size >= min_indexed_file_size);
+      file.marks.clear();
+    }
+
+    // parse just the requested rows
+    uint64_t last = std::min(first + std::min(count, file.index.nrows),
+                             file.index.nrows);
+    first = std::min(first, last);
+    parse_csv(seek_row(file, first), seek_row(file, last), members, columns,
+              nullptr, file);
+    splice_csv(members, columns, file, 0, df);
+    return df;
+  }
+
+  // load operation that only parses a range of rows
+  void loadrows(operand_t src, operand_t typee, operand_t first,
+                operand_t count, operand_t dst) {
+    verify_is_type(typee);
+    Dataframe& y = load_destination(dst);
+    int64_t x = get_value<int64_t>(first);
+    int64_t n = get_value<int64_t>(count);
+    if (x < 0 || n < 0) {
+      throw std::logic_error("Invalid row range for loadrows");
+    }
+    y = rows_loader(src, typee >> 2, uint64_t(x), uint64_t(n));
+    check_nil_free(typee >> 2, y);
   }
 
   /*** STORE ***/
 
+  // columns still mapped from a file must be copied before it's replaced
+  void copy_mapped_columns(const std::string& filename) {
+    for (auto iter = mapped_columns_.begin(); iter != mapped_columns_.end();) {
+      MappedColumn& mc = iter->second;
+      if (mc.filename == filename) {
+        read_column(mc.typee, mc.begin, mc.end, mc.nrows, iter->first);
+        iter = mapped_columns_.erase(iter);
+      }
+      else {
+        ++iter;
+      }
+    }
+  }
+
+  // the type definition recorded by the native binary format, which has
+  // each member's scalar type (which alternate with the vector types);
+  // unnamed members are named like a CSV's
+  std::string columnar_type_def(const type_definition_t& members) {
+    std::ostringstream oss;
+    for (size_t col = 0; col < members.size(); col++) {
+      size_t vvm_typee = (members[col].typee >> 1) & ~size_t(1);
+      if (col > 0) {
+        oss << ", ";
+      }
+      if (members[col].name.empty()) {
+        oss << "unnamed_" << col;
+      }
+      else {
+        oss << members[col].name;
+      }
+      oss << ": " << empirical_type_strings[vvm_typee];
+    }
+    return oss.str();
+  }
+
+  // a failed write (eg., a full disk) mustn't leave a truncated file behind
+  // as if it were stored
+  static void check_stored(std::ofstream& out, const std::string& filename) {
+    if (!out) {
+      out.close();
+      std::remove(filename.c_str());
+      std::string msg = "Unable to write to " + filename;
+      throw std::logic_error(msg);
+    }
+  }
+
+  // store a Dataframe in the native binary format, compressing the columns
+  // if requested; mapped columns must already be copied from the file
+  void store_columnar(const std::string& filename,
+                      const type_definition_t& members, Dataframe& cols,
+                      size_t nrows, bool compressed) {
+    ColumnarHeader header;
+    header.nrows = nrows;
+    header.compressed = compressed;
+    header.type_def = columnar_type_def(members);
+
+    // write the columns after space for the header, then fill-in the header
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+      std::string msg = "Unable to write to " + filename;
+      throw std::logic_error(msg);
+    }
+    size_t position = columnar_header_size(header.type_def, cols.size());
+    out << std::string(position, '\0');
+    for (size_t col = 0; col < cols.size(); col++) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      header.offsets.push_back(position);
+      size_t nbytes = compressed
+                    ? write_compressed(vvm_typee, out, cols[col], position)
+                    : write_column(vvm_typee, out, cols[col]);
+      size_t padding = columnar_padding(nbytes);
+      out << std::string(padding, '\0');
+      position += nbytes + padding;
+      check_stored(out, filename);
+    }
+    out.seekp(0);
+    out << write_columnar_header(header);
+    out.flush();
+    check_stored(out, filename);
+    out.close();
+  }
+
+  // store a Dataframe in the Arrow IPC format as a single record batch;
+  // mapped columns must already be copied from the file
+  void store_arrow(const std::string& filename,
+                   const type_definition_t& members, Dataframe& cols,
+                   size_t nrows) {
+    // describe every column and lay out its buffers within the batch's body
+    std::vector<ArrowField> fields;
+    ArrowBatch batch;
+    batch.nrows = int64_t(nrows);
+    batch.body_size = 0;
+    for (size_t col = 0; col < cols.size(); col++) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      ArrowField field = arrow_field(vvm_typee, cols[col]);
+      field.name = members[col].name.empty()
+                 ? "unnamed_" + std::to_string(col) : members[col].name;
+      fields.push_back(field);
+
+      ArrowNode node;
+      std::vector<int64_t> lengths;
+      arrow_lengths(vvm_typee, cols[col], field, node, lengths);
+      batch.nodes.push_back(node);
+      for (int64_t length: lengths) {
+        batch.buffers.push_back(ArrowBuffer{int64_t(batch.body_size), length});
+        batch.body_size += length + arrow_padding(length);
+      }
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+      std::string msg = "Unable to write to " + filename;
+      throw std::logic_error(msg);
+    }
+    std::string header = write_arrow_header(fields);
+    std::string message = write_arrow_batch(batch);
+    uint64_t position = header.size();
+    batch.body = position + message.size();
+    out << header << message;
+    for (size_t col = 0; col < cols.size(); col++) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      write_arrow(vvm_typee, out, cols[col], fields[col], batch.nodes[col]);
+      check_stored(out, filename);
+    }
+    out << write_arrow_footer(fields, {batch}, {position});
+    out.flush();
+    check_stored(out, filename);
+    out.close();
+  }
+
+  // number of rows formatted at a time when storing a CSV file
+  static const size_t store_block_rows = 1 << 16;
+
+  // store a Dataframe as CSV; rows are formatted a block at a time, so memory
+  // doesn't grow with the size of the table; columns are formatted in
+  // parallel unless the caller is already a worker
+  void store_csv(const std::string& filename,
+                 const type_definition_t& members, Dataframe& cols,
+                 size_t nrows, bool parallel = true) {
+    auto for_each_col = [&](auto f) {
+      if (parallel) {
+        parallel_for(cols.size(), f);
+      }
+      else {
+        for (size_t col = 0; col < cols.size(); col++) {
+          f(col);
+        }
+      }
+    };
+
+    std::ofstream out(filename);
+    if (!out) {
+      std::string msg = "Unable to write to " + filename;
+      throw std::logic_error(msg);
+    }
+
+    // header row
+    std::string buffer;
+    for (size_t col = 0; col < cols.size(); col++) {
+      if (col > 0) {
+        buffer += ',';
+      }
+      buffer += members[col].name;
+    }
+    buffer += '\n';
+
+    // every row of a column is trimmed the same, so find that first
+    std::vector<size_t> trims(cols.size());
+    for_each_col([&](size_t col) {
+      vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+      trims[col] = column_trim(vvm_typee, cols[col]);
+    });
+
+    // format each block's columns in parallel, then join them into rows
+    std::vector<std::vector<std::string>> cells(cols.size());
+    for (size_t begin = 0; begin < nrows; begin += store_block_rows) {
+      size_t end = std::min(begin + store_block_rows, nrows);
+      for_each_col([&](size_t col) {
+        vvm_types vvm_typee =
+          static_cast<vvm_types>(members[col].typee >> 1);
+        format_cells(vvm_typee, cols[col], begin, end, trims[col],
+                     cells[col]);
+      });
+      for (size_t row = 0; row < end - begin; row++) {
+        for (size_t col = 0; col < cols.size(); col++) {
+          if (col > 0) {
+            buffer += ',';
+          }
+          buffer += cells[col][row];
+        }
+        buffer += '\n';
+      }
+      out.write(buffer.data(), buffer.size());
+      check_stored(out, filename);
+      buffer.clear();
+    }
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    check_stored(out, filename);
+    out.close();
+  }
+
+  // store a Dataframe as one file per unique key, where the key members are
+  // named in the filename's braces ("daily/{symbol}.csv"); rows are
+  // categorized once, then each partition is written on a worker thread
+  void store_partitioned(const std::string& pattern,
+                         const type_definition_t& members, Dataframe& cols,
+                         size_t nrows) {
+    // find the key columns
+    std::vector<std::string> keys = partition_keys(pattern);
+    std::vector<size_t> key_cols;
+    for (auto& key: keys) {
+      size_t col = 0;
+      while (col < members.size() && members[col].name != key) {
+        col++;
+      }
+      if (col == members.size()) {
+        std::string msg = "Invalid member " + key + " in " + pattern;
+        throw std::logic_error(msg);
+      }
+      key_cols.push_back(col);
+    }
+    if (nrows == 0) {
+      return;
+    }
+
+    // get labels from the keys, skipping any repeated member
+    std::vector<int64_t> labs(nrows, 0);
+    int64_t length = 1;
+    std::vector<bool> seen(members.size(), false);
+    for (size_t col: key_cols) {
+      if (!seen[col]) {
+        vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+        length = categorize(vvm_typee, cols[col], labs, length);
+        seen[col] = true;
+      }
+    }
+
+    // group the label indices
+    std::vector<std::vector<int64_t>> igroup(length);
+    std::vector<int64_t> ig_count(length, 0);
+    for (size_t i = 0; i < nrows; i++) {
+      ig_count[labs[i]]++;
+    }
+    for (int64_t i = 0; i < length; i++) {
+      igroup[i].resize(ig_count[i]);
+      ig_count[i] = 0;
+    }
+    for (size_t i = 0; i < nrows; i++) {
+      int64_t j = labs[i];
+      igroup[j][ig_count[j]++] = i;
+    }
+
+    // name each partition's file after its first row's keys
+    std::vector<std::string> filenames(length);
+    std::vector<std::string> cell;
+    for (int64_t i = 0; i < length; i++) {
+      std::vector<std::string> values;
+      for (size_t col: key_cols) {
+        vvm_types vvm_typee = static_cast<vvm_types>(members[col].typee >> 1);
+        size_t row = igroup[i][0];
+        format_cells(vvm_typee, cols[col], row, row + 1, 0, cell);
+        values.push_back(cell[0]);
+      }
+      filenames[i] = fill_partition(pattern, values);
+      copy_mapped_columns(filenames[i]);
+    }
+
+    // distinct keys may still escape to the same name (like a nil key and
+    // "nil"), which would have one partition overwrite another
+    std::vector<std::string> sorted_names(filenames);
+    std::sort(sorted_names.begin(), sorted_names.end());
+    auto dup = std::adjacent_find(sorted_names.begin(), sorted_names.end());
+    if (dup != sorted_names.end()) {
+      std::string msg = "Several partitions would be stored in " + *dup;
+      throw std::logic_error(msg);
+    }
+    for (auto& filename: filenames) {
+      make_parent_dirs(filename);
+    }
+
+    // split and write a batch of partitions at a time, so only one batch's
+    // copy of the rows is held at once; columns are released between batches
+    // since that touches the (shared) mapped columns
+    size_t batch = max_threads();
+    for (size_t first = 0; first < size_t(length); first += batch) {
+      size_t last = std::min(first + batch, size_t(length));
+      std::vector<Dataframe> parts(last - first, Dataframe(cols.size()));
+      auto release_parts = [&]() {
+        for (auto& part: parts) {
+          for (size_t col = 0; col < part.size(); col++) {
+            vvm_types vvm_typee =
+              static_cast<vvm_types>(members[col].typee >> 1);
+            release_elem(vvm_typee, part[col]);
+          }
+        }
+      };
+      try {
+        parallel_for(last - first, [&](size_t k) {
+          size_t i = first + k;
+          std::vector<std::vector<int64_t>> rows(1);
+          rows[0].swap(igroup[i]);
+          std::vector<Dataframe*> tgt(1, &parts[k]);
+          for (size_t col = 0; col < cols.size(); col++) {
+            vvm_types vvm_typee =
+              static_cast<vvm_types>(members[col].typee >> 1);
+            split_col(vvm_typee, col, rows, cols, tgt);
+          }
+          if (is_columnar_file(filenames[i])) {
+            store_columnar(filenames[i], members, parts[k], rows[0].size(),
+                           is_compressed_file(filenames[i]));
+          }
+          else if (is_arrow_file(filenames[i])) {
+            store_arrow(filenames[i], members, parts[k], rows[0].size());
+          }
+          else {
+            store_csv(filenames[i], members, parts[k], rows[0].size(), false);
+          }
+        });
+      }
+      catch (...) {
+        release_parts();
+        throw;
+      }
+      release_parts();
+    }
+  }
+
   // store data to a file
   void storer(type_t typee, operand_t src, std::string filename) {
     // check tag
@@ -642,35 +4181,35 @@ WRAPPER_V_S(count)
         throw std::logic_error(oss.str());
       }
       case TypeMask::kUserDefined: {
+        // storing doesn't modify the columns, so they keep their nil-free
+        // marks and validity bitmaps
         auto members = get_type_members(typee, types_);
-        Dataframe& cols = get_reference<Dataframe>(src);
+        Dataframe& cols = get_lazy_reference<Dataframe>(src);
+        if (!mapped_columns_.empty()) {
+          materialize(cols);
+        }
         const size_t total_df_rows = len_df(cols, members);
 
-        // convert each column to strings and tranpose to rows
-        std::vector<std::string> rows(total_df_rows + 1);
-        for (size_t col = 0; col < cols.size(); col++) {
-          // get string of each member
-          // TODO will need to escape the separator
-          vvm_types vvm_typee =
-            static_cast<vvm_types>(members[col].typee >> 1);
-          auto results = stringify(vvm_typee, cols[col], members[col].name,
-                                   total_df_rows);
-
-          // append string members to corresponding row
-          for (size_t row = 0; row < rows.size(); row++) {
-            if (col > 0) {
-              rows[row] += ',';
-            }
-            rows[row] += results[row];
-          }
+        // members named in the filename split the rows across many files
+        if (is_partition_pattern(filename)) {
+          store_partitioned(filename, members, cols, total_df_rows);
+          return;
         }
 
-        // write rows to file
-        std::ofstream out(filename);
-        for (auto& row: rows) {
-          out << row << '\n';
+        // binary files don't need any formatting
+        if (is_columnar_file(filename)) {
+          copy_mapped_columns(filename);
+          store_columnar(filename, members, cols, total_df_rows,
+                         is_compressed_file(filename));
+          return;
         }
-        out.close();
+        if (is_arrow_file(filename)) {
+          copy_mapped_columns(filename);
+          store_arrow(filename, members, cols, total_df_rows);
+          return;
+        }
+
+        store_csv(filename, members, cols, total_df_rows);
       }
     }
   }
@@ -713,9 +4252,19 @@ WRAPPER_V_S(count)
   // vector assign (builtin) logic
   template<class T>
   void assign_builtin_v(operand_t src, operand_t dst) {
+    bool nil_free = is_nil_free(src);
+    const Validity* found = get_validity(src);
+    Validity validity = (found != nullptr) ? *found : Validity();
     std::vector<T>& xs = get_reference<std::vector<T>>(src);
     std::vector<T>& ys = get_reference<std::vector<T>>(dst);
+    if (!csv_tails_.empty()) {
+      forget_csv_tail(&ys);
+    }
     ys = xs;
+    note_nil_free(xs, nil_free);
+    note_nil_free(ys, nil_free);
+    mark_validity(&xs, validity);
+    mark_validity(&ys, std::move(validity));
   }
 
 #include <VVM/assign.h>
@@ -731,14 +4280,19 @@ WRAPPER_V_S(count)
       }
       case TypeMask::kUserDefined: {
         auto members = get_type_members(typee, types_);
-        Dataframe& src_cols = get_reference<Dataframe>(src);
-        Dataframe& dst_cols = get_reference<Dataframe>(dst);
+        Dataframe& src_cols = get_lazy_reference<Dataframe>(src);
+        Dataframe& dst_cols = get_lazy_reference<Dataframe>(dst);
+        if (!csv_tails_.empty()) {
+          forget_csv_tail(&dst_cols);
+        }
 
-        // assign each column
+        // assign each column; mapped columns just share the mapping
         for (size_t col = 0; col < src_cols.size(); col++) {
           vvm_types vvm_typee =
             static_cast<vvm_types>(members[col].typee >> 1);
           assign_value(vvm_typee, src_cols[col], dst_cols[col]);
+          share_mapping(src_cols[col], dst_cols[col]);
+          share_nil_free(src_cols[col], dst_cols[col]);
         }
       }
     }
@@ -757,6 +4311,9 @@ WRAPPER_V_S(count)
   void append_s(operand_t left, operand_t right) {
     T x = get_value<T>(left);
     std::vector<T>& ys = get_reference<std::vector<T>>(right);
+    if (!csv_tails_.empty()) {
+      forget_csv_tail(&ys);
+    }
     ys.push_back(x);
   }
 
@@ -811,7 +4368,7 @@ WRAPPER_V_S(count)
   template<class T, class U>
   typename std::enable_if<std::is_same<U, bool>::value, void>::type
   where_elem(Value src, const std::vector<U>& tr, Value dst) {
-    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    ColumnView<T> xs = view_value<T>(src);
     std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
     if (xs.size() != tr.size()) {
       throw std::runtime_error("Mismatch array lengths");
@@ -835,7 +4392,7 @@ WRAPPER_V_S(count)
   template<class T, class U>
   typename std::enable_if<!std::is_same<U, bool>::value, void>::type
   where_elem(Value src, const std::vector<U>& idxs, Value dst) {
-    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    ColumnView<T> xs = view_value<T>(src);
     std::vector<T>& ys = *reinterpret_cast<std::vector<T>*>(dst);
     ys.resize(idxs.size());
     for (size_t i = 0; i < idxs.size(); i++) {
@@ -862,7 +4419,7 @@ WRAPPER_V_S(count)
         auto members = get_type_members(typee, types_);
 
         // for each column, copy only the desired elements
-        Dataframe& table = get_reference<Dataframe>(src);
+        Dataframe& table = get_lazy_reference<Dataframe>(src);
         Dataframe& columns = *reinterpret_cast<Dataframe*>(allocate(typee));
 
         for (size_t col = 0; col < columns.size(); col++) {
@@ -958,12 +4515,16 @@ WRAPPER_V_S(count)
     V*& ptr = *get_register<V>(result);
     // C++'s std::vector<bool> prohibits pointers to elements
     ptr = &xs[y];
+    pinned_columns_.insert(&xs);
   }
 
   // scalar del operation
   template<class T>
   void del_s(operand_t tgt) {
     T*& ptr = *get_register<T>(tgt);
+    if (!csv_tails_.empty()) {
+      forget_csv_tail(ptr);
+    }
     delete ptr;
     ptr = nullptr;
   }
@@ -972,6 +4533,12 @@ WRAPPER_V_S(count)
   template<class T>
   void del_v(operand_t tgt) {
     std::vector<T>*& ptr = *get_register<std::vector<T>>(tgt);
+    unmap_value(ptr);
+    forget_nil_free_value(ptr);
+    unpin_value(ptr);
+    if (!csv_tails_.empty()) {
+      forget_csv_tail(ptr);
+    }
     delete ptr;
     ptr = nullptr;
   }
@@ -1009,7 +4576,10 @@ WRAPPER_V_S(count)
 
   // member operation
   void member(operand_t value, operand_t index, operand_t result) {
-    Dataframe& xs = get_reference<Dataframe>(value);
+    // handing out a column doesn't modify it, so it stays nil-free and (if
+    // mapped) is left in the file; mappings are keyed by the column itself,
+    // so the result register reads it in place too
+    Dataframe& xs = get_lazy_reference<Dataframe>(value);
     int64_t y = get_value<int64_t>(index);
     if (y >= xs.size()) {
        throw std::runtime_error("Member index out of bounds");
@@ -1104,6 +4674,16 @@ WRAPPER_V_S(count)
     // having returned from the user's function call, save result
     Value ret_value = get_ptr(fd.rettype, ret_op_);
 
+    // the function's own registers are gone, so forget what was loaded into
+    // them (arguments belong to the caller)
+    if (!csv_tails_.empty()) {
+      for (size_t i = np; i < local_registers_.size(); i++) {
+        if (local_registers_[i] != ret_value) {
+          csv_tails_.erase(local_registers_[i]);
+        }
+      }
+    }
+
     // restore frame information
     local_registers_ = std::move(saved_registers);
     ip_ = saved_ip;
@@ -1117,8 +4697,7 @@ WRAPPER_V_S(count)
 
   template<class T>
   int64_t len(Value src) {
-    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
-    return xs.size();
+    return view_value<T>(src).size();
   }
 
 #include <VVM/len.h>
@@ -1135,7 +4714,7 @@ WRAPPER_V_S(count)
   // sort array by index
   template<class T>
   void isort_elem(Value src, std::vector<int64_t>& indices) {
-    std::vector<T>& xs = *reinterpret_cast<std::vector<T>*>(src);
+    ColumnView<T> xs = view_value<T>(src);
     std::stable_sort(std::begin(indices), std::end(indices),
                      [&](size_t a, size_t b) {return xs[a] < xs[b];});
   }
@@ -1156,7 +4735,7 @@ WRAPPER_V_S(count)
         auto members = get_type_members(typee, types_);
 
         // pre-arrange the indices as 0..n-1
-        Dataframe& table = get_reference<Dataframe>(src);
+        Dataframe& table = get_lazy_reference<Dataframe>(src);
         int64_t n = len_df(table, members);
         std::vector<int64_t> indices(n);
         std::iota(std::begin(indices), std::end(indices), 0);
@@ -0,0 +1,764 @@
+/*
+ * Arrow -- Arrow IPC file format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <VVM/utils/arrow.hpp>
+
+namespace VVM {
+// identifies the format at the start and end of a file
+static const char arrow_magic[] = "ARROW1";
+static const size_t magic_size = 6;
+
+// prefix of every message since Arrow 0.15, and the end-of-stream marker
+static const uint32_t continuation = 0xFFFFFFFF;
+
+// metadata version V5 (Arrow 1.0 onward), which the schema numbers 4
+static const int16_t metadata_version = 4;
+
+// message header types
+static const uint8_t schema_message = 1;
+static const uint8_t batch_message = 3;
+
+// check whether a filename ends with an extension
+static bool has_extension(const std::string& filename, const std::string& ext) {
+  return filename.size() > ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// check whether a file should be in the Arrow format
+bool is_arrow_file(const std::string& filename) {
+  return has_extension(filename, ".arrow") ||
+         has_extension(filename, ".feather");
+}
+
+// number of buffers that a field has in each record batch
+size_t arrow_buffer_count(ArrowType type) {
+  switch (type) {
+    case ArrowType::kUtf8:
+    case ArrowType::kLargeUtf8:
+      return 3;
+    default:
+      return 2;
+  }
+}
+
+// number of bytes needed to bring a buffer to an eight-byte boundary
+size_t arrow_padding(size_t n) {
+  return (8 - n % 8) % 8;
+}
+
+// throw an error for a malformed file
+[[noreturn]] static void bad_file(const std::string& reason) {
+  throw std::logic_error("Invalid Arrow file: " + reason);
+}
+
+/*** flatbuffer writing ***/
+
+// Flatbuffers are normally built back-to-front; here a tree of nodes is
+// serialized front-to-back instead, so that every offset points forward and
+// can be patched once its target is written.
+
+struct FlatNode;
+typedef std::shared_ptr<FlatNode> FlatPtr;
+
+// a table's field: either a scalar or an offset to a child node
+struct FlatField {
+  size_t id;
+  size_t size;
+  uint64_t bits;
+  FlatPtr child;
+};
+
+struct FlatNode {
+  enum class Kind {kTable, kString, kTables, kStructs} kind;
+  std::vector<FlatField> fields;
+  std::string bytes;
+  std::vector<FlatPtr> items;
+  size_t count;
+};
+
+static FlatPtr flat_table() {
+  FlatPtr node = std::make_shared<FlatNode>();
+  node->kind = FlatNode::Kind::kTable;
+  return node;
+}
+
+static FlatPtr flat_string(const std::string& s) {
+  FlatPtr node = std::make_shared<FlatNode>();
+  node->kind = FlatNode::Kind::kString;
+  node->bytes = s;
+  return node;
+}
+
+static FlatPtr flat_tables(const std::vector<FlatPtr>& items) {
+  FlatPtr node = std::make_shared<FlatNode>();
+  node->kind = FlatNode::Kind::kTables;
+  node->items = items;
+  return node;
+}
+
+// structs must be a multiple of eight bytes (as all of Arrow's are)
+static FlatPtr flat_structs(const std::string& bytes, size_t count) {
+  FlatPtr node = std::make_shared<FlatNode>();
+  node->kind = FlatNode::Kind::kStructs;
+  node->bytes = bytes;
+  node->count = count;
+  return node;
+}
+
+template<class T>
+static void add_scalar(FlatPtr table, size_t id, T x) {
+  uint64_t bits = 0;
+  memcpy(&bits, &x, sizeof(T));
+  table->fields.push_back(FlatField{id, sizeof(T), bits, nullptr});
+}
+
+static void add_child(FlatPtr table, size_t id, FlatPtr child) {
+  table->fields.push_back(FlatField{id, sizeof(uint32_t), 0, child});
+}
+
+template<class T>
+static void put(std::string& buffer, T x) {
+  buffer.append(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+class FlatWriter {
+  std::string buffer_;
+
+  // pad so that the position plus extra is aligned
+  void align(size_t alignment, size_t extra = 0) {
+    while ((buffer_.size() + extra) % alignment != 0) {
+      buffer_ += '\0';
+    }
+  }
+
+  // point the offset at a position to a target
+  void patch(size_t position, size_t target) {
+    uint32_t offset = uint32_t(target - position);
+    memcpy(&buffer_[position], &offset, sizeof(offset));
+  }
+
+  size_t write_table(const FlatNode& node) {
+    // lay out the fields by decreasing size so each is aligned
+    std::vector<FlatField> fields = node.fields;
+    std::stable_sort(fields.begin(), fields.end(),
+                     [](const FlatField& a, const FlatField& b) {
+                       return a.size > b.size;
+                     });
+    size_t alignment = sizeof(int32_t);
+    size_t table_size = sizeof(int32_t);
+    size_t nslots = 0;
+    std::vector<size_t> locations;
+    for (auto& field: fields) {
+      alignment = std::max(alignment, field.size);
+      table_size += (field.size - table_size % field.size) % field.size;
+      locations.push_back(table_size);
+      table_size += field.size;
+      nslots = std::max(nslots, field.id + 1);
+    }
+
+    // the vtable comes first, then the table refers back to it
+    align(sizeof(uint16_t));
+    size_t vtable = buffer_.size();
+    std::vector<uint16_t> slots(nslots, 0);
+    for (size_t i = 0; i < fields.size(); i++) {
+      slots[fields[i].id] = uint16_t(locations[i]);
+    }
+    put<uint16_t>(buffer_, uint16_t(sizeof(uint16_t) * (nslots + 2)));
+    put<uint16_t>(buffer_, uint16_t(table_size));
+    for (uint16_t slot: slots) {
+      put<uint16_t>(buffer_, slot);
+    }
+    align(alignment);
+    size_t table = buffer_.size();
+    buffer_.resize(table + table_size, '\0');
+    int32_t soffset = int32_t(table - vtable);
+    memcpy(&buffer_[table], &soffset, sizeof(soffset));
+    for (size_t i = 0; i < fields.size(); i++) {
+      if (!fields[i].child) {
+        memcpy(&buffer_[table + locations[i]], &fields[i].bits,
+               fields[i].size);
+      }
+    }
+
+    // children follow their parent
+    for (size_t i = 0; i < fields.size(); i++) {
+      if (fields[i].child) {
+        size_t child = write(*fields[i].child);
+        patch(table + locations[i], child);
+      }
+    }
+    return table;
+  }
+
+ public:
+  // write a node, returning its position
+  size_t write(const FlatNode& node) {
+    switch (node.kind) {
+      case FlatNode::Kind::kTable:
+        return write_table(node);
+      case FlatNode::Kind::kString: {
+        align(sizeof(uint32_t));
+        size_t position = buffer_.size();
+        put<uint32_t>(buffer_, uint32_t(node.bytes.size()));
+        buffer_ += node.bytes;
+        buffer_ += '\0';
+        return position;
+      }
+      case FlatNode::Kind::kTables: {
+        align(sizeof(uint32_t));
+        size_t position = buffer_.size();
+        put<uint32_t>(buffer_, uint32_t(node.items.size()));
+        buffer_.resize(position + 4 + 4 * node.items.size(), '\0');
+        for (size_t i = 0; i < node.items.size(); i++) {
+          size_t item = write(*node.items[i]);
+          patch(position + 4 + 4 * i, item);
+        }
+        return position;
+      }
+      case FlatNode::Kind::kStructs: {
+        align(8, sizeof(uint32_t));
+        size_t position = buffer_.size();
+        put<uint32_t>(buffer_, uint32_t(node.count));
+        buffer_ += node.bytes;
+        return position;
+      }
+    }
+    return 0;
+  }
+
+  // serialize a root table, padded to eight bytes
+  std::string finish(const FlatNode& root) {
+    buffer_.assign(sizeof(uint32_t), '\0');
+    size_t position = write(root);
+    patch(0, position);
+    align(8);
+    return buffer_;
+  }
+};
+
+// describe a field's type
+static FlatPtr type_table(const ArrowField& field) {
+  FlatPtr type = flat_table();
+  switch (field.type) {
+    case ArrowType::kInt:
+      add_scalar<int32_t>(type, 0, field.bit_width);
+      add_scalar<uint8_t>(type, 1, field.is_signed);
+      break;
+    case ArrowType::kFloatingPoint:
+      add_scalar<int16_t>(type, 0, field.bit_width == 32 ? 1 : 2);
+      break;
+    case ArrowType::kTime:
+      add_scalar<int16_t>(type, 0, field.unit);
+      add_scalar<int32_t>(type, 1, field.bit_width);
+      break;
+    case ArrowType::kDate:
+    case ArrowType::kTimestamp:
+    case ArrowType::kDuration:
+      add_scalar<int16_t>(type, 0, field.unit);
+      break;
+    default:
+      break;
+  }
+  return type;
+}
+
+// describe a table's columns
+static FlatPtr schema_table(const std::vector<ArrowField>& fields) {
+  std::vector<FlatPtr> items;
+  for (auto& field: fields) {
+    FlatPtr item = flat_table();
+    add_child(item, 0, flat_string(field.name));
+    add_scalar<uint8_t>(item, 1, 1);
+    add_scalar<uint8_t>(item, 2, uint8_t(field.type));
+    add_child(item, 3, type_table(field));
+    add_child(item, 5, flat_tables({}));
+    items.push_back(item);
+  }
+  FlatPtr schema = flat_table();
+  add_scalar<int16_t>(schema, 0, 0);
+  add_child(schema, 1, flat_tables(items));
+  return schema;
+}
+
+// wrap a message's flatbuffer with its continuation and size
+static std::string encapsulate(const std::string& flatbuffer) {
+  std::string buffer;
+  put<uint32_t>(buffer, continuation);
+  put<int32_t>(buffer, int32_t(flatbuffer.size()));
+  return buffer + flatbuffer;
+}
+
+// serialize the start of a file, through the schema message
+std::string write_arrow_header(const std::vector<ArrowField>& fields) {
+  FlatPtr message = flat_table();
+  add_scalar<int16_t>(message, 0, metadata_version);
+  add_scalar<uint8_t>(message, 1, schema_message);
+  add_child(message, 2, schema_table(fields));
+  add_scalar<int64_t>(message, 3, 0);
+
+  std::string buffer(arrow_magic, magic_size);
+  buffer.append(2, '\0');
+  return buffer + encapsulate(FlatWriter().finish(*message));
+}
+
+// serialize a record batch's message, which precedes its body
+std::string write_arrow_batch(const ArrowBatch& batch) {
+  std::string nodes;
+  for (auto& node: batch.nodes) {
+    put<int64_t>(nodes, node.length);
+    put<int64_t>(nodes, node.null_count);
+  }
+  std::string buffers;
+  for (auto& buffer: batch.buffers) {
+    put<int64_t>(buffers, buffer.offset);
+    put<int64_t>(buffers, buffer.length);
+  }
+  FlatPtr record_batch = flat_table();
+  add_scalar<int64_t>(record_batch, 0, batch.nrows);
+  add_child(record_batch, 1, flat_structs(nodes, batch.nodes.size()));
+  add_child(record_batch, 2, flat_structs(buffers, batch.buffers.size()));
+
+  FlatPtr message = flat_table();
+  add_scalar<int16_t>(message, 0, metadata_version);
+  add_scalar<uint8_t>(message, 1, batch_message);
+  add_child(message, 2, record_batch);
+  add_scalar<int64_t>(message, 3, int64_t(batch.body_size));
+  return encapsulate(FlatWriter().finish(*message));
+}
+
+// serialize the end of a file; positions are where each batch's message
+// begins, and the batch's body is assumed to follow its message directly
+std::string write_arrow_footer(const std::vector<ArrowField>& fields,
+                               const std::vector<ArrowBatch>& batches,
+                               const std::vector<uint64_t>& positions) {
+  std::string blocks;
+  for (size_t i = 0; i < batches.size(); i++) {
+    put<int64_t>(blocks, int64_t(positions[i]));
+    put<int32_t>(blocks, int32_t(batches[i].body - positions[i]));
+    put<int32_t>(blocks, 0);
+    put<int64_t>(blocks, int64_t(batches[i].body_size));
+  }
+  FlatPtr footer = flat_table();
+  add_scalar<int16_t>(footer, 0, metadata_version);
+  add_child(footer, 1, schema_table(fields));
+  add_child(footer, 2, flat_structs(std::string(), 0));
+  add_child(footer, 3, flat_structs(blocks, batches.size()));
+  std::string flatbuffer = FlatWriter().finish(*footer);
+
+  std::string buffer;
+  put<uint32_t>(buffer, continuation);
+  put<uint32_t>(buffer, 0);
+  buffer += flatbuffer;
+  put<int32_t>(buffer, int32_t(flatbuffer.size()));
+  buffer.append(arrow_magic, magic_size);
+  return buffer;
+}
+
+/*** flatbuffer reading ***/
+
+// a table within a flatbuffer, with every access checked against the size
+class FlatTable {
+  const char* data_;
+  size_t size_;
+  size_t table_;
+  size_t vtable_;
+  size_t vtable_size_;
+
+  template<class T>
+  T read(size_t position) const {
+    if (position > size_ || sizeof(T) > size_ - position) {
+      bad_file("truncated metadata");
+    }
+    T x;
+    memcpy(&x, data_ + position, sizeof(T));
+    return x;
+  }
+
+  // position of a field, or zero if it's absent
+  size_t field(size_t id) const {
+    size_t slot = 4 + 2 * id;
+    if (slot + 2 > vtable_size_) {
+      return 0;
+    }
+    uint16_t location = read<uint16_t>(vtable_ + slot);
+    return location == 0 ? 0 : table_ + location;
+  }
+
+  // follow an offset field to its target
+  size_t deref(size_t id) const {
+    size_t position = field(id);
+    if (position == 0) {
+      bad_file("missing metadata");
+    }
+    return position + read<uint32_t>(position);
+  }
+
+ public:
+  FlatTable(const char* data, size_t size, size_t table)
+    : data_(data), size_(size), table_(table) {
+    int32_t soffset = read<int32_t>(table);
+    vtable_ = size_t(int64_t(table) - soffset);
+    vtable_size_ = read<uint16_t>(vtable_);
+  }
+
+  // the root table of a flatbuffer
+  static FlatTable root(const char* data, size_t size) {
+    FlatTable dummy(data, size);
+    return FlatTable(data, size, dummy.read<uint32_t>(0));
+  }
+
+  bool has(size_t id) const {
+    return field(id) != 0;
+  }
+
+  template<class T>
+  T scalar(size_t id, T default_value) const {
+    size_t position = field(id);
+    return position == 0 ? default_value : read<T>(position);
+  }
+
+  FlatTable table(size_t id) const {
+    return FlatTable(data_, size_, deref(id));
+  }
+
+  std::string string(size_t id) const {
+    size_t position = deref(id);
+    uint32_t length = read<uint32_t>(position);
+    if (length > size_ - position - 4) {
+      bad_file("truncated metadata");
+    }
+    return std::string(data_ + position + 4, length);
+  }
+
+  // number of elements in a vector; the elements begin at the position
+  size_t vector(size_t id, size_t width, size_t& position) const {
+    size_t start = deref(id);
+    uint32_t count = read<uint32_t>(start);
+    position = start + 4;
+    if (count > (size_ - std::min(size_, position)) / width) {
+      bad_file("truncated metadata");
+    }
+    return count;
+  }
+
+  // a table referred to by a vector's element
+  FlatTable table_at(size_t position) const {
+    return FlatTable(data_, size_, position + read<uint32_t>(position));
+  }
+
+  template<class T>
+  T value_at(size_t position) const {
+    return read<T>(position);
+  }
+
+ private:
+  FlatTable(const char* data, size_t size)
+    : data_(data), size_(size), table_(0), vtable_(0), vtable_size_(0) {
+  }
+};
+
+// read a field's type from its schema entry
+static ArrowField read_field(const FlatTable& item) {
+  ArrowField field;
+  field.name = item.has(0) ? item.string(0) : std::string();
+  if (item.has(4)) {
+    bad_file("dictionary-encoded column " + field.name);
+  }
+  uint8_t type = item.scalar<uint8_t>(2, 0);
+  field.type = ArrowType(type);
+  field.bit_width = 64;
+  field.is_signed = true;
+  field.unit = int16_t(ArrowTimeUnit::kNanosecond);
+  switch (field.type) {
+    case ArrowType::kInt: {
+      FlatTable t = item.table(3);
+      field.bit_width = t.scalar<int32_t>(0, 0);
+      field.is_signed = t.scalar<uint8_t>(1, 0) != 0;
+      if (field.bit_width != 8 && field.bit_width != 16 &&
+          field.bit_width != 32 && field.bit_width != 64) {
+        bad_file("bad integer width in column " + field.name);
+      }
+      break;
+    }
+    case ArrowType::kFloatingPoint: {
+      int16_t precision = item.table(3).scalar<int16_t>(0, 0);
+      if (precision == 0) {
+        bad_file("half-precision column " + field.name);
+      }
+      field.bit_width = (precision == 1) ? 32 : 64;
+      break;
+    }
+    case ArrowType::kDate:
+      field.unit = item.table(3).scalar<int16_t>(0, 1);
+      field.bit_width = (field.unit == int16_t(ArrowDateUnit::kDay)) ? 32 : 64;
+      break;
+    case ArrowType::kTime: {
+      FlatTable t = item.table(3);
+      field.unit = t.scalar<int16_t>(0, 1);
+      field.bit_width = t.scalar<int32_t>(1, 32);
+      break;
+    }
+    case ArrowType::kTimestamp:
+      // a missing unit is the schema's default, which differs by type
+      field.unit = item.table(3).scalar<int16_t>(0, 0);
+      break;
+    case ArrowType::kDuration:
+      field.unit = item.table(3).scalar<int16_t>(0, 1);
+      break;
+    case ArrowType::kUtf8:
+    case ArrowType::kLargeUtf8:
+    case ArrowType::kBool:
+      break;
+    default: {
+      std::ostringstream oss;
+      oss << "unsupported type " << int(type) << " in column " << field.name;
+      bad_file(oss.str());
+    }
+  }
+
+  // units index a table of scales, so they must be known
+  int16_t max_unit = (field.type == ArrowType::kDate)
+                   ? int16_t(ArrowDateUnit::kMillisecond)
+                   : int16_t(ArrowTimeUnit::kNanosecond);
+  if (field.unit < 0 || field.unit > max_unit ||
+      (field.type == ArrowType::kTime && field.bit_width != 32 &&
+       field.bit_width != 64)) {
+    bad_file("bad unit in column " + field.name);
+  }
+  return field;
+}
+
+// read every field from a schema table
+static std::vector<ArrowField> read_schema(const FlatTable& schema) {
+  if (schema.scalar<int16_t>(0, 0) != 0) {
+    bad_file("big-endian data");
+  }
+  std::vector<ArrowField> fields;
+  size_t position;
+  size_t count = schema.vector(1, 4, position);
+  for (size_t i = 0; i < count; i++) {
+    fields.push_back(read_field(schema.table_at(position + 4 * i)));
+  }
+  return fields;
+}
+
+// read the footer's location from the end of a file
+static size_t footer_size(const char* data, size_t size) {
+  if (size < 2 * (magic_size + 2) + 4 ||
+      memcmp(data, arrow_magic, magic_size) != 0 ||
+      memcmp(data + size - magic_size, arrow_magic, magic_size) != 0) {
+    bad_file("unrecognized magic");
+  }
+  int32_t footer;
+  memcpy(&footer, data + size - magic_size - 4, 4);
+  if (footer <= 0 || size_t(footer) > size - magic_size - 4) {
+    bad_file("bad footer size");
+  }
+  return size_t(footer);
+}
+
+// read a record batch's metadata from the message at the block's position
+static ArrowBatch read_batch(const char* data, size_t size, uint64_t offset,
+                             int32_t metadata_size, int64_t body_size) {
+  if (offset > size || metadata_size < 8 ||
+      uint64_t(metadata_size) > size - offset ||
+      body_size < 0 || uint64_t(body_size) > size - offset - metadata_size) {
+    bad_file("bad record batch block");
+  }
+
+  // messages before Arrow 0.15 have no continuation
+  uint32_t prefix;
+  memcpy(&prefix, data + offset, 4);
+  size_t start = offset + ((prefix == continuation) ? 8 : 4);
+  size_t end = offset + metadata_size;
+  FlatTable message = FlatTable::root(data + start, end - start);
+  if (message.scalar<uint8_t>(1, 0) != batch_message) {
+    bad_file("expected a record batch");
+  }
+  FlatTable record_batch = message.table(2);
+  if (record_batch.has(3)) {
+    bad_file("compressed record batch");
+  }
+
+  ArrowBatch batch;
+  batch.nrows = record_batch.scalar<int64_t>(0, 0);
+  batch.body = offset + metadata_size;
+  batch.body_size = uint64_t(body_size);
+  size_t position;
+  size_t count = record_batch.vector(1, 16, position);
+  for (size_t i = 0; i < count; i++) {
+    batch.nodes.push_back(ArrowNode{
+      record_batch.value_at<int64_t>(position + 16 * i),
+      record_batch.value_at<int64_t>(position + 16 * i + 8)});
+  }
+  count = record_batch.vector(2, 16, position);
+  for (size_t i = 0; i < count; i++) {
+    ArrowBuffer buffer{record_batch.value_at<int64_t>(position + 16 * i),
+                       record_batch.value_at<int64_t>(position + 16 * i + 8)};
+    if (buffer.offset < 0 || buffer.length < 0 ||
+        uint64_t(buffer.offset) > batch.body_size ||
+        uint64_t(buffer.length) > batch.body_size - buffer.offset) {
+      bad_file("buffer outside of record batch");
+    }
+    batch.buffers.push_back(buffer);
+  }
+  return batch;
+}
+
+// deserialize the schema and record batches from a file's contents
+ArrowFile read_arrow_file(const char* data, size_t size) {
+  size_t footer = footer_size(data, size);
+  const char* start = data + size - magic_size - 4 - footer;
+  FlatTable root = FlatTable::root(start, footer);
+
+  ArrowFile file;
+  file.fields = read_schema(root.table(1));
+  if (root.has(2)) {
+    size_t position;
+    if (root.vector(2, 24, position) > 0) {
+      bad_file("dictionaries");
+    }
+  }
+  size_t position;
+  size_t count = root.has(3) ? root.vector(3, 24, position) : 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t block = position + 24 * i;
+    ArrowBatch batch = read_batch(data, size,
+                                  root.value_at<int64_t>(block),
+                                  root.value_at<int32_t>(block + 8),
+                                  root.value_at<int64_t>(block + 16));
+    size_t nbuffers = 0;
+    for (auto& field: file.fields) {
+      nbuffers += arrow_buffer_count(field.type);
+    }
+    if (batch.nodes.size() != file.fields.size() ||
+        batch.buffers.size() != nbuffers) {
+      bad_file("record batch doesn't match schema");
+    }
+
+    // every row takes at least a bit of each column's buffers
+    if (batch.nrows < 0 ||
+        (!file.fields.empty() && uint64_t(batch.nrows) / 8 > batch.body_size)) {
+      bad_file("bad row count");
+    }
+    for (auto& node: batch.nodes) {
+      if (node.length != batch.nrows || node.null_count < 0 ||
+          node.null_count > node.length) {
+        bad_file("bad row count");
+      }
+    }
+    file.batches.push_back(batch);
+  }
+  return file;
+}
+
+// the VVM type of a field
+const char* arrow_type_name(const ArrowField& field) {
+  switch (field.type) {
+    case ArrowType::kInt:
+      return "Int64";
+    case ArrowType::kFloatingPoint:
+      return "Float64";
+    case ArrowType::kBool:
+      return "Bool";
+    case ArrowType::kUtf8:
+    case ArrowType::kLargeUtf8:
+      return "String";
+    case ArrowType::kDate:
+      return "Date";
+    case ArrowType::kTime:
+      return "Time";
+    case ArrowType::kTimestamp:
+      return "Timestamp";
+    case ArrowType::kDuration:
+      return "Timedelta";
+  }
+  return "";
+}
+
+// nanoseconds in one of a field's units (one for non-time fields)
+int64_t arrow_nanos_per_unit(const ArrowField& field) {
+  static const int64_t ns_per_day = 86400000000000;
+  static const int64_t ns_per_time_unit[] = {1000000000, 1000000, 1000, 1};
+  switch (field.type) {
+    case ArrowType::kDate:
+      return field.unit == int16_t(ArrowDateUnit::kDay) ? ns_per_day : 1000000;
+    case ArrowType::kTime:
+    case ArrowType::kTimestamp:
+    case ArrowType::kDuration:
+      return ns_per_time_unit[field.unit];
+    default:
+      return 1;
+  }
+}
+
+// return a string of the table's type definition; unnamed fields are named
+// like a CSV's
+std::string arrow_type_def(const std::vector<ArrowField>& fields) {
+  std::ostringstream oss;
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (i > 0) {
+      oss << ", ";
+    }
+    if (fields[i].name.empty()) {
+      oss << "unnamed_" << i;
+    }
+    else {
+      oss << fields[i].name;
+    }
+    oss << ": " << arrow_type_name(fields[i]);
+  }
+  return oss.str();
+}
+
+// return a string of the type definition of a file's schema
+std::string read_arrow_type(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::logic_error(filename + ": " + strerror(errno));
+  }
+
+  // only the footer is needed, so don't read the record batches
+  size_t size = size_t(in.tellg());
+  std::string start(magic_size, '\0');
+  in.seekg(0);
+  in.read(&start[0], magic_size);
+  std::string end(magic_size + 4, '\0');
+  if (size >= end.size()) {
+    in.seekg(size - end.size());
+    in.read(&end[0], end.size());
+  }
+  if (!in || start != std::string(arrow_magic, magic_size) ||
+      end.compare(4, magic_size, arrow_magic) != 0) {
+    bad_file("unrecognized magic");
+  }
+  int32_t footer;
+  memcpy(&footer, &end[0], 4);
+  if (footer <= 0 || size_t(footer) > size - end.size()) {
+    bad_file("bad footer size");
+  }
+
+  std::string flatbuffer(footer, '\0');
+  in.seekg(size - end.size() - footer);
+  in.read(&flatbuffer[0], footer);
+  if (!in) {
+    bad_file("truncated footer");
+  }
+  FlatTable root = FlatTable::root(flatbuffer.data(), flatbuffer.size());
+  return arrow_type_def(read_schema(root.table(1)));
+}
+}  // namespace VVM
@@ -0,0 +1,148 @@
+/*
+ * Arrow header -- declares routines for the Arrow IPC file format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * The Arrow IPC file format (also known as Feather v2) is how other tools
+ * exchange tables without parsing text. A file is laid out as:
+ *
+ *   magic         "ARROW1" padded to eight bytes
+ *   schema        a message describing every field
+ *   batches       a message and a body for each record batch of rows
+ *   end marker
+ *   footer        the schema again, plus where each record batch begins
+ *   footer size   32-bit
+ *   magic         "ARROW1"
+ *
+ * The messages and footer are flatbuffers, which are read and written here
+ * without the flatbuffers library. Every column of a batch is a list of
+ * buffers in its body: a validity bitmap (empty if there are no nulls), then
+ * the values, with strings also having their end positions first.
+ *
+ * Files with the ".arrow" or ".feather" extension are stored and loaded in
+ * this format. Only uncompressed, little-endian files without dictionaries
+ * or nested types are supported.
+ */
+namespace VVM {
+
+// field types that have a VVM counterpart, numbered as in Arrow's schema
+enum class ArrowType: uint8_t {
+  kInt           = 2,
+  kFloatingPoint = 3,
+  kUtf8          = 5,
+  kBool          = 6,
+  kDate          = 8,
+  kTime          = 9,
+  kTimestamp     = 10,
+  kDuration      = 18,
+  kLargeUtf8     = 20
+};
+
+// units of Timestamp, Time and Duration
+enum class ArrowTimeUnit: int16_t {
+  kSecond      = 0,
+  kMillisecond = 1,
+  kMicrosecond = 2,
+  kNanosecond  = 3
+};
+
+// units of Date
+enum class ArrowDateUnit: int16_t {
+  kDay         = 0,
+  kMillisecond = 1
+};
+
+// a column's description in the schema
+struct ArrowField {
+  std::string name;
+  ArrowType type;
+  int32_t bit_width;  // Int, FloatingPoint and Time
+  bool is_signed;     // Int
+  int16_t unit;       // ArrowTimeUnit, or ArrowDateUnit for Date
+};
+
+// a column's row count and null count within a record batch
+struct ArrowNode {
+  int64_t length;
+  int64_t null_count;
+};
+
+// a buffer's position relative to its record batch's body
+struct ArrowBuffer {
+  int64_t offset;
+  int64_t length;
+};
+
+// a record batch's metadata; body is the file position of its buffers
+struct ArrowBatch {
+  int64_t nrows;
+  uint64_t body;
+  uint64_t body_size;
+  std::vector<ArrowNode> nodes;
+  std::vector<ArrowBuffer> buffers;
+};
+
+// everything needed to find a file's columns
+struct ArrowFile {
+  std::vector<ArrowField> fields;
+  std::vector<ArrowBatch> batches;
+};
+
+bool is_arrow_file(const std::string& filename);
+size_t arrow_buffer_count(ArrowType type);
+size_t arrow_padding(size_t n);
+const char* arrow_type_name(const ArrowField& field);
+int64_t arrow_nanos_per_unit(const ArrowField& field);
+std::string arrow_type_def(const std::vector<ArrowField>& fields);
+ArrowFile read_arrow_file(const char* data, size_t size);
+std::string read_arrow_type(const std::string& filename);
+std::string write_arrow_header(const std::vector<ArrowField>& fields);
+std::string write_arrow_batch(const ArrowBatch& batch);
+std::string write_arrow_footer(const std::vector<ArrowField>& fields,
+                               const std::vector<ArrowBatch>& batches,
+                               const std::vector<uint64_t>& positions);
+
+// read an integer of any Arrow width from a buffer of values
+inline int64_t arrow_int_at(const char* data, int32_t bit_width,
+                            bool is_signed, size_t i) {
+  switch (bit_width) {
+    case 8:
+      return is_signed ? int64_t(int8_t(data[i])) : int64_t(uint8_t(data[i]));
+    case 16: {
+      uint16_t x;
+      memcpy(&x, data + 2 * i, 2);
+      return is_signed ? int64_t(int16_t(x)) : int64_t(x);
+    }
+    case 32: {
+      uint32_t x;
+      memcpy(&x, data + 4 * i, 4);
+      return is_signed ? int64_t(int32_t(x)) : int64_t(x);
+    }
+    default: {
+      int64_t x;
+      memcpy(&x, data + 8 * i, 8);
+      return x;
+    }
+  }
+}
+
+// check whether a row is valid according to a validity bitmap (which is
+// empty if there are no nulls)
+inline bool arrow_is_valid(const char* bitmap, size_t i) {
+  return bitmap == nullptr || (uint8_t(bitmap[i >> 3]) >> (i & 7)) & 1;
+}
+
+}  // namespace VVM
@@ -0,0 +1,78 @@
+/*
+ * Column View -- read-only access to a contiguous array of values
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * A view is just a pointer and a length, so the array can live in a vector or
+ * in a memory-mapped file. The view does not own its contents.
+ *
+ * Since std::vector<bool> is packed, a view of booleans wraps the vector
+ * instead of a pointer.
+ */
+namespace VVM {
+template<class T>
+class ColumnView {
+  const T* data_;
+  size_t size_;
+
+ public:
+  ColumnView(const T* data, size_t size): data_(data), size_(size) {
+  }
+
+  ColumnView(const std::vector<T>& xs): data_(xs.data()), size_(xs.size()) {
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  const T& operator[](size_t i) const {
+    return data_[i];
+  }
+
+  const T* begin() const {
+    return data_;
+  }
+
+  const T* end() const {
+    return data_ + size_;
+  }
+};
+
+template<>
+class ColumnView<bool> {
+  const std::vector<bool>& xs_;
+
+ public:
+  ColumnView(const std::vector<bool>& xs): xs_(xs) {
+  }
+
+  size_t size() const {
+    return xs_.size();
+  }
+
+  bool operator[](size_t i) const {
+    return xs_[i];
+  }
+
+  std::vector<bool>::const_iterator begin() const {
+    return xs_.begin();
+  }
+
+  std::vector<bool>::const_iterator end() const {
+    return xs_.end();
+  }
+};
+}  // namespace VVM
+
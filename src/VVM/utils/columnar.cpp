@@ -0,0 +1,266 @@
+/*
+ * Columnar -- native binary table format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <VVM/utils/columnar.hpp>
+
+namespace VVM {
+// identifies the format and its version
+static const char columnar_magic[] = "EMPDF001";
+static const char compressed_magic[] = "EMPDFZ01";
+static const size_t magic_size = 8;
+static const size_t word_size = sizeof(uint64_t);
+
+// guard against allocating a nonsense type definition
+static const uint64_t max_type_def_size = 1 << 24;
+
+// check whether a filename ends with an extension
+static bool has_extension(const std::string& filename, const std::string& ext) {
+  return filename.size() > ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// check whether a file should be in the binary format (either variant)
+bool is_columnar_file(const std::string& filename) {
+  return has_extension(filename, ".edf") || is_compressed_file(filename);
+}
+
+// check whether a file should be in the compressed binary format
+bool is_compressed_file(const std::string& filename) {
+  return has_extension(filename, ".edfz");
+}
+
+// number of bytes needed to bring a block to an eight-byte boundary
+size_t columnar_padding(size_t n) {
+  return (word_size - n % word_size) % word_size;
+}
+
+// number of bytes before the first column block
+size_t columnar_header_size(const std::string& type_def, size_t ncols) {
+  size_t def_size = type_def.size() + columnar_padding(type_def.size());
+  return magic_size + word_size + def_size + 2 * word_size + ncols * word_size;
+}
+
+// append a word to a buffer
+static void put_word(std::string& buffer, uint64_t x) {
+  buffer.append(reinterpret_cast<const char*>(&x), word_size);
+}
+
+// serialize the header
+std::string write_columnar_header(const ColumnarHeader& header) {
+  std::string buffer(header.compressed ? compressed_magic : columnar_magic,
+                     magic_size);
+  put_word(buffer, header.type_def.size());
+  buffer += header.type_def;
+  buffer.append(columnar_padding(header.type_def.size()), '\0');
+  put_word(buffer, header.nrows);
+  put_word(buffer, header.offsets.size());
+  for (uint64_t offset: header.offsets) {
+    put_word(buffer, offset);
+  }
+  return buffer;
+}
+
+// throw an error for a malformed file
+[[noreturn]] static void bad_file(const std::string& reason) {
+  throw std::logic_error("Invalid columnar file: " + reason);
+}
+
+// read a word from a buffer, advancing the position
+static uint64_t get_word(const char* data, size_t size, size_t& pos) {
+  if (pos + word_size > size) {
+    bad_file("truncated header");
+  }
+  uint64_t x;
+  memcpy(&x, data + pos, word_size);
+  pos += word_size;
+  return x;
+}
+
+// check the magic, returning whether the file is compressed
+static bool read_magic(const char* data, size_t size) {
+  if (size >= magic_size) {
+    if (memcmp(data, columnar_magic, magic_size) == 0) {
+      return false;
+    }
+    if (memcmp(data, compressed_magic, magic_size) == 0) {
+      return true;
+    }
+  }
+  bad_file("unrecognized magic");
+}
+
+// deserialize the header from the start of a file's contents
+ColumnarHeader read_columnar_header(const char* data, size_t size) {
+  ColumnarHeader header;
+  header.compressed = read_magic(data, size);
+  size_t pos = magic_size;
+
+  uint64_t def_size = get_word(data, size, pos);
+  if (def_size > size - pos) {
+    bad_file("truncated header");
+  }
+  header.type_def.assign(data + pos, def_size);
+  pos += def_size + columnar_padding(def_size);
+
+  header.nrows = get_word(data, size, pos);
+  uint64_t ncols = get_word(data, size, pos);
+  if (ncols > (size - pos) / word_size) {
+    bad_file("truncated header");
+  }
+  header.offsets.resize(ncols);
+  for (auto& offset: header.offsets) {
+    offset = get_word(data, size, pos);
+    if (offset < pos || offset > size || offset % word_size != 0) {
+      std::ostringstream oss;
+      oss << "bad column offset " << offset;
+      bad_file(oss.str());
+    }
+  }
+  return header;
+}
+
+// return a string of the table's type definition
+std::string read_columnar_type(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    throw std::logic_error(filename + ": " + strerror(errno));
+  }
+
+  // only the start of the header is needed, so don't read the columns
+  std::string prefix(magic_size + word_size, '\0');
+  in.read(&prefix[0], prefix.size());
+  read_magic(prefix.data(), size_t(in.gcount()));
+  uint64_t def_size;
+  memcpy(&def_size, &prefix[magic_size], word_size);
+  if (def_size > max_type_def_size) {
+    bad_file("truncated header");
+  }
+
+  std::string type_def(def_size, '\0');
+  in.read(&type_def[0], def_size);
+  if (uint64_t(in.gcount()) != def_size) {
+    bad_file("truncated header");
+  }
+  return type_def;
+}
+
+// number of words in each block's directory entry
+static const size_t block_words = 6;
+
+// number of bytes in a dictionary's String block, excluding padding
+static size_t dictionary_size(const std::vector<std::string>& dictionary) {
+  size_t nbytes = 0;
+  for (auto& entry: dictionary) {
+    nbytes += entry.size();
+  }
+  return word_size + dictionary.size() * word_size + nbytes;
+}
+
+// number of bytes in a compressed column before its first block
+size_t compressed_column_size(const CompressedColumn& column) {
+  size_t dict_size = dictionary_size(column.dictionary);
+  return 2 * word_size + dict_size + columnar_padding(dict_size) +
+         word_size + column.blocks.size() * block_words * word_size;
+}
+
+// serialize a compressed column's codec, dictionary and directory
+std::string write_compressed_column(const CompressedColumn& column) {
+  std::string buffer;
+  put_word(buffer, uint64_t(column.codec));
+
+  put_word(buffer, column.dictionary.size());
+  size_t dict_size = dictionary_size(column.dictionary);
+  put_word(buffer, dict_size - word_size);
+  uint64_t end = 0;
+  for (auto& entry: column.dictionary) {
+    end += entry.size();
+    put_word(buffer, end);
+  }
+  for (auto& entry: column.dictionary) {
+    buffer += entry;
+  }
+  buffer.append(columnar_padding(dict_size), '\0');
+
+  put_word(buffer, column.blocks.size());
+  for (auto& block: column.blocks) {
+    put_word(buffer, block.offset);
+    put_word(buffer, block.size);
+    put_word(buffer, block.nrows);
+    put_word(buffer, block.count);
+    put_word(buffer, block.min);
+    put_word(buffer, block.max);
+  }
+  return buffer;
+}
+
+// deserialize a compressed column that begins at the given file position
+CompressedColumn read_compressed_column(const char* data, size_t size,
+                                        uint64_t offset) {
+  size_t pos = offset;
+  CompressedColumn column;
+  uint64_t codec = get_word(data, size, pos);
+  if (codec > uint64_t(Codec::kDictionary)) {
+    std::ostringstream oss;
+    oss << "unknown codec " << codec;
+    bad_file(oss.str());
+  }
+  column.codec = Codec(codec);
+
+  uint64_t count = get_word(data, size, pos);
+  uint64_t nbytes = get_word(data, size, pos);
+  if (count > (size - pos) / word_size ||
+      nbytes < count * word_size ||
+      nbytes > size - pos) {
+    bad_file("truncated dictionary");
+  }
+  const char* ends = data + pos;
+  const char* chars = ends + count * word_size;
+  size_t nchars = nbytes - count * word_size;
+  column.dictionary.resize(count);
+  uint64_t start = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t end;
+    memcpy(&end, ends + i * word_size, word_size);
+    if (end < start || end > nchars) {
+      bad_file("bad dictionary entry");
+    }
+    column.dictionary[i].assign(chars + start, end - start);
+    start = end;
+  }
+  pos += nbytes + columnar_padding(word_size + nbytes);
+
+  uint64_t nblocks = get_word(data, size, pos);
+  if (pos > size || nblocks > (size - pos) / (block_words * word_size)) {
+    bad_file("truncated block directory");
+  }
+  column.blocks.resize(nblocks);
+  for (auto& block: column.blocks) {
+    block.offset = get_word(data, size, pos);
+    block.size = get_word(data, size, pos);
+    block.nrows = get_word(data, size, pos);
+    block.count = get_word(data, size, pos);
+    block.min = get_word(data, size, pos);
+    block.max = get_word(data, size, pos);
+    if (block.offset > size || block.size > size - block.offset ||
+        block.count > block.nrows) {
+      std::ostringstream oss;
+      oss << "bad block at " << block.offset;
+      bad_file(oss.str());
+    }
+  }
+  return column;
+}
+}  // namespace VVM
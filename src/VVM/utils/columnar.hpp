@@ -0,0 +1,97 @@
+/*
+ * Columnar header -- declares routines for the native binary table format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A table is stored column-by-column so that loading is little more than a
+ * copy. Every integer is a 64-bit word in the machine's byte order, and every
+ * block begins on an eight-byte boundary:
+ *
+ *   magic         "EMPDF001"
+ *   header size   number of bytes in the type definition
+ *   header        type definition, eg. "symbol: String, close: Float64"
+ *   row count
+ *   column count
+ *   offsets       file position of each column's block
+ *   blocks        raw values for fixed-width types (one byte per Bool); a
+ *                 String block is prefixed by its length in bytes, followed
+ *                 by the end position of each string and then the characters
+ *
+ * Files with the ".edf" extension are stored and loaded in this format.
+ *
+ * The compressed variant (".edfz", with magic "EMPDFZ01") has the same header,
+ * but each column is split into blocks of rows that are encoded separately:
+ *
+ *   codec         how every block of the column is encoded
+ *   dictionary    entry count, then a String block (as above) of the entries
+ *   block count
+ *   directory     for each block: file position, size in bytes, row count,
+ *                 non-nil count, and the bits of the smallest and largest
+ *                 non-nil values (the zone map)
+ *   blocks        encoded rows
+ *
+ * Zone maps only exist for numeric and time types; otherwise the non-nil
+ * count is zero.
+ */
+namespace VVM {
+
+// everything in the file before the first column block
+struct ColumnarHeader {
+  std::string type_def;
+  uint64_t nrows;
+  std::vector<uint64_t> offsets;
+  bool compressed;
+};
+
+// encodings for a compressed column's blocks
+enum class Codec: uint64_t {
+  kRaw        = 0,  // fixed-width values, as in the uncompressed format
+  kStrings    = 1,  // end positions then characters
+  kDelta      = 2,  // delta-of-delta varints
+  kFrame      = 3,  // frame-of-reference bit packing
+  kDictionary = 4   // bit-packed indices into the column's dictionary
+};
+
+// a block of a compressed column
+struct CompressedBlock {
+  uint64_t offset;
+  uint64_t size;
+  uint64_t nrows;
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+};
+
+// everything in a compressed column before its blocks
+struct CompressedColumn {
+  Codec codec;
+  std::vector<std::string> dictionary;
+  std::vector<CompressedBlock> blocks;
+};
+
+bool is_columnar_file(const std::string& filename);
+bool is_compressed_file(const std::string& filename);
+size_t columnar_padding(size_t n);
+size_t columnar_header_size(const std::string& type_def, size_t ncols);
+std::string write_columnar_header(const ColumnarHeader& header);
+ColumnarHeader read_columnar_header(const char* data, size_t size);
+std::string read_columnar_type(const std::string& filename);
+size_t compressed_column_size(const CompressedColumn& column);
+std::string write_compressed_column(const CompressedColumn& column);
+CompressedColumn read_compressed_column(const char* data, size_t size,
+                                        uint64_t offset);
+
+}  // namespace VVM
+
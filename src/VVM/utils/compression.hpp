@@ -0,0 +1,206 @@
+/*
+ * Compression -- integer codecs for the compressed columnar format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Columns are compressed as 64-bit integers (timestamps, for example, are
+ * already integers underneath). The codecs never fail to encode, though a
+ * poorly suited codec may grow the data slightly.
+ *
+ * This file introduces these functions:
+ *   1. put_varint(s, x) / get_varint(p, e)   : LEB128 unsigned integers
+ *   2. zigzag_encode(x) / zigzag_decode(x)   : map signed to unsigned
+ *   3. bit_width(x)                          : bits needed to hold a value
+ *   4. pack_bits(codes, w, s) / unpack_bits  : fixed-width bit packing
+ *   5. encode_delta(xs, n, s) / decode_delta : delta-of-delta varints
+ *   6. encode_frame(xs, n, nil, s) / decode_frame
+ *                                            : frame-of-reference packing
+ *
+ * All decoders check bounds and throw on malformed input. Arithmetic on the
+ * integers wraps, so any input (including the nil sentinel) round-trips.
+ */
+namespace VVM {
+// append an unsigned integer in 7-bit groups
+inline void put_varint(std::string& buffer, uint64_t x) {
+  while (x >= 0x80) {
+    buffer.push_back(char(x | 0x80));
+    x >>= 7;
+  }
+  buffer.push_back(char(x));
+}
+
+// read an unsigned integer in 7-bit groups, advancing the pointer
+inline uint64_t get_varint(const char*& p, const char* end) {
+  uint64_t x = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (p == end) {
+      throw std::logic_error("Truncated varint");
+    }
+    uint8_t byte = uint8_t(*p++);
+    x |= uint64_t(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return x;
+    }
+  }
+  throw std::logic_error("Overlong varint");
+}
+
+// map small negative and positive integers to small unsigned integers
+inline uint64_t zigzag_encode(int64_t x) {
+  return (uint64_t(x) << 1) ^ uint64_t(x >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t x) {
+  return int64_t((x >> 1) ^ (~(x & 1) + 1));
+}
+
+// number of bits needed to represent a value
+inline unsigned bit_width(uint64_t x) {
+  unsigned width = 0;
+  while (x != 0) {
+    width++;
+    x >>= 1;
+  }
+  return width;
+}
+
+// append codes using exactly the given number of bits each, padded to a
+// whole number of 64-bit words
+inline void pack_bits(const std::vector<uint64_t>& codes, unsigned width,
+                      std::string& buffer) {
+  if (width == 0) {
+    return;
+  }
+  uint64_t word = 0;
+  unsigned used = 0;
+  for (uint64_t code: codes) {
+    word |= code << used;
+    if (used + width >= 64) {
+      buffer.append(reinterpret_cast<const char*>(&word), sizeof(word));
+      word = (used == 0) ? 0 : code >> (64 - used);
+      used = used + width - 64;
+    }
+    else {
+      used += width;
+    }
+  }
+  if (used != 0) {
+    buffer.append(reinterpret_cast<const char*>(&word), sizeof(word));
+  }
+}
+
+// number of bytes that pack_bits() produces
+inline size_t packed_size(size_t n, unsigned width) {
+  return (n * width + 63) / 64 * sizeof(uint64_t);
+}
+
+// read codes that were packed with the given number of bits each
+inline void unpack_bits(const char* p, const char* end, size_t n,
+                        unsigned width, uint64_t* codes) {
+  if (width > 64 || size_t(end - p) < packed_size(n, width)) {
+    throw std::logic_error("Truncated bit-packed block");
+  }
+  if (width == 0) {
+    std::fill(codes, codes + n, 0);
+    return;
+  }
+  const uint64_t mask = (width == 64) ? ~uint64_t(0)
+                                      : (uint64_t(1) << width) - 1;
+  size_t bit = 0;
+  for (size_t i = 0; i < n; i++) {
+    size_t idx = bit / 64;
+    unsigned offset = bit % 64;
+    uint64_t lo, hi = 0;
+    memcpy(&lo, p + idx * sizeof(uint64_t), sizeof(uint64_t));
+    uint64_t code = lo >> offset;
+    if (offset + width > 64) {
+      memcpy(&hi, p + (idx + 1) * sizeof(uint64_t), sizeof(uint64_t));
+      code |= hi << (64 - offset);
+    }
+    codes[i] = code & mask;
+    bit += width;
+  }
+}
+
+// append delta-of-deltas, which are tiny for regularly spaced series
+inline void encode_delta(const int64_t* xs, size_t n, std::string& buffer) {
+  uint64_t prev = 0, prev_delta = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t delta = uint64_t(xs[i]) - prev;
+    put_varint(buffer, zigzag_encode(int64_t(delta - prev_delta)));
+    prev = uint64_t(xs[i]);
+    prev_delta = delta;
+  }
+}
+
+inline void decode_delta(const char* p, const char* end, size_t n,
+                         int64_t* xs) {
+  uint64_t prev = 0, prev_delta = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint64_t delta = prev_delta + uint64_t(zigzag_decode(get_varint(p, end)));
+    prev += delta;
+    prev_delta = delta;
+    xs[i] = int64_t(prev);
+  }
+}
+
+// append the minimum and bit width, then each value's offset from that
+// minimum; zero is reserved for nil, so offsets begin at one
+inline void encode_frame(const int64_t* xs, size_t n, int64_t nil,
+                         std::string& buffer) {
+  int64_t lo = 0, hi = 0;
+  bool any = false;
+  for (size_t i = 0; i < n; i++) {
+    if (xs[i] != nil) {
+      lo = any ? std::min(lo, xs[i]) : xs[i];
+      hi = any ? std::max(hi, xs[i]) : xs[i];
+      any = true;
+    }
+  }
+  std::vector<uint64_t> codes(n);
+  for (size_t i = 0; i < n; i++) {
+    codes[i] = (xs[i] == nil) ? 0 : uint64_t(xs[i]) - uint64_t(lo) + 1;
+  }
+  uint64_t range = uint64_t(hi) - uint64_t(lo);
+  uint64_t width = (range == ~uint64_t(0)) ? 64 : bit_width(range + 1);
+  buffer.append(reinterpret_cast<const char*>(&lo), sizeof(lo));
+  buffer.append(reinterpret_cast<const char*>(&width), sizeof(width));
+  pack_bits(codes, unsigned(width), buffer);
+}
+
+inline void decode_frame(const char* p, const char* end, size_t n,
+                         int64_t nil, int64_t* xs) {
+  if (size_t(end - p) < 2 * sizeof(uint64_t)) {
+    throw std::logic_error("Truncated frame-of-reference block");
+  }
+  int64_t lo;
+  uint64_t width;
+  memcpy(&lo, p, sizeof(lo));
+  memcpy(&width, p + sizeof(lo), sizeof(width));
+  p += 2 * sizeof(uint64_t);
+  if (width > 64) {
+    throw std::logic_error("Invalid frame-of-reference width");
+  }
+  std::vector<uint64_t> codes(n);
+  unpack_bits(p, end, n, unsigned(width), codes.data());
+  for (size_t i = 0; i < n; i++) {
+    xs[i] = (codes[i] == 0) ? nil : int64_t(uint64_t(lo) + codes[i] - 1);
+  }
+}
+}  // namespace VVM
+
@@ -10,9 +10,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
+#include <VVM/utils/format.hpp>
 #include <VVM/utils/nil.hpp>
+#include <VVM/utils/numeric.hpp>
 
 /*
  * Convert a C++ value to and from a string. This is lexical casting with a
@@ -21,14 +24,17 @@
  * This file introduces these functions:
  *   1. to_repr(T x)           : generates a string intended for a console
  *   2. to_string(T x)         : generates a string for internal use
- *   3. from_string<T>(x)      : parses a string into a value
+ *   3. from_string<T>(x)      : parses a string (or pointer and size) to value
  *   4. trim_trailing_zeros(x) : removes excess zeros from a converted float
+ *   5. count_trailing_zeros(x): how many zeros trim_trailing_zeros() removes
+ *   6. trim_zeros(x, n)       : removes that many zeros (eg. a column's least)
  *
  * The above functions are predefined for standard C++ types. Any new type
- * must redefine all four.
+ * must redefine all six.
  *
- * This extra function does not need to be redefined:
- *   5. super_cast<T, U>(T x) : all-in-one cast for lexical and static
+ * These extra functions do not need to be redefined:
+ *   7. super_cast<T, U>(T x) : all-in-one cast for lexical and static
+ *   8. to_strings(xs, b, e, ys): to_string() of a column's range of values
  */
 namespace VVM {
 // remove excess zeros from converted floating points
@@ -56,23 +62,16 @@ trim_trailing_zeros(std::vector<std::string>& xs) {
     return;
   }
 
-  // if all elements end in zero, remove it
-  bool all_zeros = true;
-  while (all_zeros) {
-    for (const auto& x: xs) {
-      if (!x.empty() && x.back() != '0') {
-        all_zeros = false;
-      }
-    }
-    if (all_zeros) {
-      for (auto& x: xs) {
-        x.pop_back();
-      }
+  // remove the zeros that all elements end in
+  size_t zeros = std::string::npos;
+  for (const auto& x: xs) {
+    if (!x.empty()) {
+      zeros = std::min(zeros, count_float_zeros(x.data(), x.size()));
     }
   }
   for (auto& x: xs) {
-    if (!x.empty() && x.back() == '.') {
-      x.push_back('0');
+    if (!x.empty()) {
+      x.resize(trim_float_zeros(&x[0], x.size(), zeros));
     }
   }
 }
@@ -88,15 +87,42 @@ template<class T>
 typename std::enable_if<std::is_floating_point<T>::value, std::string>::type
 trim_trailing_zeros(const std::string& x) {
   std::string y = x;
-  while (!y.empty() && y.back() == '0') {
-    y.pop_back();
-  }
-  if (!y.empty() && y.back() == '.') {
-    y.push_back('0');
-  }
+  y.resize(trim_float_zeros(&y[0], y.size(), count_float_zeros(y.data(),
+                                                               y.size())));
   return y;
 }
 
+// count the excess zeros of a converted floating point
+template<class T>
+typename std::enable_if<std::is_integral<T>::value ||
+                        std::is_same<T, std::string>::value, size_t>::type
+count_trailing_zeros(const std::string& x) {
+  return 0;
+}
+
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+count_trailing_zeros(const std::string& x) {
+  return count_float_zeros(x.data(), x.size());
+}
+
+// remove a number of excess zeros, which must not exceed the count above
+template<class T>
+typename std::enable_if<std::is_integral<T>::value ||
+                        std::is_same<T, std::string>::value, void>::type
+trim_zeros(std::string& x, size_t n) {
+  ;
+}
+
+template<class T>
+typename std::enable_if<std::is_floating_point<T>::value, void>::type
+trim_zeros(std::string& x, size_t n) {
+  x.resize(x.size() - n);
+  if (!x.empty() && x.back() == '.') {
+    x.push_back('0');
+  }
+}
+
 // generate a string for display in console
 template<class T>
 typename std::enable_if<is_int<T>::value, std::string>::type
@@ -104,7 +130,10 @@ to_repr(T x) {
   if (is_nil(x)) {
     return "nil";
   }
-  return std::to_string(x);
+  char buffer[max_format_size];
+  size_t n = std::is_signed<T>::value ? format_int64(x, buffer)
+                                      : format_uint64(x, buffer);
+  return std::string(buffer, n);
 }
 
 template<class T>
@@ -113,7 +142,10 @@ to_repr(T x) {
   if (is_nil(x)) {
     return "nan";
   }
-  return trim_trailing_zeros<T>(std::to_string(x));
+  char buffer[max_format_size];
+  size_t n = format_float64(x, buffer);
+  n = trim_float_zeros(buffer, n, count_float_zeros(buffer, n));
+  return std::string(buffer, n);
 }
 
 inline std::string to_repr(bool b) {
@@ -140,7 +172,10 @@ to_string(T x) {
   if (is_nil(x)) {
     return std::string();
   }
-  return std::to_string(x);
+  char buffer[max_format_size];
+  size_t n = std::is_signed<T>::value ? format_int64(x, buffer)
+                                      : format_uint64(x, buffer);
+  return std::string(buffer, n);
 }
 
 template<class T>
@@ -149,7 +184,8 @@ to_string(T x) {
   if (is_nil(x)) {
     return std::string();
   }
-  return std::to_string(x);
+  char buffer[max_format_size];
+  return std::string(buffer, format_float64(x, buffer));
 }
 
 inline std::string to_string(bool b) {
@@ -167,37 +203,27 @@ inline std::string to_string(char c) {
   return std::string(1, c);
 }
 
+// generate strings for a range of a column; types whose values share work
+// (like dates of a timestamp) can overload this
+template<class T>
+void to_strings(const std::vector<T>& xs, size_t begin, size_t end,
+                std::string* ys) {
+  for (size_t i = begin; i < end; i++) {
+    ys[i - begin] = to_string(T(xs[i]));
+  }
+}
+
 // parse a string into a value
 template<class T>
 typename std::enable_if<std::is_same<T, int64_t>::value, T>::type
 from_string(const std::string& text) {
-  try {
-    size_t pos = 0;
-    int64_t result = std::stol(text, &pos);
-    if (pos != text.size()) {
-      return nil_value<int64_t>();
-    }
-    return result;
-  }
-  catch (std::invalid_argument) {
-    return nil_value<int64_t>();
-  }
+  return parse_int64(text.data(), text.size());
 }
 
 template<class T>
 typename std::enable_if<std::is_same<T, double>::value, T>::type
 from_string(const std::string& text) {
-  try {
-    size_t pos = 0;
-    double result = std::stod(text, &pos);
-    if (pos != text.size()) {
-      return nil_value<double>();
-    }
-    return result;
-  }
-  catch (std::invalid_argument) {
-    return nil_value<double>();
-  }
+  return parse_float64(text.data(), text.size());
 }
 
 template<class T>
@@ -209,7 +235,7 @@ from_string(const std::string& text) {
 template<class T>
 typename std::enable_if<std::is_same<T, bool>::value, T>::type
 from_string(const std::string& text) {
-  return text == "true";
+  return parse_bool(text.data(), text.size());
 }
 
 template<class T>
@@ -221,6 +247,41 @@ from_string(const std::string& text) {
   return nil_value<char>();
 }
 
+// parse text that isn't NUL-terminated (like a cell of a mapped file) into a
+// value; only strings will allocate memory
+template<class T>
+typename std::enable_if<std::is_same<T, int64_t>::value, T>::type
+from_string(const char* text, size_t size) {
+  return parse_int64(text, size);
+}
+
+template<class T>
+typename std::enable_if<std::is_same<T, double>::value, T>::type
+from_string(const char* text, size_t size) {
+  return parse_float64(text, size);
+}
+
+template<class T>
+typename std::enable_if<std::is_same<T, std::string>::value, T>::type
+from_string(const char* text, size_t size) {
+  return std::string(text, size);
+}
+
+template<class T>
+typename std::enable_if<std::is_same<T, bool>::value, T>::type
+from_string(const char* text, size_t size) {
+  return parse_bool(text, size);
+}
+
+template<class T>
+typename std::enable_if<std::is_same<T, char>::value, T>::type
+from_string(const char* text, size_t size) {
+  if (size == 1) {
+    return text[0];
+  }
+  return nil_value<char>();
+}
+
 // an all-in-one cast that handles lexical and static varities
 template<class T, class U>
 typename std::enable_if<std::is_same<T, std::string>::value &&
@@ -238,11 +299,25 @@ super_cast(T x) {
 
 template<class T, class U>
 typename std::enable_if<!std::is_same<T, std::string>::value &&
+                        !std::is_floating_point<T>::value &&
                         std::is_same<U, std::string>::value, U>::type
 super_cast(T x) {
   return trim_trailing_zeros<T>(to_string(x));
 }
 
+template<class T, class U>
+typename std::enable_if<std::is_floating_point<T>::value &&
+                        std::is_same<U, std::string>::value, U>::type
+super_cast(T x) {
+  if (is_nil(x)) {
+    return std::string();
+  }
+  char buffer[max_format_size];
+  size_t n = format_float64(x, buffer);
+  n = trim_float_zeros(buffer, n, count_float_zeros(buffer, n));
+  return std::string(buffer, n);
+}
+
 template<class T, class U>
 typename std::enable_if<!std::is_same<T, std::string>::value &&
                         !std::is_same<U, std::string>::value, U>::type
@@ -0,0 +1,135 @@
+/*
+ * CSV Index -- a CSV file's row index
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <sys/stat.h>
+
+#include <VVM/utils/csv_index.hpp>
+
+namespace VVM {
+// identifies the format and its version
+static const char csv_index_magic[] = "EMPIX001";
+static const size_t magic_size = 8;
+static const size_t word_size = sizeof(uint64_t);
+
+// the index of "dir/name" is "dir/.name.idx"
+std::string csv_index_filename(const std::string& filename) {
+  size_t slash = filename.find_last_of("/\\");
+  size_t base = (slash == std::string::npos) ? 0 : slash + 1;
+  return filename.substr(0, base) + '.' + filename.substr(base) + ".idx";
+}
+
+// get the size and modification time that an index must match
+bool stat_csv_file(const std::string& filename, uint64_t& size,
+                   int64_t& mtime) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return false;
+  }
+  size = uint64_t(st.st_size);
+  mtime = int64_t(st.st_mtime);
+  return true;
+}
+
+// read a word from a buffer, advancing the position
+static bool get_word(const std::string& data, size_t& pos, uint64_t& x) {
+  if (pos + word_size > data.size()) {
+    return false;
+  }
+  memcpy(&x, data.data() + pos, word_size);
+  pos += word_size;
+  return true;
+}
+
+// read the index of a CSV file; returns false if it is missing or stale
+bool read_csv_index(const std::string& filename, CsvIndex& index) {
+  uint64_t size;
+  int64_t mtime;
+  if (!stat_csv_file(filename, size, mtime)) {
+    return false;
+  }
+  std::ifstream in(csv_index_filename(filename), std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  if (data.compare(0, magic_size, csv_index_magic) != 0) {
+    return false;
+  }
+
+  size_t pos = magic_size;
+  uint64_t file_size, file_mtime, nrows, nentries;
+  if (!get_word(data, pos, file_size) || !get_word(data, pos, file_mtime) ||
+      !get_word(data, pos, nrows) || !get_word(data, pos, nentries)) {
+    return false;
+  }
+  size_t entry_size = 2 * word_size;
+  if (file_size != size || int64_t(file_mtime) != mtime || nentries == 0 ||
+      (data.size() - pos) % entry_size != 0 ||
+      nentries != (data.size() - pos) / entry_size) {
+    return false;
+  }
+
+  // entries must be in order and within the file
+  index.entries.resize(nentries);
+  for (size_t i = 0; i < nentries; i++) {
+    auto& entry = index.entries[i];
+    get_word(data, pos, entry.offset);
+    get_word(data, pos, entry.row);
+    if (entry.offset >= size || entry.row >= nrows ||
+        (i > 0 && (entry.offset <= index.entries[i - 1].offset ||
+                   entry.row <= index.entries[i - 1].row))) {
+      return false;
+    }
+  }
+  if (index.entries[0].row != 0) {
+    return false;
+  }
+  index.file_size = file_size;
+  index.mtime = int64_t(file_mtime);
+  index.nrows = nrows;
+  return true;
+}
+
+// write the index of a CSV file; returns false if it couldn't be written
+bool write_csv_index(const std::string& filename, const CsvIndex& index) {
+  std::string data(csv_index_magic, magic_size);
+  auto put_word = [&data](uint64_t x) {
+    data.append(reinterpret_cast<const char*>(&x), word_size);
+  };
+  put_word(index.file_size);
+  put_word(uint64_t(index.mtime));
+  put_word(index.nrows);
+  put_word(index.entries.size());
+  for (auto& entry: index.entries) {
+    put_word(entry.offset);
+    put_word(entry.row);
+  }
+
+  std::ofstream out(csv_index_filename(filename), std::ios::binary);
+  out.write(data.data(), data.size());
+  return bool(out);
+}
+
+// find the last entry at or before a row
+size_t find_csv_index_entry(const CsvIndex& index, uint64_t row) {
+  auto iter = std::upper_bound(index.entries.begin(), index.entries.end(),
+                               row, [](uint64_t r, const CsvIndexEntry& e) {
+                                 return r < e.row;
+                               });
+  return (iter == index.entries.begin()) ? 0
+                                         : (iter - index.entries.begin()) - 1;
+}
+}  // namespace VVM
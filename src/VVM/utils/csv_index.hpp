@@ -0,0 +1,64 @@
+/*
+ * CSV Index header -- declares routines for a CSV file's row index
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A row index records where every few thousand rows of a CSV file begin, so
+ * that a range of rows can be found without tokenizing everything before it
+ * and so that the file can be split for workers without scanning for quotes.
+ * It is kept beside the file as a hidden file ("data/.prices.csv.idx"), which
+ * wildcards don't match:
+ *
+ *   magic         "EMPIX001"
+ *   file size     of the CSV file that was indexed
+ *   mtime         modification time (seconds) of the CSV file
+ *   row count     rows after the header
+ *   entry count
+ *   entries       file position of a row, then that row's number
+ *
+ * Every integer is a 64-bit word in the machine's byte order. The first entry
+ * is always the first row after the header. An index is just a cache: one
+ * that doesn't match its file's size and modification time is ignored, and
+ * failing to write one isn't an error.
+ */
+namespace VVM {
+
+// a row's position in the file
+struct CsvIndexEntry {
+  uint64_t offset;
+  uint64_t row;
+};
+
+struct CsvIndex {
+  uint64_t file_size;
+  int64_t mtime;
+  uint64_t nrows;
+  std::vector<CsvIndexEntry> entries;
+};
+
+// number of rows between entries
+const size_t csv_index_stride = 1 << 16;
+
+// smaller files aren't worth writing an index for
+const uint64_t min_indexed_file_size = 1 << 26;
+
+std::string csv_index_filename(const std::string& filename);
+bool stat_csv_file(const std::string& filename, uint64_t& size,
+                   int64_t& mtime);
+bool read_csv_index(const std::string& filename, CsvIndex& index);
+bool write_csv_index(const std::string& filename, const CsvIndex& index);
+size_t find_csv_index_entry(const CsvIndex& index, uint64_t row);
+
+}  // namespace VVM
@@ -9,6 +9,8 @@
  */
 
 #include <cctype>
+#include <cstring>
+#include <memory>
 #include <algorithm>
 #include <string>
 #include <exception>
@@ -17,54 +19,15 @@
 #include <VVM/utils/timestamp.hpp>
 #include <VVM/utils/conversion.hpp>
 #include <VVM/utils/csv_infer.hpp>
+#include <VVM/utils/columnar.hpp>
+#include <VVM/utils/arrow.hpp>
+#include <VVM/utils/gzip.hpp>
+#include <VVM/utils/file_pattern.hpp>
+#include <VVM/utils/parallel.hpp>
 
 #include <csvmonkey/csvmonkey.hpp>
 
 namespace VVM {
-// check whether all elements are blank
-bool is_all_empty(const std::vector<std::string>& xs) {
-  for (auto& x: xs) {
-    if (!x.empty()) {
-      return false;
-    }
-  }
-  return true;
-}
-
-// check whether every element can be converted to an int64
-bool is_int64(const std::vector<std::string>& xs) {
-  for (auto& x: xs) {
-    if (!x.empty()) {
-      if (is_nil(from_string<int64_t>(x))) {
-        return false;
-      }
-    }
-  }
-  return true;
-}
-
-// check whether every element can be converted to a double
-bool is_float64(const std::vector<std::string>& xs) {
-  for (auto& x: xs) {
-    if (!x.empty()) {
-      if (is_nil(from_string<double>(x))) {
-        return false;
-      }
-    }
-  }
-  return true;
-}
-
-// check whether every element can be converted to a bool
-bool is_bool(const std::vector<std::string>& xs) {
-  for (auto& x: xs) {
-    if (x != "true" && x != "false") {
-      return false;
-    }
-  }
-  return true;
-}
-
 // return strtime formats for all strings
 std::vector<std::string> infer_all_strtime_formats(
   const std::vector<std::string>& xs) {
@@ -77,34 +40,18 @@ std::vector<std::string> infer_all_strtime_formats(
   return results;
 }
 
-// check whether every format can represent a time
-bool is_time(const std::vector<std::string>& formats) {
-  for (auto& f: formats) {
-    if (!is_inferred_time(f)) {
-      return false;
-    }
-  }
-  return true;
-}
-
-// check whether every format can represent a date
-bool is_date(const std::vector<std::string>& formats) {
-  for (auto& f: formats) {
-    if (!is_inferred_date(f)) {
-      return false;
-    }
+// return the strtime format shared by all strings, or blank if they differ
+std::string infer_common_strtime_format(const std::vector<std::string>& xs) {
+  auto formats = infer_all_strtime_formats(xs);
+  if (formats.empty()) {
+    return std::string();
   }
-  return true;
-}
-
-// check whether every format can represent a timestamp
-bool is_timestamp(const std::vector<std::string>& formats) {
   for (auto& f: formats) {
-    if (!is_inferred_timestamp(f)) {
-      return false;
+    if (f != formats[0]) {
+      return std::string();
     }
   }
-  return true;
+  return formats[0];
 }
 
 // whether a character is invalid for a header
@@ -144,89 +91,255 @@ std::string fix_header(const std::string& header, size_t position,
   return h;
 }
 
+// types that a column's values could all be, as a set of bits
+enum SampleType: unsigned {
+  kInt64Sample = 1 << 0,
+  kFloat64Sample = 1 << 1,
+  kBoolSample = 1 << 2,
+  kTimeSample = 1 << 3,
+  kDateSample = 1 << 4,
+  kTimestampSample = 1 << 5,
+  kAllSamples = (1 << 6) - 1
+};
+
+// a column's possible types narrow with every value seen, so merging the
+// samples of different parts of a file can only widen the inferred type
+// (Int64 -> Float64 -> String, Date -> Timestamp)
+struct ColumnSample {
+  unsigned types = kAllSamples;
+  bool seen = false;
+
+  // rule out the types that a value can't be
+  void add(const std::string& x) {
+    if (x.empty()) {
+      types &= ~kBoolSample;
+      return;
+    }
+    seen = true;
+    if ((types & kInt64Sample) && is_nil(from_string<int64_t>(x))) {
+      types &= ~kInt64Sample;
+    }
+    if ((types & kFloat64Sample) && is_nil(from_string<double>(x))) {
+      types &= ~kFloat64Sample;
+    }
+    if ((types & kBoolSample) && x != "true" && x != "false") {
+      types &= ~kBoolSample;
+    }
+    if (types & (kTimeSample | kDateSample | kTimestampSample)) {
+      std::string format = infer_strtime_format(x);
+      if (!is_inferred_time(format)) {
+        types &= ~kTimeSample;
+      }
+      if (!is_inferred_date(format)) {
+        types &= ~kDateSample;
+      }
+      if (!is_inferred_timestamp(format)) {
+        types &= ~kTimestampSample;
+      }
+    }
+  }
+
+  void merge(const ColumnSample& other) {
+    types &= other.types;
+    seen = seen || other.seen;
+  }
+};
+
 // return a string of the column's name and type
-std::string infer_col(const std::string& header,
-                      const std::vector<std::string>& xs,
+std::string infer_col(const std::string& header, const ColumnSample& sample,
                       size_t position,
                       std::unordered_set<std::string>& seen) {
   // Empirical identifiers are very particular
   std::string new_header = fix_header(header, position, seen);
   std::string ret = new_header + ": ";
 
-  // try each converter to see what works
-  if (is_all_empty(xs)) {
+  // take the narrowest type that every value fits
+  if (!sample.seen) {
     ret += "String";
   }
-  else if (is_int64(xs)) {
+  else if (sample.types & kInt64Sample) {
     ret += "Int64";
   }
-  else if (is_float64(xs)) {
+  else if (sample.types & kFloat64Sample) {
     ret += "Float64";
   }
-  else if (is_bool(xs)) {
+  else if (sample.types & kBoolSample) {
     ret += "Bool";
   }
+  else if (sample.types & kTimeSample) {
+    ret += "Time";
+  }
+  else if (sample.types & kDateSample) {
+    ret += "Date";
+  }
+  else if (sample.types & kTimestampSample) {
+    ret += "Timestamp";
+  }
   else {
-    auto formats = infer_all_strtime_formats(xs);
-    if (is_time(formats)) {
-      ret += "Time";
+    ret += "String";
+  }
+
+  return ret;
+}
+
+// amount of text sampled from each part of a file
+static const size_t sample_block_size = 1 << 16;
+
+// number of evenly spaced parts of a file that are sampled, which bounds the
+// text read to infer a type however large the file is
+static const size_t max_sample_blocks = 64;
+
+// cursor over the rest of a mapped file from a given position
+class SampleCursor: public csvmonkey::StreamCursor {
+  const char* p_;
+  const char* endp_;
+
+ public:
+  SampleCursor(const char* begin, const char* end): p_(begin), endp_(end) {
+  }
+
+  const char* buf() override {
+    return p_;
+  }
+
+  size_t size() override {
+    return endp_ - p_;
+  }
+
+  void consume(size_t n) override {
+    p_ += std::min(n, size());
+  }
+
+  bool fill() override {
+    return false;
+  }
+};
+
+// sample rows until a block's worth of text has been read; unless ragged
+// rows are allowed, a row that doesn't have every column is skipped since
+// the block may have begun inside a quoted cell
+static void sample_block(csvmonkey::CsvReader& reader, bool ragged,
+                         std::vector<ColumnSample>& samples) {
+  size_t nbytes = 0;
+  while (nbytes < sample_block_size && reader.read_row()) {
+    auto& row = reader.row();
+    const size_t count = row.count;
+    for (size_t col = 0; col < count; col++) {
+      nbytes += row.cells[col].size + 1;
     }
-    else if (is_date(formats)) {
-      ret += "Date";
+    if (ragged) {
+      if (samples.size() < count) {
+        samples.resize(count);
+      }
     }
-    else if (is_timestamp(formats)) {
-      ret += "Timestamp";
+    else if (count != samples.size()) {
+      continue;
     }
-    else {
-      ret += "String";
+    for (size_t col = 0; col < count; col++) {
+      samples[col].add(row.cells[col].as_str());
     }
   }
-
-  return ret;
 }
 
-// return a string of the table's type definition
-std::string infer_table_from_file(const std::string& filename) {
-  // prepare reader
-  csvmonkey::MappedFileCursor cursor;
-  try {
-    cursor.open(filename.c_str());
+// feeds a compressed file to the tokenizer as it is decompressed, so only
+// the rows that are sampled need to be decompressed
+class GzipCursor: public csvmonkey::BufferedStreamCursor {
+  // the tokenizer may read this far past the end of the text
+  static const size_t padding = 16;
+
+  GzipReader reader_;
+
+ public:
+  explicit GzipCursor(const std::string& filename): reader_(filename) {
+  }
+
+  ssize_t readmore() override {
+    ensure(padding + 1);
+    size_t n = reader_.read(&vec_[write_pos_],
+                            vec_.size() - write_pos_ - padding);
+    memset(&vec_[write_pos_ + n], 0, padding);
+    return (n == 0) ? -1 : ssize_t(n);
+  }
+};
+
+// return a string of the table's type definition; a pattern of several files
+// is inferred from just the first
+std::string infer_table_from_file(const std::string& pattern) {
+  const std::string filename = expand_file_pattern(pattern).front();
+
+  // binary files already carry their type definition
+  if (is_columnar_file(filename)) {
+    return read_columnar_type(filename);
   }
-  catch (csvmonkey::Error& e) {
-    throw std::logic_error(e.what());
+  if (is_arrow_file(filename)) {
+    return read_arrow_type(filename);
   }
-  csvmonkey::CsvReader reader(cursor);
 
-  // read and transpose table
+  // prepare reader; csvmonkey's cursors have no virtual destructor, so each
+  // kind is owned by its own type
+  std::unique_ptr<GzipCursor> gzipped;
+  std::unique_ptr<csvmonkey::MappedFileCursor> mapped;
+  csvmonkey::StreamCursor* cursor;
+  if (is_gzip_file(filename)) {
+    gzipped.reset(new GzipCursor(filename));
+    cursor = gzipped.get();
+  }
+  else {
+    mapped.reset(new csvmonkey::MappedFileCursor);
+    cursor = mapped.get();
+    try {
+      mapped->open(filename.c_str());
+    }
+    catch (csvmonkey::Error& e) {
+      throw std::logic_error(e.what());
+    }
+  }
+  csvmonkey::CsvReader reader(*cursor);
+
+  // read the header
   std::vector<std::string> headers;
-  std::vector<std::vector<std::string>> columns;
-  bool is_header = true;
-  const size_t max_rows = 10;
-  size_t nrows = 0;
-  while (reader.read_row() && (nrows++ < max_rows)) {
+  if (reader.read_row()) {
     auto& row = reader.row();
     const size_t count = row.count;
-    if (columns.size() < count) {
-      headers.resize(count);
-      columns.resize(count);
+    for (size_t col = 0; col < count; col++) {
+      headers.push_back(row.cells[col].as_str());
     }
-    size_t col = 0;
-    while (col < count) {
-      if (is_header) {
-        headers[col] = row.cells[col].as_str();
-      } else {
-        columns[col].push_back(row.cells[col].as_str());
+  }
+
+  // the first block of rows may widen the table
+  std::vector<ColumnSample> samples(headers.size());
+  sample_block(reader, true, samples);
+  headers.resize(samples.size());
+
+  // a mapped file is also sampled at evenly spaced blocks in parallel, each
+  // starting at the row after its position; a compressed file can only be
+  // read from the start, so it is just sampled there
+  if (!is_gzip_file(filename)) {
+    const char* begin = cursor->buf();
+    const char* end = begin + cursor->size();
+    size_t nblocks = std::min(max_sample_blocks,
+                              size_t(end - begin) / sample_block_size);
+    std::vector<std::vector<ColumnSample>> block_samples(nblocks);
+    parallel_for(nblocks, [&](size_t i) {
+      const char* p = begin + (end - begin) * i / nblocks;
+      p = std::find(p, end, '\n');
+      SampleCursor block_cursor(std::min(p + 1, end), end);
+      csvmonkey::CsvReader block_reader(block_cursor);
+      block_samples[i].resize(samples.size());
+      sample_block(block_reader, false, block_samples[i]);
+    });
+    for (auto& block: block_samples) {
+      for (size_t col = 0; col < samples.size(); col++) {
+        samples[col].merge(block[col]);
       }
-      col++;
     }
-    is_header = false;
   }
 
   // infer each column
   std::unordered_set<std::string> seen;
-  std::string ret = infer_col(headers[0], columns[0], 0, seen);
-  for (size_t i = 1; i < columns.size(); i++) {
-    ret += ", " + infer_col(headers[i], columns[i], i, seen);
+  std::string ret = infer_col(headers[0], samples[0], 0, seen);
+  for (size_t i = 1; i < samples.size(); i++) {
+    ret += ", " + infer_col(headers[i], samples[i], i, seen);
   }
 
   return ret;
@@ -11,10 +11,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace VVM {
 
 std::string infer_table_from_file(const std::string& filename);
+std::string infer_common_strtime_format(const std::vector<std::string>& xs);
 
 }  // namespace VVM
 
@@ -0,0 +1,192 @@
+/*
+ * File Pattern -- expand a load's or store's filename into a list of files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRA_LEAN
+#include <windows.h>
+#include <direct.h>
+#else  // WIN32
+#include <glob.h>
+#endif  // WIN32
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <VVM/utils/file_pattern.hpp>
+
+namespace VVM {
+// check whether a filename has any wildcards or brace lists
+bool is_file_pattern(const std::string& pattern) {
+  return pattern.find_first_of("*?[{") != std::string::npos;
+}
+
+// return the list of files that a pattern refers to; a plain filename is
+// returned as-is (even if it doesn't exist) so the loader can report it, and
+// so is an existing file whose name happens to have a '[' or '{'
+std::vector<std::string> expand_file_pattern(const std::string& pattern) {
+  struct stat st;
+  if (!is_file_pattern(pattern) || stat(pattern.c_str(), &st) == 0) {
+    return {pattern};
+  }
+
+  std::vector<std::string> filenames;
+#ifdef WIN32
+  // Windows only has wildcards, and only in the last path component
+  size_t slash = pattern.find_last_of("/\\");
+  std::string dir = (slash == std::string::npos) ? ""
+                                                 : pattern.substr(0, slash + 1);
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA(pattern.c_str(), &data);
+  if (handle != INVALID_HANDLE_VALUE) {
+    do {
+      if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        filenames.push_back(dir + data.cFileName);
+      }
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+  }
+  std::sort(filenames.begin(), filenames.end());
+#else  // WIN32
+  // brace lists are an extension, though glibc and the BSDs both have them
+#ifdef GLOB_BRACE
+  const int flags = GLOB_BRACE;
+#else
+  const int flags = 0;
+#endif
+  glob_t matches;
+  int ret = glob(pattern.c_str(), flags, nullptr, &matches);
+  if (ret == 0) {
+    for (size_t i = 0; i < matches.gl_pathc; i++) {
+      filenames.push_back(matches.gl_pathv[i]);
+    }
+  }
+  globfree(&matches);
+  if (ret == GLOB_NOSPACE) {
+    throw std::runtime_error("Out of memory while expanding " + pattern);
+  }
+#endif  // WIN32
+
+  if (filenames.empty()) {
+    throw std::logic_error("No files match " + pattern);
+  }
+  return filenames;
+}
+
+// check whether a filename names any members in braces; a brace list has a
+// comma, so "{jan,feb}.csv" is not a partition
+bool is_partition_pattern(const std::string& pattern) {
+  return !partition_keys(pattern).empty();
+}
+
+// return the member names in braces, in the order they appear
+std::vector<std::string> partition_keys(const std::string& pattern) {
+  std::vector<std::string> keys;
+  size_t open = pattern.find('{');
+  while (open != std::string::npos) {
+    size_t close = pattern.find('}', open);
+    if (close == std::string::npos) {
+      break;
+    }
+    std::string key = pattern.substr(open + 1, close - open - 1);
+    if (!key.empty() && key.find_first_of(",{") == std::string::npos) {
+      keys.push_back(key);
+    }
+    open = pattern.find('{', open + 1);
+  }
+  return keys;
+}
+
+// turn a key's text into something that is safe as (part of) a filename:
+// separators and other reserved characters are percent-encoded, as are the
+// whole of "." and "..", and a nil key becomes "nil"
+std::string partition_value(const std::string& value) {
+  if (value.empty()) {
+    return "nil";
+  }
+  if (value == "." || value == "..") {
+    return value == "." ? "%2E" : "%2E%2E";
+  }
+  static const char hex[] = "0123456789ABCDEF";
+  static const char reserved[] = "/\\%:*?\"<>|";
+  std::string result;
+  for (char c: value) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u < 0x20 || u == 0x7F || std::strchr(reserved, c) != nullptr) {
+      result += '%';
+      result += hex[u >> 4];
+      result += hex[u & 0xF];
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+// replace each member name in braces with its value, which must be listed in
+// the same order as partition_keys() returned them; values are escaped with
+// partition_value() first
+std::string fill_partition(const std::string& pattern,
+                           const std::vector<std::string>& values) {
+  std::string filename;
+  size_t value = 0;
+  size_t start = 0;
+  size_t open = pattern.find('{');
+  while (open != std::string::npos) {
+    size_t close = pattern.find('}', open);
+    if (close == std::string::npos) {
+      break;
+    }
+    std::string key = pattern.substr(open + 1, close - open - 1);
+    if (!key.empty() && key.find_first_of(",{") == std::string::npos) {
+      filename += pattern.substr(start, open - start);
+      filename += partition_value(values.at(value++));
+      start = close + 1;
+      open = pattern.find('{', start);
+    }
+    else {
+      open = pattern.find('{', open + 1);
+    }
+  }
+  filename += pattern.substr(start);
+  return filename;
+}
+
+// create any missing directories that lead up to a file
+void make_parent_dirs(const std::string& filename) {
+#ifdef WIN32
+  const char* separators = "/\\";
+#else  // WIN32
+  const char* separators = "/";
+#endif  // WIN32
+  for (size_t slash = filename.find_first_of(separators, 1);
+       slash != std::string::npos;
+       slash = filename.find_first_of(separators, slash + 1)) {
+    std::string dir = filename.substr(0, slash);
+    struct stat st;
+    if (stat(dir.c_str(), &st) == 0) {
+      continue;
+    }
+#ifdef WIN32
+    int ret = _mkdir(dir.c_str());
+#else  // WIN32
+    int ret = mkdir(dir.c_str(), 0777);
+#endif  // WIN32
+    if (ret != 0 && errno != EEXIST) {
+      throw std::logic_error("Unable to create directory " + dir);
+    }
+  }
+}
+}  // namespace VVM
@@ -0,0 +1,42 @@
+/*
+ * File Pattern header -- declares routines to expand a load's or store's
+ * filename
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * A filename may name several files that share one schema, either with
+ * wildcards ("prices_*.csv") or with a brace list ("{jan,feb}.csv"). Files
+ * matching a wildcard are sorted, so daily files are loaded chronologically
+ * if their names are; brace alternatives keep the order they were listed.
+ * An existing file is always taken literally, even if its name has a '['.
+ *
+ * A store's filename may instead name members in braces ("daily/{symbol}.csv")
+ * to write one file per unique key; each brace is filled with that key's
+ * value. Values are escaped so that a key can't add or leave a directory: a
+ * separator becomes "%2F", "." and ".." become "%2E" and "%2E%2E", and a nil
+ * key becomes "nil".
+ */
+namespace VVM {
+
+bool is_file_pattern(const std::string& pattern);
+std::vector<std::string> expand_file_pattern(const std::string& pattern);
+
+bool is_partition_pattern(const std::string& pattern);
+std::vector<std::string> partition_keys(const std::string& pattern);
+std::string partition_value(const std::string& value);
+std::string fill_partition(const std::string& pattern,
+                           const std::vector<std::string>& values);
+void make_parent_dirs(const std::string& filename);
+
+}  // namespace VVM
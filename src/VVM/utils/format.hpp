@@ -0,0 +1,545 @@
+/*
+ * Format -- write numbers as text without exceptions or allocation
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+
+/*
+ * Write a number into a caller's buffer, which must hold at least
+ * max_format_size characters. Nothing is NUL-terminated; the number of
+ * characters written is returned instead.
+ *
+ * This file introduces these functions:
+ *   1. format_int64(x, p)         : decimal integer (format_uint64 unsigned)
+ *   2. format_shortest_float64(x, p): fewest digits that read back as x
+ *   3. format_float64(x, p)       : six decimal places, same as std::to_string()
+ *   4. count_float_zeros(p, n)    : excess zeros at the end of a formatted float
+ *   5. trim_float_zeros(p, n, z)  : size after removing that many excess zeros
+ *   6. count_float64_zeros(x)     : same as 4, but without formatting x first
+ *
+ * The shortest digits of a float come from Grisu3 (Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers", 2010), which
+ * needs only 64-bit integers; the rare number that it can't settle goes
+ * through snprintf(). Floats keep std::to_string()'s six places so that a
+ * column trims to the same text as before, and those places are rounded
+ * from the shortest digits.
+ */
+namespace VVM {
+// longest text from any of the formatters (a float of DBL_MAX is 316)
+const size_t max_format_size = 328;
+
+// pairs of decimal digits, so integers are written two digits at a time
+static const char format_digit_pairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+// write a 64-bit unsigned integer
+inline size_t format_uint64(uint64_t u, char* buffer) {
+  // digits are generated backwards into scratch space, then copied
+  char scratch[20];
+  char* end = scratch + sizeof(scratch);
+  char* q = end;
+  while (u >= 100) {
+    size_t pair = (u % 100) * 2;
+    u /= 100;
+    *--q = format_digit_pairs[pair + 1];
+    *--q = format_digit_pairs[pair];
+  }
+  if (u >= 10) {
+    size_t pair = u * 2;
+    *--q = format_digit_pairs[pair + 1];
+    *--q = format_digit_pairs[pair];
+  }
+  else {
+    *--q = char('0' + u);
+  }
+
+  size_t n = end - q;
+  std::memcpy(buffer, q, n);
+  return n;
+}
+
+// write a 64-bit signed integer
+inline size_t format_int64(int64_t x, char* buffer) {
+  if (x < 0) {
+    *buffer = '-';
+    return format_uint64(0 - uint64_t(x), buffer + 1) + 1;
+  }
+  return format_uint64(uint64_t(x), buffer);
+}
+
+namespace grisu {
+// a float as an integer significand and a binary exponent: f * 2^e
+struct DiyFp {
+  uint64_t f;
+  int e;
+};
+
+// the top 64 bits of the product, rounded
+inline DiyFp multiply(DiyFp x, DiyFp y) {
+  static const uint64_t mask = 0xFFFFFFFFULL;
+  uint64_t a = x.f >> 32, b = x.f & mask;
+  uint64_t c = y.f >> 32, d = y.f & mask;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  uint64_t mid = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+  return DiyFp{ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64};
+}
+
+inline DiyFp normalize(DiyFp x) {
+  while ((x.f & (1ULL << 63)) == 0) {
+    x.f <<= 1;
+    x.e--;
+  }
+  return x;
+}
+
+// powers of ten from 10^-348 to 10^340, every eighth one, normalized
+struct CachedPower {
+  uint64_t f;
+  int16_t e;
+  int16_t k;
+};
+
+static const CachedPower cached_powers[] = {
+  {0xfa8fd5a0081c0288ULL, -1220, -348},
+  {0xbaaee17fa23ebf76ULL, -1193, -340},
+  {0x8b16fb203055ac76ULL, -1166, -332},
+  {0xcf42894a5dce35eaULL, -1140, -324},
+  {0x9a6bb0aa55653b2dULL, -1113, -316},
+  {0xe61acf033d1a45dfULL, -1087, -308},
+  {0xab70fe17c79ac6caULL, -1060, -300},
+  {0xff77b1fcbebcdc4fULL, -1034, -292},
+  {0xbe5691ef416bd60cULL, -1007, -284},
+  {0x8dd01fad907ffc3cULL, -980, -276},
+  {0xd3515c2831559a83ULL, -954, -268},
+  {0x9d71ac8fada6c9b5ULL, -927, -260},
+  {0xea9c227723ee8bcbULL, -901, -252},
+  {0xaecc49914078536dULL, -874, -244},
+  {0x823c12795db6ce57ULL, -847, -236},
+  {0xc21094364dfb5637ULL, -821, -228},
+  {0x9096ea6f3848984fULL, -794, -220},
+  {0xd77485cb25823ac7ULL, -768, -212},
+  {0xa086cfcd97bf97f4ULL, -741, -204},
+  {0xef340a98172aace5ULL, -715, -196},
+  {0xb23867fb2a35b28eULL, -688, -188},
+  {0x84c8d4dfd2c63f3bULL, -661, -180},
+  {0xc5dd44271ad3cdbaULL, -635, -172},
+  {0x936b9fcebb25c996ULL, -608, -164},
+  {0xdbac6c247d62a584ULL, -582, -156},
+  {0xa3ab66580d5fdaf6ULL, -555, -148},
+  {0xf3e2f893dec3f126ULL, -529, -140},
+  {0xb5b5ada8aaff80b8ULL, -502, -132},
+  {0x87625f056c7c4a8bULL, -475, -124},
+  {0xc9bcff6034c13053ULL, -449, -116},
+  {0x964e858c91ba2655ULL, -422, -108},
+  {0xdff9772470297ebdULL, -396, -100},
+  {0xa6dfbd9fb8e5b88fULL, -369, -92},
+  {0xf8a95fcf88747d94ULL, -343, -84},
+  {0xb94470938fa89bcfULL, -316, -76},
+  {0x8a08f0f8bf0f156bULL, -289, -68},
+  {0xcdb02555653131b6ULL, -263, -60},
+  {0x993fe2c6d07b7facULL, -236, -52},
+  {0xe45c10c42a2b3b06ULL, -210, -44},
+  {0xaa242499697392d3ULL, -183, -36},
+  {0xfd87b5f28300ca0eULL, -157, -28},
+  {0xbce5086492111aebULL, -130, -20},
+  {0x8cbccc096f5088ccULL, -103, -12},
+  {0xd1b71758e219652cULL, -77, -4},
+  {0x9c40000000000000ULL, -50, 4},
+  {0xe8d4a51000000000ULL, -24, 12},
+  {0xad78ebc5ac620000ULL, 3, 20},
+  {0x813f3978f8940984ULL, 30, 28},
+  {0xc097ce7bc90715b3ULL, 56, 36},
+  {0x8f7e32ce7bea5c70ULL, 83, 44},
+  {0xd5d238a4abe98068ULL, 109, 52},
+  {0x9f4f2726179a2245ULL, 136, 60},
+  {0xed63a231d4c4fb27ULL, 162, 68},
+  {0xb0de65388cc8ada8ULL, 189, 76},
+  {0x83c7088e1aab65dbULL, 216, 84},
+  {0xc45d1df942711d9aULL, 242, 92},
+  {0x924d692ca61be758ULL, 269, 100},
+  {0xda01ee641a708deaULL, 295, 108},
+  {0xa26da3999aef774aULL, 322, 116},
+  {0xf209787bb47d6b85ULL, 348, 124},
+  {0xb454e4a179dd1877ULL, 375, 132},
+  {0x865b86925b9bc5c2ULL, 402, 140},
+  {0xc83553c5c8965d3dULL, 428, 148},
+  {0x952ab45cfa97a0b3ULL, 455, 156},
+  {0xde469fbd99a05fe3ULL, 481, 164},
+  {0xa59bc234db398c25ULL, 508, 172},
+  {0xf6c69a72a3989f5cULL, 534, 180},
+  {0xb7dcbf5354e9beceULL, 561, 188},
+  {0x88fcf317f22241e2ULL, 588, 196},
+  {0xcc20ce9bd35c78a5ULL, 614, 204},
+  {0x98165af37b2153dfULL, 641, 212},
+  {0xe2a0b5dc971f303aULL, 667, 220},
+  {0xa8d9d1535ce3b396ULL, 694, 228},
+  {0xfb9b7cd9a4a7443cULL, 720, 236},
+  {0xbb764c4ca7a44410ULL, 747, 244},
+  {0x8bab8eefb6409c1aULL, 774, 252},
+  {0xd01fef10a657842cULL, 800, 260},
+  {0x9b10a4e5e9913129ULL, 827, 268},
+  {0xe7109bfba19c0c9dULL, 853, 276},
+  {0xac2820d9623bf429ULL, 880, 284},
+  {0x80444b5e7aa7cf85ULL, 907, 292},
+  {0xbf21e44003acdd2dULL, 933, 300},
+  {0x8e679c2f5e44ff8fULL, 960, 308},
+  {0xd433179d9c8cb841ULL, 986, 316},
+  {0x9e19db92b4e31ba9ULL, 1013, 324},
+  {0xeb96bf6ebadf77d9ULL, 1039, 332},
+  {0xaf87023b9bf0ee6bULL, 1066, 340},
+};
+
+// a cached power c such that w * c has a binary exponent of -60 to -32,
+// so the integral part of the scaled number fits in 32 bits
+inline CachedPower cached_power(int e) {
+  int k = int(std::ceil((-60 - (e + 64) + 63) * 0.30102999566398114));
+  return cached_powers[(348 + k - 1) / 8 + 1];
+}
+
+// move the last digit toward w while that stays in the interval, then
+// report whether the result is certainly the closest shortest one
+inline bool round_weed(char* digits, size_t n, uint64_t distance_high_w,
+                       uint64_t unsafe_interval, uint64_t rest,
+                       uint64_t ten_kappa, uint64_t unit) {
+  uint64_t small_distance = distance_high_w - unit;
+  uint64_t big_distance = distance_high_w + unit;
+  while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+         (rest + ten_kappa < small_distance ||
+          small_distance - rest >= rest + ten_kappa - small_distance)) {
+    digits[n - 1]--;
+    rest += ten_kappa;
+  }
+  if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+      (rest + ten_kappa < big_distance ||
+       big_distance - rest > rest + ten_kappa - big_distance)) {
+    return false;
+  }
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// generate the shortest digits within the scaled boundaries
+inline bool digit_gen(DiyFp low, DiyFp w, DiyFp high, char* digits,
+                      size_t& n, int& kappa) {
+  static const uint32_t powers_of_ten[] = {1, 10, 100, 1000, 10000, 100000,
+                                           1000000, 10000000, 100000000,
+                                           1000000000};
+  uint64_t unit = 1;
+  DiyFp too_low{low.f - unit, low.e};
+  DiyFp too_high{high.f + unit, high.e};
+  uint64_t unsafe_interval = too_high.f - too_low.f;
+  int shift = -w.e;
+  uint64_t one = 1ULL << shift;
+  uint32_t integrals = uint32_t(too_high.f >> shift);
+  uint64_t fractionals = too_high.f & (one - 1);
+
+  uint32_t divisor = 0;
+  kappa = 0;
+  for (int i = 9; i >= 0; i--) {
+    if (integrals >= powers_of_ten[i]) {
+      divisor = powers_of_ten[i];
+      kappa = i + 1;
+      break;
+    }
+  }
+
+  n = 0;
+  while (kappa > 0) {
+    digits[n++] = char('0' + integrals / divisor);
+    integrals %= divisor;
+    kappa--;
+    uint64_t rest = (uint64_t(integrals) << shift) + fractionals;
+    if (rest < unsafe_interval) {
+      return round_weed(digits, n, too_high.f - w.f, unsafe_interval, rest,
+                        uint64_t(divisor) << shift, unit);
+    }
+    divisor /= 10;
+  }
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    digits[n++] = char('0' + (fractionals >> shift));
+    fractionals &= one - 1;
+    kappa--;
+    if (fractionals < unsafe_interval) {
+      return round_weed(digits, n, (too_high.f - w.f) * unit,
+                        unsafe_interval, fractionals, one, unit);
+    }
+  }
+}
+}  // namespace grisu
+
+// the shortest digits that read back as a positive, finite x, so that x is
+// digits * 10^exponent; false if Grisu3 couldn't be sure of them
+inline bool float64_digits(double x, char* digits, size_t& n, int& exponent) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint64_t significand = bits & ((1ULL << 52) - 1);
+  int biased = int(bits >> 52) & 0x7FF;
+  grisu::DiyFp v;
+  if (biased == 0) {
+    v = grisu::DiyFp{significand, -1074};
+  }
+  else {
+    v = grisu::DiyFp{significand | (1ULL << 52), biased - 1075};
+  }
+
+  // the boundaries are halfway to the neighboring floats; the one below is
+  // closer when x is a power of two
+  grisu::DiyFp plus = grisu::normalize(grisu::DiyFp{(v.f << 1) + 1, v.e - 1});
+  grisu::DiyFp minus;
+  if (significand == 0 && biased > 1) {
+    minus = grisu::DiyFp{(v.f << 2) - 1, v.e - 2};
+  }
+  else {
+    minus = grisu::DiyFp{(v.f << 1) - 1, v.e - 1};
+  }
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  grisu::DiyFp w = grisu::normalize(v);
+
+  grisu::CachedPower c = grisu::cached_power(w.e);
+  grisu::DiyFp ten_mk{c.f, c.e};
+  int kappa;
+  bool ok = grisu::digit_gen(grisu::multiply(minus, ten_mk),
+                             grisu::multiply(w, ten_mk),
+                             grisu::multiply(plus, ten_mk), digits, n, kappa);
+  exponent = kappa - c.k;
+  return ok;
+}
+
+// digits of a positive, finite x by trying each precision with snprintf(),
+// where Grisu3 gives up; since each try is rounded to nearest, this can be
+// a digit longer than the shortest, but it still reads back as x
+inline void float64_digits_slow(double x, char* digits, size_t& n,
+                                int& exponent) {
+  char text[32];
+  for (int precision = 1; precision <= 17; precision++) {
+    std::snprintf(text, sizeof(text), "%.*e", precision - 1, x);
+    if (std::strtod(text, nullptr) == x || precision == 17) {
+      break;
+    }
+  }
+  // text is d.ddde[+-]xx
+  n = 0;
+  const char* p = text;
+  for (; *p != 'e'; p++) {
+    if (*p != '.') {
+      digits[n++] = *p;
+    }
+  }
+  while (n > 1 && digits[n - 1] == '0') {
+    n--;
+  }
+  exponent = std::atoi(p + 1) - int(n) + 1;
+}
+
+// write a 64-bit float with the fewest significant digits that read back as
+// the same number; large and small magnitudes are in scientific notation
+inline size_t format_shortest_float64(double x, char* buffer) {
+  if (!std::isfinite(x)) {
+    int n = std::snprintf(buffer, max_format_size, "%f", x);
+    return n < 0 ? 0 : size_t(n);
+  }
+
+  char* p = buffer;
+  if (std::signbit(x)) {
+    *p++ = '-';
+    x = -x;
+  }
+  if (x == 0.0) {
+    std::memcpy(p, "0.0", 3);
+    return p - buffer + 3;
+  }
+
+  char digits[24];
+  size_t n;
+  int exponent;
+  if (!float64_digits(x, digits, n, exponent)) {
+    float64_digits_slow(x, digits, n, exponent);
+  }
+
+  // digits before the decimal point
+  int point = int(n) + exponent;
+  if (point > -4 && point <= 16) {
+    if (point <= 0) {
+      *p++ = '0';
+      *p++ = '.';
+      std::memset(p, '0', -point);
+      p += -point;
+      std::memcpy(p, digits, n);
+      p += n;
+    }
+    else if (size_t(point) >= n) {
+      std::memcpy(p, digits, n);
+      p += n;
+      std::memset(p, '0', point - n);
+      p += point - n;
+      *p++ = '.';
+      *p++ = '0';
+    }
+    else {
+      std::memcpy(p, digits, point);
+      p += point;
+      *p++ = '.';
+      std::memcpy(p, digits + point, n - point);
+      p += n - point;
+    }
+  }
+  else {
+    *p++ = digits[0];
+    if (n > 1) {
+      *p++ = '.';
+      std::memcpy(p, digits + 1, n - 1);
+      p += n - 1;
+    }
+    int e = point - 1;
+    *p++ = 'e';
+    *p++ = e < 0 ? '-' : '+';
+    e = e < 0 ? -e : e;
+    if (e < 10) {
+      *p++ = '0';
+    }
+    p += format_uint64(uint64_t(e), p);
+  }
+  return p - buffer;
+}
+
+// write a non-negative integer and six decimal places as fixed point
+inline size_t format_fixed6(bool negative, uint64_t whole, uint64_t places,
+                            char* buffer) {
+  char* p = buffer;
+  if (negative) {
+    *p++ = '-';
+  }
+  p += format_uint64(whole, p);
+  *p++ = '.';
+  char scratch[20];
+  format_uint64(places + 1000000, scratch);
+  std::memcpy(p, scratch + 1, 6);
+  return p - buffer + 6;
+}
+
+// write a 64-bit float with six decimal places
+inline size_t format_float64(double x, char* buffer) {
+  double a = std::fabs(x);
+  bool negative = std::signbit(x);
+  if (a == 0.0) {
+    return format_fixed6(negative, 0, 0, buffer);
+  }
+
+  // below 2^32 a float is within half a millionth of its shortest digits,
+  // so rounding those to six places rounds the float, unless they end
+  // exactly halfway
+  if (a < 4294967296.0) {
+    char digits[24];
+    size_t n;
+    int exponent;
+    if (float64_digits(a, digits, n, exponent)) {
+      int keep = int(n) + exponent + 6;
+      if (keep < 0) {
+        return format_fixed6(negative, 0, 0, buffer);
+      }
+      bool tie = size_t(keep) == n - 1 && digits[keep] == '5';
+      if (!tie) {
+        uint64_t scaled = 0;
+        for (int i = 0; i < keep; i++) {
+          scaled = scaled * 10 + (size_t(i) < n ? digits[i] - '0' : 0);
+        }
+        if (size_t(keep) < n && digits[keep] >= '5') {
+          scaled++;
+        }
+        return format_fixed6(negative, scaled / 1000000, scaled % 1000000,
+                             buffer);
+      }
+    }
+  }
+  // from 2^32 to 2^64 the fraction has at most 20 bits, so the places can
+  // be found exactly; ties go to even, as printf() does
+  else if (a < 18446744073709551616.0) {
+    uint64_t whole = uint64_t(a);
+    uint64_t bits = uint64_t((a - double(whole)) * 1048576.0);  // 2^20
+    uint64_t product = bits * 1000000;
+    uint64_t places = product >> 20;
+    uint64_t rest = product & ((1ULL << 20) - 1);
+    if (rest > (1ULL << 19) || (rest == (1ULL << 19) && (places & 1))) {
+      places++;
+    }
+    if (places == 1000000) {
+      whole++;
+      places = 0;
+    }
+    return format_fixed6(negative, whole, places, buffer);
+  }
+
+  int n = std::snprintf(buffer, max_format_size, "%.6f", x);
+  return n < 0 ? 0 : std::min(size_t(n), max_format_size - 1);
+}
+
+// count the zeros at the end of a formatted float
+inline size_t count_float_zeros(const char* text, size_t size) {
+  size_t n = 0;
+  while (n < size && text[size - n - 1] == '0') {
+    n++;
+  }
+  return n;
+}
+
+// count the zeros that format_float64() would end a number with; the six
+// places are found from the scaled number, unless it's too large or so near
+// a tie that the scaling's rounding could change the last digit
+inline size_t count_float64_zeros(double x) {
+  double scaled = std::fabs(x) * 1e6;
+  if (scaled < 4503599627370496.0) {  // 2^52
+    double whole = std::floor(scaled);
+    double frac = scaled - whole;
+    if (std::fabs(frac - 0.5) > std::ldexp(scaled, -50)) {
+      uint64_t places = (uint64_t(whole) + (frac > 0.5 ? 1 : 0)) % 1000000;
+      if (places == 0) {
+        return 6;
+      }
+      size_t n = 0;
+      while (places % 10 == 0) {
+        places /= 10;
+        n++;
+      }
+      return n;
+    }
+  }
+  char buffer[max_format_size];
+  return count_float_zeros(buffer, format_float64(x, buffer));
+}
+
+// remove excess zeros from a formatted float, keeping a digit after the
+// decimal point; returns the new size
+inline size_t trim_float_zeros(char* text, size_t size, size_t zeros) {
+  size -= zeros;
+  if (size > 0 && text[size - 1] == '.') {
+    text[size++] = '0';
+  }
+  return size;
+}
+}  // namespace VVM
@@ -0,0 +1,139 @@
+/*
+ * Gzip -- read gzip-compressed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include <sysconfig.hpp>
+
+#ifdef EMPIRICAL_GZIP
+#include <zlib.h>
+#endif
+
+#include <VVM/utils/gzip.hpp>
+
+namespace VVM {
+// zlib's own buffer for compressed input
+static const unsigned gzip_input_size = 1 << 17;
+
+// check whether a file should be decompressed
+bool is_gzip_file(const std::string& filename) {
+  const std::string ext = ".gz";
+  return filename.size() > ext.size() &&
+         filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+#ifdef EMPIRICAL_GZIP
+GzipReader::GzipReader(const std::string& filename) {
+  file_ = gzopen(filename.c_str(), "rb");
+  if (file_ == nullptr) {
+    throw std::logic_error(filename + ": " + strerror(errno));
+  }
+  gzbuffer(file_, gzip_input_size);
+}
+
+GzipReader::~GzipReader() {
+  gzclose(file_);
+}
+
+size_t GzipReader::read(char* buffer, size_t size) {
+  // zlib reads at most an unsigned int at a time
+  size_t total = 0;
+  while (total < size) {
+    unsigned n = unsigned(std::min(size - total, size_t(UINT_MAX)));
+    int got = gzread(file_, buffer + total, n);
+    if (got <= 0) {
+      // a file that ends in the middle of a member is an error too
+      int errnum;
+      const char* msg = gzerror(file_, &errnum);
+      if (errnum != Z_OK) {
+        throw std::logic_error(std::string("Invalid gzip file: ") + msg);
+      }
+      break;
+    }
+    total += size_t(got);
+  }
+  return total;
+}
+#else
+// without zlib, no compressed file can even be opened
+GzipReader::GzipReader(const std::string& filename): file_(nullptr) {
+  throw std::logic_error(filename + ": gzip files need a build with zlib");
+}
+
+GzipReader::~GzipReader() {
+}
+
+size_t GzipReader::read(char* buffer, size_t size) {
+  return 0;
+}
+#endif
+
+GzipStream::GzipStream(const std::string& filename, size_t block_size)
+  : reader_(filename), block_size_(block_size), done_(false), stop_(false),
+    thread_(&GzipStream::run, this) {
+}
+
+GzipStream::~GzipStream() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+// decompress blocks until the file ends or the reader is destroyed
+void GzipStream::run() {
+  try {
+    while (true) {
+      std::string block(block_size_, '\0');
+      block.resize(reader_.read(&block[0], block.size()));
+      if (block.empty()) {
+        break;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() {
+        return blocks_.size() < gzip_queue_depth || stop_;
+      });
+      if (stop_) {
+        break;
+      }
+      blocks_.push_back(std::move(block));
+      cv_.notify_all();
+    }
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  done_ = true;
+  cv_.notify_all();
+}
+
+bool GzipStream::next(std::string& text) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this]() { return !blocks_.empty() || done_; });
+  if (blocks_.empty()) {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return false;
+  }
+  text += blocks_.front();
+  blocks_.pop_front();
+  cv_.notify_all();
+  return true;
+}
+}  // namespace VVM
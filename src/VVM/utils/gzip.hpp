@@ -0,0 +1,85 @@
+/*
+ * Gzip header -- declares routines for reading gzip-compressed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// zlib's handle for a compressed file
+struct gzFile_s;
+
+/*
+ * Files with the ".gz" extension are decompressed as they are read, so the
+ * uncompressed text never has to be written to disk. Every member of a file
+ * is read in turn (as written by bgzip or by concatenating files), and a
+ * file that isn't actually compressed is read as is.
+ *
+ * GzipReader decompresses on the calling thread, which is all that reading
+ * the first few rows needs. GzipStream decompresses on a background thread
+ * into fixed-size blocks instead, so that a caller can parse one block while
+ * the next is being decompressed.
+ */
+namespace VVM {
+
+// amount of decompressed text handed over at a time
+const size_t gzip_block_size = 1 << 24;
+
+// number of decompressed blocks that may wait to be parsed
+const size_t gzip_queue_depth = 2;
+
+bool is_gzip_file(const std::string& filename);
+
+class GzipReader {
+ public:
+  explicit GzipReader(const std::string& filename);
+  ~GzipReader();
+
+  GzipReader(const GzipReader&) = delete;
+  GzipReader& operator=(const GzipReader&) = delete;
+
+  // fill as much of the buffer as possible; returns zero at the end
+  size_t read(char* buffer, size_t size);
+
+ private:
+  gzFile_s* file_;
+};
+
+class GzipStream {
+ public:
+  explicit GzipStream(const std::string& filename,
+                      size_t block_size = gzip_block_size);
+  ~GzipStream();
+
+  GzipStream(const GzipStream&) = delete;
+  GzipStream& operator=(const GzipStream&) = delete;
+
+  // append the next block of text; returns false once there is no more
+  bool next(std::string& text);
+
+ private:
+  void run();
+
+  GzipReader reader_;
+  size_t block_size_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::string> blocks_;
+  bool done_;
+  bool stop_;
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+}  // namespace VVM
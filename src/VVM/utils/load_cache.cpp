@@ -0,0 +1,153 @@
+/*
+ * Load Cache -- snapshots of parsed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRA_LEAN
+#include <windows.h>
+#include <process.h>
+#include <sys/utime.h>
+#define PATH_MAX _MAX_PATH
+#else  // WIN32
+#include <unistd.h>
+#include <utime.h>
+#endif  // WIN32
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <VVM/utils/load_cache.hpp>
+#include <VVM/utils/file_pattern.hpp>
+
+namespace VVM {
+// directory for snapshots, or blank if there is no cache
+std::string load_cache_dir() {
+  char* env = getenv("EMPIRICAL_CACHE");
+  return (env != nullptr) ? env : "";
+}
+
+// total size that the snapshots may reach
+uint64_t load_cache_size() {
+  char* env = getenv("EMPIRICAL_CACHE_SIZE");
+  long long n = (env != nullptr) ? atoll(env) : 0;
+  return (n <= 0) ? default_load_cache_size : uint64_t(n) << 20;
+}
+
+// 64-bit FNV-1a hash
+static uint64_t hash_key(const std::string& key) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c: key) {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+// the snapshot of a file as loaded with a type; blank if the file is gone
+std::string snapshot_filename(const std::string& dir,
+                              const std::string& filename,
+                              const std::string& type_def) {
+  char path[PATH_MAX];
+  struct stat st;
+#ifdef WIN32
+  char* resolved = _fullpath(path, filename.c_str(), PATH_MAX);
+#else  // WIN32
+  char* resolved = realpath(filename.c_str(), path);
+#endif  // WIN32
+  if (resolved == nullptr || stat(path, &st) != 0) {
+    return std::string();
+  }
+  std::string key = std::string(path) + '\0' +
+                    std::to_string(st.st_size) + '\0' +
+                    std::to_string(st.st_mtime) + '\0' + type_def;
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.edf",
+           static_cast<unsigned long long>(hash_key(key)));
+  return dir + '/' + name;
+}
+
+// a file to write a snapshot into before it is renamed into place; the
+// name is unique to this process and call, so concurrent saves can't collide
+std::string snapshot_temp_filename(const std::string& snapshot) {
+  static std::atomic<uint64_t> counter(0);
+#ifdef WIN32
+  long long pid = _getpid();
+#else  // WIN32
+  long long pid = getpid();
+#endif  // WIN32
+  return snapshot + '.' + std::to_string(pid) + '.' +
+         std::to_string(counter++) + ".tmp";
+}
+
+// move a finished snapshot into place, replacing any that is already there
+bool rename_snapshot(const std::string& temp, const std::string& snapshot) {
+#ifdef WIN32
+  return MoveFileExA(temp.c_str(), snapshot.c_str(),
+                     MOVEFILE_REPLACE_EXISTING) != 0;
+#else  // WIN32
+  return std::rename(temp.c_str(), snapshot.c_str()) == 0;
+#endif  // WIN32
+}
+
+// mark a snapshot as just used
+void touch_snapshot(const std::string& snapshot) {
+#ifdef WIN32
+  _utime(snapshot.c_str(), nullptr);
+#else  // WIN32
+  utime(snapshot.c_str(), nullptr);
+#endif  // WIN32
+}
+
+// delete the least recently used snapshots until the rest fit the size
+void evict_snapshots(const std::string& dir, uint64_t size) {
+  struct Snapshot {
+    std::string filename;
+    int64_t mtime;
+    uint64_t size;
+  };
+
+  std::vector<std::string> filenames;
+  try {
+    filenames = expand_file_pattern(dir + "/*.edf");
+  }
+  catch (std::logic_error& e) {
+    return;
+  }
+  std::vector<Snapshot> snapshots;
+  uint64_t total = 0;
+  for (auto& filename: filenames) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) == 0) {
+      snapshots.push_back(
+        Snapshot{filename, int64_t(st.st_mtime), uint64_t(st.st_size)});
+      total += uint64_t(st.st_size);
+    }
+  }
+
+  std::sort(snapshots.begin(), snapshots.end(),
+            [](const Snapshot& a, const Snapshot& b) {
+              return a.mtime < b.mtime;
+            });
+  for (auto& snapshot: snapshots) {
+    if (total <= size) {
+      break;
+    }
+    if (remove(snapshot.filename.c_str()) == 0) {
+      total -= snapshot.size;
+    }
+  }
+}
+}  // namespace VVM
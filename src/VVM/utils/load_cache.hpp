@@ -0,0 +1,45 @@
+/*
+ * Load Cache header -- declares routines for snapshots of parsed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+ * The load cache keeps a snapshot of each CSV file that was parsed, in the
+ * native binary format, so that loading the unchanged file again only needs
+ * to map the snapshot. It is off unless the EMPIRICAL_CACHE environment
+ * variable names a directory for the snapshots.
+ *
+ * A snapshot is named by a hash of the file's absolute path, size,
+ * modification time, and type definition, so a file that changes (or is
+ * loaded with another type) just gets a new snapshot. Once the snapshots
+ * total more than EMPIRICAL_CACHE_SIZE megabytes, the least recently used
+ * are deleted. A snapshot is written under a temporary name that is unique
+ * to the process and then renamed into place, so that concurrent loads
+ * never see a partial one.
+ */
+namespace VVM {
+
+// total size of the snapshots if EMPIRICAL_CACHE_SIZE isn't set
+const uint64_t default_load_cache_size = uint64_t(4096) << 20;
+
+std::string load_cache_dir();
+uint64_t load_cache_size();
+std::string snapshot_filename(const std::string& dir,
+                              const std::string& filename,
+                              const std::string& type_def);
+std::string snapshot_temp_filename(const std::string& snapshot);
+bool rename_snapshot(const std::string& temp, const std::string& snapshot);
+void touch_snapshot(const std::string& snapshot);
+void evict_snapshots(const std::string& dir, uint64_t size);
+
+}  // namespace VVM
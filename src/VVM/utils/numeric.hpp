@@ -0,0 +1,221 @@
+/*
+ * Numeric -- parse numbers from text without exceptions or allocation
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <VVM/utils/nil.hpp>
+
+/*
+ * Parse a number from a pointer and size, so cells of a mapped file can be
+ * converted in place. Leading whitespace is skipped (like strtol/strtod), but
+ * anything else that isn't part of the number makes the result nil.
+ *
+ * This file introduces these functions:
+ *   1. parse_int64(p, n)   : decimal integer, nil on overflow
+ *   2. parse_float64(p, n) : decimal float, correctly rounded
+ *   3. parse_bool(p, n)    : only "true" is true
+ *
+ * Typical decimals (up to 19 significant digits with a small exponent) are
+ * computed exactly with a single rounding. Anything else, like hex floats,
+ * "inf" or very long mantissas, is handed to strtod.
+ */
+namespace VVM {
+// whether a character is whitespace in the "C" locale
+inline bool is_space_char(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// whether a character is a decimal digit
+inline bool is_digit_char(char c) {
+  return unsigned(c - '0') <= 9;
+}
+
+// parse a 64-bit signed integer
+inline int64_t parse_int64(const char* text, size_t size) {
+  const char* p = text;
+  const char* end = text + size;
+  while (p < end && is_space_char(*p)) {
+    p++;
+  }
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+  if (p == end) {
+    return nil_value<int64_t>();
+  }
+
+  const uint64_t limit = negative ? uint64_t(INT64_MAX) + 1 : INT64_MAX;
+  uint64_t value = 0;
+  for (; p < end; p++) {
+    unsigned digit = unsigned(*p - '0');
+    if (digit > 9 || value > (limit - digit) / 10) {
+      return nil_value<int64_t>();
+    }
+    value = value * 10 + digit;
+  }
+
+  if (negative && value != 0) {
+    return -int64_t(value - 1) - 1;
+  }
+  return int64_t(value);
+}
+
+// parse a double with the standard library (for the uncommon cases)
+inline double parse_float64_slow(const char* text, size_t size) {
+  char buffer[128];
+  std::string copy;
+  const char* str = buffer;
+  if (size < sizeof(buffer)) {
+    memcpy(buffer, text, size);
+    buffer[size] = '\0';
+  }
+  else {
+    copy.assign(text, size);
+    str = copy.c_str();
+  }
+  char* end;
+  double result = strtod(str, &end);
+  if (size == 0 || end != str + size) {
+    return nil_value<double>();
+  }
+  return result;
+}
+
+// parse a 64-bit floating point
+inline double parse_float64(const char* text, size_t size) {
+  // powers of ten that are exactly representable
+  static const double exact_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  static const uint64_t max_exact_mantissa = uint64_t(1) << 53;
+  static const int max_digits = 19;
+
+  const char* p = text;
+  const char* end = text + size;
+  while (p < end && is_space_char(*p)) {
+    p++;
+  }
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+
+  // accumulate significant digits; the value is mantissa * 10^exponent
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  bool truncated = false;
+  for (; p < end && is_digit_char(*p); p++) {
+    any_digits = true;
+    if (digits < max_digits) {
+      mantissa = mantissa * 10 + unsigned(*p - '0');
+      digits += (mantissa != 0);
+    }
+    else {
+      exponent++;
+      truncated |= (*p != '0');
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && is_digit_char(*p); p++) {
+      any_digits = true;
+      if (digits < max_digits) {
+        mantissa = mantissa * 10 + unsigned(*p - '0');
+        digits += (mantissa != 0);
+        exponent--;
+      }
+      else {
+        truncated |= (*p != '0');
+      }
+    }
+  }
+  if (!any_digits) {
+    // could be "inf", "nan" or just garbage
+    return parse_float64_slow(text, size);
+  }
+
+  // optional exponent
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negative_exp = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negative_exp = (*p == '-');
+      p++;
+    }
+    if (p == end || !is_digit_char(*p)) {
+      return nil_value<double>();
+    }
+    int exp_value = 0;
+    for (; p < end && is_digit_char(*p); p++) {
+      if (exp_value < 100000) {
+        exp_value = exp_value * 10 + (*p - '0');
+      }
+    }
+    exponent += negative_exp ? -exp_value : exp_value;
+  }
+
+  // trailing characters, including hex floats, are handled by the slow path
+  if (p != end) {
+    if (mantissa == 0 && digits == 0 && (*p == 'x' || *p == 'X')) {
+      return parse_float64_slow(text, size);
+    }
+    return nil_value<double>();
+  }
+
+  // zero doesn't need any rounding
+  if (mantissa == 0 && !truncated) {
+    return negative ? -0.0 : 0.0;
+  }
+
+  // exact mantissa and exact power of ten means only one rounding
+  if (!truncated && mantissa <= max_exact_mantissa) {
+    double value = double(mantissa);
+    if (exponent < 0 && exponent >= -22) {
+      value /= exact_powers[-exponent];
+      return negative ? -value : value;
+    }
+    if (exponent >= 0 && exponent <= 22) {
+      value *= exact_powers[exponent];
+      return negative ? -value : value;
+    }
+    // shift some of a large exponent into the mantissa if it stays exact
+    if (exponent > 22 && exponent <= 22 + 15) {
+      uint64_t shifted = mantissa;
+      for (int i = 22; i < exponent && shifted <= max_exact_mantissa; i++) {
+        shifted *= 10;
+      }
+      if (shifted <= max_exact_mantissa) {
+        value = double(shifted) * exact_powers[22];
+        return negative ? -value : value;
+      }
+    }
+  }
+
+  return parse_float64_slow(text, size);
+}
+
+// parse a boolean
+inline bool parse_bool(const char* text, size_t size) {
+  return size == 4 && memcmp(text, "true", 4) == 0;
+}
+}  // namespace VVM
+
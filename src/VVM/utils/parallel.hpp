@@ -0,0 +1,80 @@
+/*
+ * Parallel -- run independent tasks across hardware threads
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns the number of worker threads to use for parallel tasks, which can
+ * be overridden by the EMPIRICAL_THREADS environment variable
+ */
+inline size_t max_threads() {
+  char* env = getenv("EMPIRICAL_THREADS");
+  long n = (env != nullptr) ? atol(env) : 0;
+  if (n <= 0) {
+    n = std::thread::hardware_concurrency();
+  }
+  return (n <= 0) ? 1 : size_t(n);
+}
+
+/**
+ * Calls f(i) for every i in [0, n), with tasks spread across worker threads.
+ * The first exception thrown by any task is rethrown on the calling thread
+ * after all workers have finished.
+ */
+template<class F>
+void parallel_for(size_t n, F f) {
+  size_t nthreads = std::min(n, max_threads());
+
+  // nothing to gain from spawning threads
+  if (nthreads <= 1) {
+    for (size_t i = 0; i < n; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  // workers pull the next task index until none remain
+  std::atomic<size_t> next(0);
+  std::vector<std::exception_ptr> errors(nthreads);
+  auto worker = [&](size_t id) {
+    try {
+      for (size_t i = next++; i < n; i = next++) {
+        f(i);
+      }
+    }
+    catch (...) {
+      errors[id] = std::current_exception();
+      next = n;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t id = 1; id < nthreads; id++) {
+    threads.emplace_back(worker, id);
+  }
+  worker(0);
+  for (auto& t: threads) {
+    t.join();
+  }
+
+  for (auto& e: errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
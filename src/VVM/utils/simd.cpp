@@ -0,0 +1,1027 @@
+/*
+ * SIMD -- vectorized arithmetic on columns
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <algorithm>
+
+#include <VVM/utils/simd.hpp>
+#include <VVM/utils/nil.hpp>
+
+// each instruction set is enabled per function, so the rest of the program
+// still runs on any CPU
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VVM_SIMD_X86
+#include <immintrin.h>
+#define SIMD_SSE42 __attribute__((target("sse4.2")))
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#define SIMD_AVX512 __attribute__((target("avx512f,avx512dq")))
+#endif  // x86
+
+namespace VVM {
+/*** element-by-element results ***/
+
+// integers wrap on overflow, like the interpreter's loop does in practice
+template<SimdOp OP>
+inline int64_t unchecked_op(int64_t x, int64_t y) {
+  uint64_t a = uint64_t(x);
+  uint64_t b = uint64_t(y);
+  switch (OP) {
+    case SimdOp::kAdd:
+      return int64_t(a + b);
+    case SimdOp::kSub:
+      return int64_t(a - b);
+    case SimdOp::kMul:
+      return int64_t(a * b);
+    case SimdOp::kBitAnd:
+      return int64_t(a & b);
+    default:
+      return int64_t(a | b);
+  }
+}
+
+template<SimdOp OP>
+inline int64_t scalar_op(int64_t x, int64_t y) {
+  if (is_int_nil(x) || is_int_nil(y)) {
+    return nil_value<int64_t>();
+  }
+  return unchecked_op<OP>(x, y);
+}
+
+template<SimdOp OP>
+inline double unchecked_op(double x, double y) {
+  switch (OP) {
+    case SimdOp::kAdd:
+      return x + y;
+    case SimdOp::kSub:
+      return x - y;
+    case SimdOp::kMul:
+      return x * y;
+    default:
+      return x / y;
+  }
+}
+
+// floats need no nil check, so they are the same either way
+template<SimdOp OP>
+inline double scalar_op(double x, double y) {
+  return unchecked_op<OP>(x, y);
+}
+
+inline int64_t unchecked_neg(int64_t x) {
+  return int64_t(0 - uint64_t(x));
+}
+
+inline double unchecked_neg(double x) {
+  return -x;
+}
+
+inline int64_t scalar_neg(int64_t x) {
+  return is_int_nil(x) ? nil_value<int64_t>() : unchecked_neg(x);
+}
+
+inline double scalar_neg(double x) {
+  return -x;
+}
+
+// comparisons with an integer nil are false, as in the interpreter's loop
+template<SimdOp OP, class T>
+inline bool unchecked_cmp(T x, T y) {
+  switch (OP) {
+    case SimdOp::kLt:
+      return x < y;
+    case SimdOp::kGt:
+      return x > y;
+    case SimdOp::kEq:
+      return x == y;
+    case SimdOp::kNe:
+      return x != y;
+    case SimdOp::kLte:
+      return x <= y;
+    default:
+      return x >= y;
+  }
+}
+
+template<SimdOp OP>
+inline bool scalar_cmp(int64_t x, int64_t y) {
+  return !is_int_nil(x) && !is_int_nil(y) && unchecked_cmp<OP>(x, y);
+}
+
+template<SimdOp OP>
+inline bool scalar_cmp(double x, double y) {
+  return unchecked_cmp<OP>(x, y);
+}
+
+// up to 64 bytes of a mask as the bits of a word
+inline uint64_t scalar_pack(const uint8_t* mask, size_t n) {
+  uint64_t word = 0;
+  for (size_t j = 0; j < n; j++) {
+    word |= uint64_t(mask[j] != 0) << j;
+  }
+  return word;
+}
+
+// the fallback for any CPU; like every kernel, this skips the nil check if
+// NF (the operands are known to have no nil) and returns whether the result
+// has no integer nil
+struct Scalar {};
+
+template<SimdOp OP, bool XS, bool YS, bool NF, class T>
+bool binop_kernel(Scalar, const T* xs, const T* ys, T* zs, size_t n) {
+  bool has_nil = false;
+  for (size_t i = 0; i < n; i++) {
+    zs[i] = NF ? unchecked_op<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i])
+               : scalar_op<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);
+    has_nil |= is_int_nil(zs[i]);
+  }
+  return !has_nil;
+}
+
+template<bool NF, class T>
+bool unop_kernel(Scalar, const T* xs, T* ys, size_t n) {
+  bool has_nil = false;
+  for (size_t i = 0; i < n; i++) {
+    ys[i] = NF ? unchecked_neg(xs[i]) : scalar_neg(xs[i]);
+    has_nil |= is_int_nil(ys[i]);
+  }
+  return !has_nil;
+}
+
+template<SimdOp OP, bool XS, bool YS, bool NF, class T>
+void compare_kernel(Scalar, const T* xs, const T* ys, uint8_t* mask,
+                    size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    mask[i] = NF ? unchecked_cmp<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i])
+                 : scalar_cmp<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);
+  }
+}
+
+inline void pack_kernel(Scalar, const uint8_t* mask, size_t n,
+                        uint64_t* words) {
+  for (size_t i = 0; i < n; i += 64) {
+    words[i / 64] = scalar_pack(mask + i, std::min(n - i, size_t(64)));
+  }
+}
+
+#ifdef VVM_SIMD_X86
+/*** instruction sets ***/
+
+// every set has the same operations, so the kernels below are shared; there
+// is no vector multiply of 64-bit integers before AVX-512, so it is built
+// from 32-bit multiplies; comparisons give the lanes where they hold as bits,
+// and a mask is packed a pack_width of bytes at a time
+struct Sse42 {
+  typedef __m128i I;
+  typedef __m128d F;
+  typedef __m128i M;
+  static const size_t width = 2;
+
+  SIMD_SSE42 static inline I load(const int64_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const I*>(p));
+  }
+  SIMD_SSE42 static inline F load(const double* p) {
+    return _mm_loadu_pd(p);
+  }
+  SIMD_SSE42 static inline void store(int64_t* p, I x) {
+    _mm_storeu_si128(reinterpret_cast<I*>(p), x);
+  }
+  SIMD_SSE42 static inline void store(double* p, F x) {
+    _mm_storeu_pd(p, x);
+  }
+  SIMD_SSE42 static inline I set1(int64_t x) {
+    return _mm_set1_epi64x(x);
+  }
+  SIMD_SSE42 static inline F set1(double x) {
+    return _mm_set1_pd(x);
+  }
+
+  SIMD_SSE42 static inline I op(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm_add_epi64(x, y);
+      case SimdOp::kSub:
+        return _mm_sub_epi64(x, y);
+      case SimdOp::kMul: {
+        I cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), y),
+                                _mm_mul_epu32(x, _mm_srli_epi64(y, 32)));
+        return _mm_add_epi64(_mm_mul_epu32(x, y), _mm_slli_epi64(cross, 32));
+      }
+      case SimdOp::kBitAnd:
+        return _mm_and_si128(x, y);
+      default:
+        return _mm_or_si128(x, y);
+    }
+  }
+  SIMD_SSE42 static inline F op(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm_add_pd(x, y);
+      case SimdOp::kSub:
+        return _mm_sub_pd(x, y);
+      case SimdOp::kMul:
+        return _mm_mul_pd(x, y);
+      default:
+        return _mm_div_pd(x, y);
+    }
+  }
+  SIMD_SSE42 static inline I neg(I x) {
+    return _mm_sub_epi64(_mm_setzero_si128(), x);
+  }
+  SIMD_SSE42 static inline F neg(F x) {
+    return _mm_xor_pd(x, _mm_set1_pd(-0.0));
+  }
+
+  SIMD_SSE42 static inline M is_nil(I x, I nil) {
+    return _mm_cmpeq_epi64(x, nil);
+  }
+  SIMD_SSE42 static inline M either(M a, M b) {
+    return _mm_or_si128(a, b);
+  }
+  SIMD_SSE42 static inline M none() {
+    return _mm_setzero_si128();
+  }
+  SIMD_SSE42 static inline bool any(M m) {
+    return !_mm_testz_si128(m, m);
+  }
+  SIMD_SSE42 static inline I blend(I x, I nil, M m) {
+    return _mm_blendv_epi8(x, nil, m);
+  }
+
+  static const unsigned lanes = 0x3;
+  SIMD_SSE42 static inline unsigned bits(M m) {
+    return unsigned(_mm_movemask_pd(_mm_castsi128_pd(m)));
+  }
+  SIMD_SSE42 static inline unsigned cmp(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return bits(_mm_cmpgt_epi64(y, x));
+      case SimdOp::kGt:
+        return bits(_mm_cmpgt_epi64(x, y));
+      case SimdOp::kEq:
+        return bits(_mm_cmpeq_epi64(x, y));
+      case SimdOp::kNe:
+        return bits(_mm_cmpeq_epi64(x, y)) ^ lanes;
+      case SimdOp::kLte:
+        return bits(_mm_cmpgt_epi64(x, y)) ^ lanes;
+      default:
+        return bits(_mm_cmpgt_epi64(y, x)) ^ lanes;
+    }
+  }
+  SIMD_SSE42 static inline unsigned cmp(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return unsigned(_mm_movemask_pd(_mm_cmplt_pd(x, y)));
+      case SimdOp::kGt:
+        return unsigned(_mm_movemask_pd(_mm_cmpgt_pd(x, y)));
+      case SimdOp::kEq:
+        return unsigned(_mm_movemask_pd(_mm_cmpeq_pd(x, y)));
+      case SimdOp::kNe:
+        return unsigned(_mm_movemask_pd(_mm_cmpneq_pd(x, y)));
+      case SimdOp::kLte:
+        return unsigned(_mm_movemask_pd(_mm_cmple_pd(x, y)));
+      default:
+        return unsigned(_mm_movemask_pd(_mm_cmpge_pd(x, y)));
+    }
+  }
+
+  static const size_t pack_width = 16;
+  SIMD_SSE42 static inline uint64_t pack(const uint8_t* p) {
+    I bytes = _mm_loadu_si128(reinterpret_cast<const I*>(p));
+    return uint32_t(_mm_movemask_epi8(_mm_sub_epi8(_mm_setzero_si128(),
+                                                   bytes)));
+  }
+};
+
+struct Avx2 {
+  typedef __m256i I;
+  typedef __m256d F;
+  typedef __m256i M;
+  static const size_t width = 4;
+
+  SIMD_AVX2 static inline I load(const int64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const I*>(p));
+  }
+  SIMD_AVX2 static inline F load(const double* p) {
+    return _mm256_loadu_pd(p);
+  }
+  SIMD_AVX2 static inline void store(int64_t* p, I x) {
+    _mm256_storeu_si256(reinterpret_cast<I*>(p), x);
+  }
+  SIMD_AVX2 static inline void store(double* p, F x) {
+    _mm256_storeu_pd(p, x);
+  }
+  SIMD_AVX2 static inline I set1(int64_t x) {
+    return _mm256_set1_epi64x(x);
+  }
+  SIMD_AVX2 static inline F set1(double x) {
+    return _mm256_set1_pd(x);
+  }
+
+  SIMD_AVX2 static inline I op(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm256_add_epi64(x, y);
+      case SimdOp::kSub:
+        return _mm256_sub_epi64(x, y);
+      case SimdOp::kMul: {
+        I cross =
+          _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), y),
+                           _mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+        return _mm256_add_epi64(_mm256_mul_epu32(x, y),
+                                _mm256_slli_epi64(cross, 32));
+      }
+      case SimdOp::kBitAnd:
+        return _mm256_and_si256(x, y);
+      default:
+        return _mm256_or_si256(x, y);
+    }
+  }
+  SIMD_AVX2 static inline F op(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm256_add_pd(x, y);
+      case SimdOp::kSub:
+        return _mm256_sub_pd(x, y);
+      case SimdOp::kMul:
+        return _mm256_mul_pd(x, y);
+      default:
+        return _mm256_div_pd(x, y);
+    }
+  }
+  SIMD_AVX2 static inline I neg(I x) {
+    return _mm256_sub_epi64(_mm256_setzero_si256(), x);
+  }
+  SIMD_AVX2 static inline F neg(F x) {
+    return _mm256_xor_pd(x, _mm256_set1_pd(-0.0));
+  }
+
+  SIMD_AVX2 static inline M is_nil(I x, I nil) {
+    return _mm256_cmpeq_epi64(x, nil);
+  }
+  SIMD_AVX2 static inline M either(M a, M b) {
+    return _mm256_or_si256(a, b);
+  }
+  SIMD_AVX2 static inline M none() {
+    return _mm256_setzero_si256();
+  }
+  SIMD_AVX2 static inline bool any(M m) {
+    return !_mm256_testz_si256(m, m);
+  }
+  SIMD_AVX2 static inline I blend(I x, I nil, M m) {
+    return _mm256_blendv_epi8(x, nil, m);
+  }
+
+  static const unsigned lanes = 0xF;
+  SIMD_AVX2 static inline unsigned bits(M m) {
+    return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+  }
+  SIMD_AVX2 static inline unsigned cmp(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return bits(_mm256_cmpgt_epi64(y, x));
+      case SimdOp::kGt:
+        return bits(_mm256_cmpgt_epi64(x, y));
+      case SimdOp::kEq:
+        return bits(_mm256_cmpeq_epi64(x, y));
+      case SimdOp::kNe:
+        return bits(_mm256_cmpeq_epi64(x, y)) ^ lanes;
+      case SimdOp::kLte:
+        return bits(_mm256_cmpgt_epi64(x, y)) ^ lanes;
+      default:
+        return bits(_mm256_cmpgt_epi64(y, x)) ^ lanes;
+    }
+  }
+  SIMD_AVX2 static inline unsigned cmp(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_LT_OQ)));
+      case SimdOp::kGt:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_GT_OQ)));
+      case SimdOp::kEq:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_EQ_OQ)));
+      case SimdOp::kNe:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_NEQ_UQ)));
+      case SimdOp::kLte:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_LE_OQ)));
+      default:
+        return unsigned(_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_GE_OQ)));
+    }
+  }
+
+  static const size_t pack_width = 32;
+  SIMD_AVX2 static inline uint64_t pack(const uint8_t* p) {
+    I bytes = _mm256_loadu_si256(reinterpret_cast<const I*>(p));
+    return uint32_t(_mm256_movemask_epi8(_mm256_sub_epi8(
+      _mm256_setzero_si256(), bytes)));
+  }
+};
+
+struct Avx512 {
+  typedef __m512i I;
+  typedef __m512d F;
+  typedef __mmask8 M;
+  static const size_t width = 8;
+
+  SIMD_AVX512 static inline I load(const int64_t* p) {
+    return _mm512_loadu_si512(p);
+  }
+  SIMD_AVX512 static inline F load(const double* p) {
+    return _mm512_loadu_pd(p);
+  }
+  SIMD_AVX512 static inline void store(int64_t* p, I x) {
+    _mm512_storeu_si512(p, x);
+  }
+  SIMD_AVX512 static inline void store(double* p, F x) {
+    _mm512_storeu_pd(p, x);
+  }
+  SIMD_AVX512 static inline I set1(int64_t x) {
+    return _mm512_set1_epi64(x);
+  }
+  SIMD_AVX512 static inline F set1(double x) {
+    return _mm512_set1_pd(x);
+  }
+
+  SIMD_AVX512 static inline I op(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm512_add_epi64(x, y);
+      case SimdOp::kSub:
+        return _mm512_sub_epi64(x, y);
+      case SimdOp::kMul:
+        return _mm512_mullo_epi64(x, y);
+      case SimdOp::kBitAnd:
+        return _mm512_and_si512(x, y);
+      default:
+        return _mm512_or_si512(x, y);
+    }
+  }
+  SIMD_AVX512 static inline F op(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kAdd:
+        return _mm512_add_pd(x, y);
+      case SimdOp::kSub:
+        return _mm512_sub_pd(x, y);
+      case SimdOp::kMul:
+        return _mm512_mul_pd(x, y);
+      default:
+        return _mm512_div_pd(x, y);
+    }
+  }
+  SIMD_AVX512 static inline I neg(I x) {
+    return _mm512_sub_epi64(_mm512_setzero_si512(), x);
+  }
+  SIMD_AVX512 static inline F neg(F x) {
+    return _mm512_xor_pd(x, _mm512_set1_pd(-0.0));
+  }
+
+  SIMD_AVX512 static inline M is_nil(I x, I nil) {
+    return _mm512_cmpeq_epi64_mask(x, nil);
+  }
+  SIMD_AVX512 static inline M either(M a, M b) {
+    return M(a | b);
+  }
+  SIMD_AVX512 static inline M none() {
+    return M(0);
+  }
+  SIMD_AVX512 static inline bool any(M m) {
+    return m != 0;
+  }
+  SIMD_AVX512 static inline I blend(I x, I nil, M m) {
+    return _mm512_mask_mov_epi64(x, m, nil);
+  }
+
+  static const unsigned lanes = 0xFF;
+  SIMD_AVX512 static inline unsigned bits(M m) {
+    return m;
+  }
+  SIMD_AVX512 static inline unsigned cmp(SimdOp op, I x, I y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_LT);
+      case SimdOp::kGt:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_NLE);
+      case SimdOp::kEq:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_EQ);
+      case SimdOp::kNe:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_NE);
+      case SimdOp::kLte:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_LE);
+      default:
+        return _mm512_cmp_epi64_mask(x, y, _MM_CMPINT_NLT);
+    }
+  }
+  SIMD_AVX512 static inline unsigned cmp(SimdOp op, F x, F y) {
+    switch (op) {
+      case SimdOp::kLt:
+        return _mm512_cmp_pd_mask(x, y, _CMP_LT_OQ);
+      case SimdOp::kGt:
+        return _mm512_cmp_pd_mask(x, y, _CMP_GT_OQ);
+      case SimdOp::kEq:
+        return _mm512_cmp_pd_mask(x, y, _CMP_EQ_OQ);
+      case SimdOp::kNe:
+        return _mm512_cmp_pd_mask(x, y, _CMP_NEQ_UQ);
+      case SimdOp::kLte:
+        return _mm512_cmp_pd_mask(x, y, _CMP_LE_OQ);
+      default:
+        return _mm512_cmp_pd_mask(x, y, _CMP_GE_OQ);
+    }
+  }
+
+  // bytes need AVX-512BW, so they are packed with AVX2 (which every AVX-512
+  // CPU has)
+  static const size_t pack_width = 32;
+  SIMD_AVX512 static inline uint64_t pack(const uint8_t* p) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return uint32_t(_mm256_movemask_epi8(_mm256_sub_epi8(
+      _mm256_setzero_si256(), bytes)));
+  }
+};
+
+/*** kernels ***/
+
+// a kernel must be compiled for its instruction set as a whole, so the same
+// loops are stamped out for each set; a single value is broadcast, nil lanes
+// are blended in (unless the operands have none), and the last few elements
+// are done one at a time
+#define SIMD_KERNELS(S, TARGET)\
+template<SimdOp OP, bool XS, bool YS, bool NF> TARGET \
+bool binop_kernel(S, const int64_t* xs, const int64_t* ys, int64_t* zs,\
+                  size_t n) {\
+  const S::I nil = S::set1(nil_value<int64_t>());\
+  const S::I x0 = S::set1(xs[0]);\
+  const S::I y0 = S::set1(ys[0]);\
+  S::M found = S::none();\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::I x = XS ? x0 : S::load(xs + i);\
+    S::I y = YS ? y0 : S::load(ys + i);\
+    S::I z = S::op(OP, x, y);\
+    if (!NF) {\
+      S::M m = S::either(S::is_nil(x, nil), S::is_nil(y, nil));\
+      z = S::blend(z, nil, m);\
+    }\
+    found = S::either(found, S::is_nil(z, nil));\
+    S::store(zs + i, z);\
+  }\
+  bool has_nil = S::any(found);\
+  for (; i < n; i++) {\
+    zs[i] = NF ? unchecked_op<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i])\
+               : scalar_op<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);\
+    has_nil |= is_int_nil(zs[i]);\
+  }\
+  return !has_nil;\
+}\
+\
+template<SimdOp OP, bool XS, bool YS, bool NF> TARGET \
+bool binop_kernel(S, const double* xs, const double* ys, double* zs,\
+                  size_t n) {\
+  const S::F x0 = S::set1(xs[0]);\
+  const S::F y0 = S::set1(ys[0]);\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::F x = XS ? x0 : S::load(xs + i);\
+    S::F y = YS ? y0 : S::load(ys + i);\
+    S::store(zs + i, S::op(OP, x, y));\
+  }\
+  for (; i < n; i++) {\
+    zs[i] = scalar_op<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);\
+  }\
+  return true;\
+}\
+\
+template<bool NF> TARGET \
+bool unop_kernel(S, const int64_t* xs, int64_t* ys, size_t n) {\
+  const S::I nil = S::set1(nil_value<int64_t>());\
+  S::M found = S::none();\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::I x = S::load(xs + i);\
+    S::I y = NF ? S::neg(x) : S::blend(S::neg(x), nil, S::is_nil(x, nil));\
+    found = S::either(found, S::is_nil(y, nil));\
+    S::store(ys + i, y);\
+  }\
+  bool has_nil = S::any(found);\
+  for (; i < n; i++) {\
+    ys[i] = NF ? unchecked_neg(xs[i]) : scalar_neg(xs[i]);\
+    has_nil |= is_int_nil(ys[i]);\
+  }\
+  return !has_nil;\
+}\
+\
+template<bool NF> TARGET \
+bool unop_kernel(S, const double* xs, double* ys, size_t n) {\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::store(ys + i, S::neg(S::load(xs + i)));\
+  }\
+  for (; i < n; i++) {\
+    ys[i] = scalar_neg(xs[i]);\
+  }\
+  return true;\
+}\
+\
+template<SimdOp OP, bool XS, bool YS, bool NF> TARGET \
+void compare_kernel(S, const int64_t* xs, const int64_t* ys, uint8_t* mask,\
+                    size_t n) {\
+  const S::I nil = S::set1(nil_value<int64_t>());\
+  const S::I x0 = S::set1(xs[0]);\
+  const S::I y0 = S::set1(ys[0]);\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::I x = XS ? x0 : S::load(xs + i);\
+    S::I y = YS ? y0 : S::load(ys + i);\
+    unsigned bits = S::cmp(OP, x, y);\
+    if (!NF) {\
+      bits &= ~S::bits(S::either(S::is_nil(x, nil), S::is_nil(y, nil)));\
+    }\
+    for (size_t j = 0; j < S::width; j++) {\
+      mask[i + j] = uint8_t((bits >> j) & 1);\
+    }\
+  }\
+  for (; i < n; i++) {\
+    mask[i] = NF ? unchecked_cmp<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i])\
+                 : scalar_cmp<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);\
+  }\
+}\
+\
+template<SimdOp OP, bool XS, bool YS, bool NF> TARGET \
+void compare_kernel(S, const double* xs, const double* ys, uint8_t* mask,\
+                    size_t n) {\
+  const S::F x0 = S::set1(xs[0]);\
+  const S::F y0 = S::set1(ys[0]);\
+  size_t i = 0;\
+  for (; i + S::width <= n; i += S::width) {\
+    S::F x = XS ? x0 : S::load(xs + i);\
+    S::F y = YS ? y0 : S::load(ys + i);\
+    unsigned bits = S::cmp(OP, x, y);\
+    for (size_t j = 0; j < S::width; j++) {\
+      mask[i + j] = uint8_t((bits >> j) & 1);\
+    }\
+  }\
+  for (; i < n; i++) {\
+    mask[i] = scalar_cmp<OP>(xs[XS ? 0 : i], ys[YS ? 0 : i]);\
+  }\
+}\
+\
+TARGET inline void pack_kernel(S, const uint8_t* mask, size_t n,\
+                               uint64_t* words) {\
+  size_t i = 0;\
+  for (; i + 64 <= n; i += 64) {\
+    uint64_t word = 0;\
+    for (size_t j = 0; j < 64; j += S::pack_width) {\
+      word |= S::pack(mask + i + j) << j;\
+    }\
+    words[i / 64] = word;\
+  }\
+  if (i < n) {\
+    words[i / 64] = scalar_pack(mask + i, n - i);\
+  }\
+}
+
+SIMD_KERNELS(Sse42, SIMD_SSE42)
+SIMD_KERNELS(Avx2, SIMD_AVX2)
+SIMD_KERNELS(Avx512, SIMD_AVX512)
+
+#undef SIMD_KERNELS
+#endif  // VVM_SIMD_X86
+
+/*** dispatch ***/
+
+// the widest instruction set that this CPU has
+static SimdLevel detect_simd_level() {
+#ifdef VVM_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return SimdLevel::kSse42;
+  }
+#endif  // VVM_SIMD_X86
+  return SimdLevel::kScalar;
+}
+
+static SimdLevel& current_simd_level() {
+  static SimdLevel level = detect_simd_level();
+  return level;
+}
+
+// instruction set in use
+SimdLevel simd_level() {
+  return current_simd_level();
+}
+
+// use no wider than the given instruction set (so tests can compare them
+// all); returns the set actually used
+SimdLevel set_simd_level(SimdLevel level) {
+  current_simd_level() = std::min(level, detect_simd_level());
+  return current_simd_level();
+}
+
+// pick the kernel for the shape of the operands
+template<class S, SimdOp OP, bool NF, class T>
+bool run_binop(const T* xs, bool x_scalar, const T* ys, bool y_scalar, T* zs,
+               size_t n) {
+  if (x_scalar) {
+    return binop_kernel<OP, true, false, NF>(S(), xs, ys, zs, n);
+  }
+  else if (y_scalar) {
+    return binop_kernel<OP, false, true, NF>(S(), xs, ys, zs, n);
+  }
+  else {
+    return binop_kernel<OP, false, false, NF>(S(), xs, ys, zs, n);
+  }
+}
+
+template<class S, SimdOp OP, class T>
+bool run_binop(const T* xs, bool x_scalar, const T* ys, bool y_scalar, T* zs,
+               size_t n, bool nil_free) {
+  if (nil_free) {
+    return run_binop<S, OP, true>(xs, x_scalar, ys, y_scalar, zs, n);
+  }
+  return run_binop<S, OP, false>(xs, x_scalar, ys, y_scalar, zs, n);
+}
+
+template<class S, class T>
+bool run_binop(SimdOp op, const T* xs, bool x_scalar, const T* ys,
+               bool y_scalar, T* zs, size_t n, bool nil_free) {
+  switch (op) {
+    case SimdOp::kAdd:
+      return run_binop<S, SimdOp::kAdd>(xs, x_scalar, ys, y_scalar, zs, n,
+                                        nil_free);
+    case SimdOp::kSub:
+      return run_binop<S, SimdOp::kSub>(xs, x_scalar, ys, y_scalar, zs, n,
+                                        nil_free);
+    case SimdOp::kMul:
+      return run_binop<S, SimdOp::kMul>(xs, x_scalar, ys, y_scalar, zs, n,
+                                        nil_free);
+    case SimdOp::kDiv:
+      return run_binop<S, SimdOp::kDiv>(xs, x_scalar, ys, y_scalar, zs, n,
+                                        nil_free);
+    case SimdOp::kBitAnd:
+      return run_binop<S, SimdOp::kBitAnd>(xs, x_scalar, ys, y_scalar, zs, n,
+                                           nil_free);
+    default:
+      return run_binop<S, SimdOp::kBitOr>(xs, x_scalar, ys, y_scalar, zs, n,
+                                          nil_free);
+  }
+}
+
+template<class T>
+bool dispatch_binop(SimdOp op, const T* xs, bool x_scalar, const T* ys,
+                    bool y_scalar, T* zs, size_t n, bool nil_free) {
+  // two single values only need one result
+  if (x_scalar && y_scalar) {
+    bool result = run_binop<Scalar>(op, xs, true, ys, true, zs, 1, nil_free);
+    std::fill(zs + 1, zs + n, zs[0]);
+    return result;
+  }
+  switch (simd_level()) {
+#ifdef VVM_SIMD_X86
+    case SimdLevel::kAvx512:
+      return run_binop<Avx512>(op, xs, x_scalar, ys, y_scalar, zs, n,
+                               nil_free);
+    case SimdLevel::kAvx2:
+      return run_binop<Avx2>(op, xs, x_scalar, ys, y_scalar, zs, n, nil_free);
+    case SimdLevel::kSse42:
+      return run_binop<Sse42>(op, xs, x_scalar, ys, y_scalar, zs, n,
+                              nil_free);
+#endif  // VVM_SIMD_X86
+    default:
+      return run_binop<Scalar>(op, xs, x_scalar, ys, y_scalar, zs, n,
+                               nil_free);
+  }
+}
+
+template<bool NF, class T>
+bool dispatch_unop(const T* xs, T* ys, size_t n) {
+  switch (simd_level()) {
+#ifdef VVM_SIMD_X86
+    case SimdLevel::kAvx512:
+      return unop_kernel<NF>(Avx512(), xs, ys, n);
+    case SimdLevel::kAvx2:
+      return unop_kernel<NF>(Avx2(), xs, ys, n);
+    case SimdLevel::kSse42:
+      return unop_kernel<NF>(Sse42(), xs, ys, n);
+#endif  // VVM_SIMD_X86
+    default:
+      return unop_kernel<NF>(Scalar(), xs, ys, n);
+  }
+}
+
+template<class S, SimdOp OP, bool NF, class T>
+void run_compare(const T* xs, bool x_scalar, const T* ys, bool y_scalar,
+                 uint8_t* mask, size_t n) {
+  if (x_scalar) {
+    compare_kernel<OP, true, false, NF>(S(), xs, ys, mask, n);
+  }
+  else if (y_scalar) {
+    compare_kernel<OP, false, true, NF>(S(), xs, ys, mask, n);
+  }
+  else {
+    compare_kernel<OP, false, false, NF>(S(), xs, ys, mask, n);
+  }
+}
+
+template<class S, SimdOp OP, class T>
+void run_compare(const T* xs, bool x_scalar, const T* ys, bool y_scalar,
+                 uint8_t* mask, size_t n, bool nil_free) {
+  if (nil_free) {
+    run_compare<S, OP, true>(xs, x_scalar, ys, y_scalar, mask, n);
+  }
+  else {
+    run_compare<S, OP, false>(xs, x_scalar, ys, y_scalar, mask, n);
+  }
+}
+
+template<class S, class T>
+void run_compare(SimdOp op, const T* xs, bool x_scalar, const T* ys,
+                 bool y_scalar, uint8_t* mask, size_t n, bool nil_free) {
+  switch (op) {
+    case SimdOp::kLt:
+      run_compare<S, SimdOp::kLt>(xs, x_scalar, ys, y_scalar, mask, n,
+                                  nil_free);
+      break;
+    case SimdOp::kGt:
+      run_compare<S, SimdOp::kGt>(xs, x_scalar, ys, y_scalar, mask, n,
+                                  nil_free);
+      break;
+    case SimdOp::kEq:
+      run_compare<S, SimdOp::kEq>(xs, x_scalar, ys, y_scalar, mask, n,
+                                  nil_free);
+      break;
+    case SimdOp::kNe:
+      run_compare<S, SimdOp::kNe>(xs, x_scalar, ys, y_scalar, mask, n,
+                                  nil_free);
+      break;
+    case SimdOp::kLte:
+      run_compare<S, SimdOp::kLte>(xs, x_scalar, ys, y_scalar, mask, n,
+                                   nil_free);
+      break;
+    default:
+      run_compare<S, SimdOp::kGte>(xs, x_scalar, ys, y_scalar, mask, n,
+                                   nil_free);
+      break;
+  }
+}
+
+template<class T>
+bool dispatch_compare(SimdOp op, const T* xs, bool x_scalar, const T* ys,
+                      bool y_scalar, uint8_t* mask, size_t n,
+                      bool nil_free) {
+  switch (op) {
+    case SimdOp::kLt:
+    case SimdOp::kGt:
+    case SimdOp::kEq:
+    case SimdOp::kNe:
+    case SimdOp::kLte:
+    case SimdOp::kGte:
+      break;
+    default:
+      return false;
+  }
+  if (n == 0) {
+    return true;
+  }
+  // two single values only need one result
+  if (x_scalar && y_scalar) {
+    run_compare<Scalar>(op, xs, true, ys, true, mask, 1, nil_free);
+    std::fill(mask + 1, mask + n, mask[0]);
+    return true;
+  }
+  switch (simd_level()) {
+#ifdef VVM_SIMD_X86
+    case SimdLevel::kAvx512:
+      run_compare<Avx512>(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+      break;
+    case SimdLevel::kAvx2:
+      run_compare<Avx2>(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+      break;
+    case SimdLevel::kSse42:
+      run_compare<Sse42>(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+      break;
+#endif  // VVM_SIMD_X86
+    default:
+      run_compare<Scalar>(op, xs, x_scalar, ys, y_scalar, mask, n,
+                          nil_free);
+      break;
+  }
+  return true;
+}
+
+// zs[i] = xs[i] op ys[i], where a single value stands for every element
+bool simd_binop(SimdOp op, const int64_t* xs, bool x_scalar,
+                const int64_t* ys, bool y_scalar, int64_t* zs, size_t n) {
+  bool nil_free = false;
+  return simd_binop(op, xs, x_scalar, ys, y_scalar, zs, n, nil_free);
+}
+
+bool simd_binop(SimdOp op, const int64_t* xs, bool x_scalar,
+                const int64_t* ys, bool y_scalar, int64_t* zs, size_t n,
+                bool& nil_free) {
+  switch (op) {
+    case SimdOp::kAdd:
+    case SimdOp::kSub:
+    case SimdOp::kMul:
+    case SimdOp::kBitAnd:
+    case SimdOp::kBitOr:
+      nil_free = (n == 0) ||
+                 dispatch_binop(op, xs, x_scalar, ys, y_scalar, zs, n,
+                                nil_free);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool simd_binop(SimdOp op, const double* xs, bool x_scalar,
+                const double* ys, bool y_scalar, double* zs, size_t n) {
+  switch (op) {
+    case SimdOp::kAdd:
+    case SimdOp::kSub:
+    case SimdOp::kMul:
+    case SimdOp::kDiv:
+      if (n != 0) {
+        dispatch_binop(op, xs, x_scalar, ys, y_scalar, zs, n, false);
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool simd_binop(SimdOp op, const double* xs, bool x_scalar,
+                const double* ys, bool y_scalar, double* zs, size_t n,
+                bool&) {
+  return simd_binop(op, xs, x_scalar, ys, y_scalar, zs, n);
+}
+
+// ys[i] = op xs[i]
+bool simd_unop(SimdOp op, const int64_t* xs, int64_t* ys, size_t n) {
+  bool nil_free = false;
+  return simd_unop(op, xs, ys, n, nil_free);
+}
+
+bool simd_unop(SimdOp op, const int64_t* xs, int64_t* ys, size_t n,
+               bool& nil_free) {
+  if (op != SimdOp::kNeg) {
+    return false;
+  }
+  nil_free = nil_free ? dispatch_unop<true>(xs, ys, n)
+                      : dispatch_unop<false>(xs, ys, n);
+  return true;
+}
+
+bool simd_unop(SimdOp op, const double* xs, double* ys, size_t n) {
+  if (op != SimdOp::kNeg) {
+    return false;
+  }
+  dispatch_unop<false>(xs, ys, n);
+  return true;
+}
+
+bool simd_unop(SimdOp op, const double* xs, double* ys, size_t n, bool&) {
+  return simd_unop(op, xs, ys, n);
+}
+
+// mask[i] = xs[i] op ys[i]
+bool simd_compare(SimdOp op, const int64_t* xs, bool x_scalar,
+                  const int64_t* ys, bool y_scalar, uint8_t* mask, size_t n,
+                  bool nil_free) {
+  return dispatch_compare(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+}
+
+bool simd_compare(SimdOp op, const double* xs, bool x_scalar,
+                  const double* ys, bool y_scalar, uint8_t* mask, size_t n) {
+  return dispatch_compare(op, xs, x_scalar, ys, y_scalar, mask, n, false);
+}
+
+// words[i / 64] bit i % 64 = mask[i]
+void simd_pack(const uint8_t* mask, size_t n, uint64_t* words) {
+  switch (simd_level()) {
+#ifdef VVM_SIMD_X86
+    case SimdLevel::kAvx512:
+      pack_kernel(Avx512(), mask, n, words);
+      break;
+    case SimdLevel::kAvx2:
+      pack_kernel(Avx2(), mask, n, words);
+      break;
+    case SimdLevel::kSse42:
+      pack_kernel(Sse42(), mask, n, words);
+      break;
+#endif  // VVM_SIMD_X86
+    default:
+      pack_kernel(Scalar(), mask, n, words);
+      break;
+  }
+}
+}  // namespace VVM
@@ -0,0 +1,92 @@
+/*
+ * SIMD header -- declares vectorized arithmetic on columns
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Arithmetic on whole columns of 64-bit values uses the widest vector
+ * instructions that the CPU has (AVX-512, AVX2, or SSE4.2), which are found
+ * when first needed; other CPUs and compilers just use a loop. Either operand
+ * may be a single value instead of a column.
+ *
+ * Integers keep the interpreter's nil rule (if either operand is nil, so is
+ * the result) by comparing against nil and blending rather than branching.
+ * Floats need no check since NaN propagates in hardware. Every result is
+ * identical to the one the interpreter's element-by-element loop gives.
+ *
+ * Comparisons write a byte per element (1 for true), which is false wherever
+ * an integer operand is nil; the bytes can then be packed into words of bits
+ * for a Bool column. Words of bits are combined with the integer bitwise
+ * operations, which is how Bool columns get "and" and "or".
+ */
+namespace VVM {
+
+// operations with a vectorized form
+enum class SimdOp {
+  kNone,    // no vectorized form
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,     // floats only
+  kBitAnd,  // integers only
+  kBitOr,   // integers only
+  kNeg,     // unary
+  kLt,      // comparisons
+  kGt,
+  kEq,
+  kNe,
+  kLte,
+  kGte
+};
+
+// instruction sets, from narrowest to widest
+enum class SimdLevel { kScalar, kSse42, kAvx2, kAvx512 };
+
+SimdLevel simd_level();
+SimdLevel set_simd_level(SimdLevel level);
+
+// these return false if the operation has no vectorized form for the type
+bool simd_binop(SimdOp op, const int64_t* xs, bool x_scalar,
+                const int64_t* ys, bool y_scalar, int64_t* zs, size_t n);
+bool simd_binop(SimdOp op, const double* xs, bool x_scalar,
+                const double* ys, bool y_scalar, double* zs, size_t n);
+bool simd_unop(SimdOp op, const int64_t* xs, int64_t* ys, size_t n);
+bool simd_unop(SimdOp op, const double* xs, double* ys, size_t n);
+
+// integer operands that are known to have no nil skip the nil check; given
+// whether they are, nil_free is then set to whether the result has none
+// (floats have no check, so they leave it as-is)
+bool simd_binop(SimdOp op, const int64_t* xs, bool x_scalar,
+                const int64_t* ys, bool y_scalar, int64_t* zs, size_t n,
+                bool& nil_free);
+bool simd_binop(SimdOp op, const double* xs, bool x_scalar,
+                const double* ys, bool y_scalar, double* zs, size_t n,
+                bool& nil_free);
+bool simd_unop(SimdOp op, const int64_t* xs, int64_t* ys, size_t n,
+               bool& nil_free);
+bool simd_unop(SimdOp op, const double* xs, double* ys, size_t n,
+               bool& nil_free);
+
+// mask[i] = xs[i] op ys[i]; integer operands that are known to have no nil
+// skip the nil check
+bool simd_compare(SimdOp op, const int64_t* xs, bool x_scalar,
+                  const int64_t* ys, bool y_scalar, uint8_t* mask, size_t n,
+                  bool nil_free = false);
+bool simd_compare(SimdOp op, const double* xs, bool x_scalar,
+                  const double* ys, bool y_scalar, uint8_t* mask, size_t n);
+
+// pack a byte mask into words, element i going to bit i % 64 of word i / 64;
+// bits past the end of the last word are cleared
+void simd_pack(const uint8_t* mask, size_t n, uint64_t* words);
+
+}  // namespace VVM
@@ -16,10 +16,13 @@
 #include <sys/time.h>
 #endif  // WIN32
 
+#include <algorithm>
 #include <ctime>
+#include <cstdlib>
 #include <cstring>
 
 #include <VVM/utils/timestamp.hpp>
+#include <VVM/utils/format.hpp>
 
 #include <strtime/strtime.h>
 
@@ -46,30 +49,55 @@ int64_t now_nanos() {
 
 /*** formatted string conversion ***/
 
+// returns whether format is one of the given (null-terminated) formats
+static bool is_format_in(const char* format, const char* const* formats) {
+  for (; *formats != nullptr; formats++) {
+    if (strcmp(format, *formats) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char* const timestamp_formats[] = {
+  "%Y-%m-%d",
+  "%Y/%m/%d",
+  "%H:%M",
+  "%H:%M:%S",
+  "%H:%M:%S.%f",
+  "%Y-%m-%d %H:%M:%S",
+  "%Y-%m-%d %H:%M:%S.%f",
+  "%Y/%m/%d %H:%M:%S",
+  "%Y/%m/%d %H:%M:%S.%f",
+  nullptr
+};
+
+static const char* const date_formats[] = {
+  "%Y-%m-%d",
+  "%Y/%m/%d",
+  nullptr
+};
+
+static const char* const time_formats[] = {
+  "%H:%M",
+  "%H:%M:%S",
+  "%H:%M:%S.%f",
+  nullptr
+};
+
 // returns whether format string represents a valid timestamp
 bool is_inferred_timestamp(const std::string& format) {
-  return (format == "%Y-%m-%d" ||
-          format == "%Y/%m/%d" ||
-          format == "%H:%M" ||
-          format == "%H:%M:%S" ||
-          format == "%H:%M:%S.%f" ||
-          format == "%Y-%m-%d %H:%M:%S" ||
-          format == "%Y-%m-%d %H:%M:%S.%f" ||
-          format == "%Y/%m/%d %H:%M:%S" ||
-          format == "%Y/%m/%d %H:%M:%S.%f");
+  return is_format_in(format.c_str(), timestamp_formats);
 }
 
 // returns whether format string represents a valid date
 bool is_inferred_date(const std::string& format) {
-  return (format == "%Y-%m-%d" ||
-          format == "%Y/%m/%d");
+  return is_format_in(format.c_str(), date_formats);
 }
 
 // returns whether format string represents a valid time
 bool is_inferred_time(const std::string& format) {
-  return (format == "%H:%M" ||
-          format == "%H:%M:%S" ||
-          format == "%H:%M:%S.%f");
+  return is_format_in(format.c_str(), time_formats);
 }
 
 // returns the inferred format string
@@ -98,16 +126,23 @@ std::string nanos_to_string(int64_t value, const std::string& format) {
 
 // returns string formatted to nanoseconds
 std::string nanos_to_string(int64_t nanos) {
-  return nanos_to_string(nanos, "%Y-%m-%d %H:%M:%S.%f");
+  char buffer[NanosFormatter::max_size];
+  NanosFormatter formatter;
+  return std::string(buffer, formatter.timestamp(nanos, buffer));
 }
 
-// returns integer according to format
-int64_t nanos_from_string(const std::string& str, std::string format) {
+// parse NUL-terminated text according to format; optionally reports whether
+// the format consumed all of the text
+static int64_t parse_nanos(const char* str, const char* format,
+                           bool* complete = nullptr) {
   static const int64_t ns_per_sec = 1000000000;
   tm time;
   memset(&time, 0, sizeof(tm));
   int nanos = 0;
-  char* ret = ::strptime_ns(str.c_str(), format.c_str(), &time, &nanos);
+  char* ret = ::strptime_ns(str, format, &time, &nanos);
+  if (complete != nullptr) {
+    *complete = (ret != nullptr && *ret == '\0');
+  }
   if (ret == nullptr) {
     return std::numeric_limits<int64_t>::max();
   }
@@ -122,67 +157,360 @@ int64_t nanos_from_string(const std::string& str, std::string format) {
   return unix_time;
 }
 
+// read exactly n digits, returning false if any are missing
+static inline bool read_digits(const char* str, size_t n, int& result) {
+  result = 0;
+  for (size_t i = 0; i < n; i++) {
+    unsigned digit = unsigned(str[i] - '0');
+    if (digit > 9) {
+      return false;
+    }
+    result = result * 10 + int(digit);
+  }
+  return true;
+}
+
+// days since the epoch for a civil (proleptic Gregorian) date
+static inline int64_t days_from_civil(int year, int month, int day) {
+  year -= (month <= 2);
+  const int era = (year >= 0 ? year : year - 399) / 400;
+  const int yoe = year - era * 400;
+  const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return int64_t(era) * 146097 + doe - 719468;
+}
+
+// parse "%Y-%m-%d" into nanoseconds; the year is limited to where
+// fast_timegm() agrees with the civil calendar
+static bool parse_iso_date(const char* str, size_t size, int64_t& result) {
+  static const int64_t ns_per_day = 86400000000000;
+  int year, month, day;
+  if (size != 10 || str[4] != '-' || str[7] != '-' ||
+      !read_digits(str, 4, year) || !read_digits(str + 5, 2, month) ||
+      !read_digits(str + 8, 2, day)) {
+    return false;
+  }
+  if (year < 1970 || year > 2099 || month < 1 || month > 12 || day < 1 ||
+      day > 31) {
+    return false;
+  }
+  result = days_from_civil(year, month, day) * ns_per_day;
+  return true;
+}
+
+// parse "%H:%M:%S" with an optional ".%f" into nanoseconds
+static bool parse_iso_time(const char* str, size_t size, int64_t& result) {
+  static const int64_t ns_per_sec = 1000000000;
+  int hour, minute, second;
+  if (size < 8 || str[2] != ':' || str[5] != ':' ||
+      !read_digits(str, 2, hour) || !read_digits(str + 3, 2, minute) ||
+      !read_digits(str + 6, 2, second)) {
+    return false;
+  }
+  if (hour > 23 || minute > 59 || second > 59) {
+    return false;
+  }
+
+  // fractional seconds have up to nine digits
+  int nanos = 0;
+  if (size > 8) {
+    size_t digits = size - 9;
+    if (str[8] != '.' || digits == 0 || digits > 9 ||
+        !read_digits(str + 9, digits, nanos)) {
+      return false;
+    }
+    for (; digits < 9; digits++) {
+      nanos *= 10;
+    }
+  }
+
+  result = (int64_t(hour) * 3600 + minute * 60 + second) * ns_per_sec + nanos;
+  return true;
+}
+
+// parse "%Y-%m-%d %H:%M:%S" with an optional ".%f" into nanoseconds
+static bool parse_iso_timestamp(const char* str, size_t size,
+                                int64_t& result) {
+  int64_t date, time;
+  if (size < 19 || str[10] != ' ' || !parse_iso_date(str, 10, date) ||
+      !parse_iso_time(str + 11, size - 11, time)) {
+    return false;
+  }
+  result = date + time;
+  return true;
+}
+
+// parse the common shapes directly; a value that fits one of these shapes
+// would have had that exact format inferred for it anyway
+static bool parse_iso(const char* str, size_t size, int64_t& result) {
+  if (size >= 10 && str[4] == '-') {
+    return (size == 10) ? parse_iso_date(str, size, result)
+                        : parse_iso_timestamp(str, size, result);
+  }
+  return size >= 8 && str[2] == ':' && parse_iso_time(str, size, result);
+}
+
+// parse NUL-terminated text by inferring its format
+static int64_t parse_nanos(const char* str) {
+  int64_t result;
+  if (parse_iso(str, strlen(str), result)) {
+    return result;
+  }
+  char format[80];
+  ::istrtime(str, format, sizeof(format));
+  if (!is_format_in(format, timestamp_formats)) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return parse_nanos(str, format);
+}
+
+// returns integer according to format
+int64_t nanos_from_string(const std::string& str, std::string format) {
+  return parse_nanos(str.c_str(), format.c_str());
+}
+
 // returns integer given a string to nanoseconds
 int64_t nanos_from_string(const std::string& str) {
-  std::string format = infer_strtime_format(str);
-  if (!is_inferred_timestamp(format)) {
+  return parse_nanos(str.c_str());
+}
+
+// returns integer given text that isn't NUL-terminated
+int64_t nanos_from_string(const char* str, size_t size) {
+  char buffer[80];
+  if (size >= sizeof(buffer)) {
     return std::numeric_limits<int64_t>::max();
   }
-  return nanos_from_string(str, format);
+  memcpy(buffer, str, size);
+  buffer[size] = '\0';
+  return parse_nanos(buffer);
 }
 
-// returns delta string formatted to nanoseconds
-std::string delta_to_string(int64_t delta) {
-  static const int64_t ns_per_day = 86400000000000;
-  int64_t sign = delta < 0 ? -1 : 1;
-  std::string str = sign == -1 ? "-" : "";
-  int64_t full_days = (sign * delta) / ns_per_day;
-  if (full_days != 0) {
-    str += std::to_string(full_days) + " days";
+/*** strtime format shared by a column ***/
+
+StrtimeFormat::StrtimeFormat(const std::string& format): format_(format) {
+  if (format == "%Y-%m-%d") {
+    shape_ = Shape::kDate;
   }
-  int64_t sub_days = (sign * delta) % ns_per_day;
-  if (sub_days != 0) {
-    if (full_days != 0) {
-      str += ' ';
+  else if (format == "%Y-%m-%d %H:%M:%S" ||
+           format == "%Y-%m-%d %H:%M:%S.%f") {
+    shape_ = Shape::kTimestamp;
+  }
+  else if (format == "%H:%M:%S" || format == "%H:%M:%S.%f") {
+    shape_ = Shape::kTime;
+  }
+  else if (is_inferred_timestamp(format)) {
+    shape_ = Shape::kOther;
+  }
+  else {
+    shape_ = Shape::kInfer;
+  }
+}
+
+// parse text that isn't NUL-terminated
+int64_t StrtimeFormat::parse(const char* str, size_t size) const {
+  int64_t result;
+  switch (shape_) {
+    case Shape::kDate:
+      if (parse_iso_date(str, size, result)) {
+        return result;
+      }
+      break;
+    case Shape::kTimestamp:
+      if (parse_iso_timestamp(str, size, result)) {
+        return result;
+      }
+      break;
+    case Shape::kTime:
+      if (parse_iso_time(str, size, result)) {
+        return result;
+      }
+      break;
+    case Shape::kOther: {
+      // the whole value must match the format
+      char buffer[80];
+      if (size < sizeof(buffer)) {
+        memcpy(buffer, str, size);
+        buffer[size] = '\0';
+        bool complete;
+        result = parse_nanos(buffer, format_.c_str(), &complete);
+        if (complete) {
+          return result;
+        }
+      }
+      break;
     }
-    str += nanos_to_string(sub_days, "%H:%M:%S.%f");
+    case Shape::kInfer:
+      break;
   }
-  return str;
+  return nanos_from_string(str, size);
+}
+
+// returns delta string formatted to nanoseconds
+std::string delta_to_string(int64_t delta) {
+  char buffer[NanosFormatter::max_size];
+  NanosFormatter formatter;
+  return std::string(buffer, formatter.delta(delta, buffer));
 }
 
 // returns delta integer given a string to nanoseconds
 int64_t delta_from_string(const std::string& str) {
+  return delta_from_string(str.c_str(), str.size());
+}
+
+// returns delta integer given text that isn't NUL-terminated
+int64_t delta_from_string(const char* str, size_t size) {
   static const int64_t ns_per_day = 86400000000000;
+  char buffer[80];
+  if (size >= sizeof(buffer)) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  memcpy(buffer, str, size);
+  buffer[size] = '\0';
+
   int64_t num = 0;
   int64_t sign = 1;
   size_t start = 0;
-  if (str[0] == '-') {
+  if (buffer[0] == '-') {
     sign = -1;
     start = 1;
   }
-  std::string day_str = " day";
-  size_t day_start = str.find(day_str, start);
-  if (day_start != std::string::npos) {
-    num = std::stol(str.substr(start, day_start)) * ns_per_day;
-    start = day_start + day_str.size();
-    if (start < str.size() && str[start] == 's') {
+  const char* day_str = " day";
+  const char* day_start = strstr(buffer + start, day_str);
+  if (day_start != nullptr) {
+    char* end;
+    num = strtoll(buffer + start, &end, 10) * ns_per_day;
+    if (end == buffer + start) {
+      return std::numeric_limits<int64_t>::max();
+    }
+    start = (day_start - buffer) + strlen(day_str);
+    if (start < size && buffer[start] == 's') {
       start++;
     }
   }
-  while (start < str.size() && str[start] == ' ') {
+  while (start < size && buffer[start] == ' ') {
     start++;
   }
-  if (start < str.size()) {
-    std::string sub_day = str.substr(start);
-    std::string format = infer_strtime_format(sub_day);
-    if (!is_inferred_time(format)) {
+  if (start < size) {
+    const char* sub_day = buffer + start;
+    char format[80];
+    ::istrtime(sub_day, format, sizeof(format));
+    if (!is_format_in(format, time_formats)) {
       return std::numeric_limits<int64_t>::max();
     }
-    int64_t sub_day_value = nanos_from_string(sub_day, format);
+    int64_t sub_day_value = parse_nanos(sub_day, format);
     num += sub_day_value;
   }
   return sign * num;
 }
 
+/*** fixed formats written straight into a buffer ***/
+
+// civil (proleptic Gregorian) date for days since the epoch
+static inline void civil_from_days(int64_t days, int& year, int& month,
+                                   int& day) {
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int doe = int(days - era * 146097);
+  const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = int(yoe + era * 400) + (month <= 2);
+}
+
+// write exactly n digits, padding with zeros
+static inline void write_digits(char* str, size_t n, int64_t value) {
+  for (size_t i = n; i > 0; i--) {
+    str[i - 1] = char('0' + value % 10);
+    value /= 10;
+  }
+}
+
+// the text from strftime_ns(), for values the fast paths don't cover
+static size_t generic_nanos(int64_t value, const char* format,
+                            char* buffer) {
+  std::string str = nanos_to_string(value, format);
+  size_t size = std::min(str.size(), size_t(NanosFormatter::max_size));
+  memcpy(buffer, str.data(), size);
+  return size;
+}
+
+NanosFormatter::NanosFormatter(): day_(-1) {
+}
+
+// "%Y-%m-%d %H:%M:%S.%f"
+size_t NanosFormatter::timestamp(int64_t nanos, char* buffer) {
+  if (nanos < 0) {
+    return generic_nanos(nanos, "%Y-%m-%d %H:%M:%S.%f", buffer);
+  }
+  date(nanos, buffer);
+  buffer[10] = ' ';
+  return 11 + time(nanos, buffer + 11);
+}
+
+// "%Y-%m-%d"
+size_t NanosFormatter::date(int64_t nanos, char* buffer) {
+  static const int64_t ns_per_day = 86400000000000;
+  if (nanos < 0) {
+    return generic_nanos(nanos, "%Y-%m-%d", buffer);
+  }
+  int64_t day = nanos / ns_per_day;
+  if (day != day_) {
+    int y, m, d;
+    civil_from_days(day, y, m, d);
+    write_digits(date_, 4, y);
+    date_[4] = '-';
+    write_digits(date_ + 5, 2, m);
+    date_[7] = '-';
+    write_digits(date_ + 8, 2, d);
+    day_ = day;
+  }
+  memcpy(buffer, date_, sizeof(date_));
+  return sizeof(date_);
+}
+
+// "%H:%M:%S.%f"
+size_t NanosFormatter::time(int64_t nanos, char* buffer) {
+  static const int64_t ns_per_sec = 1000000000;
+  static const int64_t sec_per_day = 86400;
+  if (nanos < 0) {
+    return generic_nanos(nanos, "%H:%M:%S.%f", buffer);
+  }
+  int64_t secs = (nanos / ns_per_sec) % sec_per_day;
+  write_digits(buffer, 2, secs / 3600);
+  buffer[2] = ':';
+  write_digits(buffer + 3, 2, (secs / 60) % 60);
+  buffer[5] = ':';
+  write_digits(buffer + 6, 2, secs % 60);
+  buffer[8] = '.';
+  write_digits(buffer + 9, 9, nanos % ns_per_sec);
+  return 18;
+}
+
+// like delta_to_string()
+size_t NanosFormatter::delta(int64_t delta, char* buffer) {
+  static const int64_t ns_per_day = 86400000000000;
+  int64_t sign = delta < 0 ? -1 : 1;
+  char* p = buffer;
+  if (sign == -1) {
+    *p++ = '-';
+  }
+  int64_t full_days = (sign * delta) / ns_per_day;
+  if (full_days != 0) {
+    p += format_int64(full_days, p);
+    memcpy(p, " days", 5);
+    p += 5;
+  }
+  int64_t sub_days = (sign * delta) % ns_per_day;
+  if (sub_days != 0) {
+    if (full_days != 0) {
+      *p++ = ' ';
+    }
+    p += time(sub_days, p);
+  }
+  return p - buffer;
+}
+
 }  // namespace VVM
 
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <limits>
@@ -35,8 +36,45 @@ std::string nanos_to_string(int64_t value, const std::string& format);
 std::string nanos_to_string(int64_t nanos);
 int64_t nanos_from_string(const std::string& str, std::string format);
 int64_t nanos_from_string(const std::string& str);
+int64_t nanos_from_string(const char* str, size_t size);
 std::string delta_to_string(int64_t delta);
 int64_t delta_from_string(const std::string& str);
+int64_t delta_from_string(const char* str, size_t size);
+
+/*** strtime format shared by a column ***/
+
+// a format inferred once (eg. from a sample) and reused for every value; any
+// value that doesn't fit the format is parsed by inferring its own
+class StrtimeFormat {
+ public:
+  explicit StrtimeFormat(const std::string& format = std::string());
+  int64_t parse(const char* str, size_t size) const;
+
+ private:
+  enum class Shape { kInfer, kDate, kTimestamp, kTime, kOther };
+  Shape shape_;
+  std::string format_;
+};
+
+/*** fixed formats written straight into a buffer ***/
+
+// writes the fixed formats of a column's values without strftime(); values
+// on the same day as the previous one reuse its date text
+class NanosFormatter {
+ public:
+  // longest text from any of the methods
+  static const size_t max_size = 48;
+
+  NanosFormatter();
+  size_t timestamp(int64_t nanos, char* buffer);  // "%Y-%m-%d %H:%M:%S.%f"
+  size_t date(int64_t nanos, char* buffer);       // "%Y-%m-%d"
+  size_t time(int64_t nanos, char* buffer);       // "%H:%M:%S.%f"
+  size_t delta(int64_t delta, char* buffer);      // like delta_to_string()
+
+ private:
+  int64_t day_;
+  char date_[10];
+};
 
 /*** strongly typed container of integer ***/
 
@@ -167,19 +205,33 @@ NIL(Time)
 
 #undef NIL
 
+// count the excess zeros of a converted time, in groups of three
+template<class T>
+inline typename std::enable_if<is_datetime<T>::value, size_t>::type
+count_trailing_zeros(const std::string& x) {
+  size_t n = 0;
+  while (x.size() - n >= 4 && x.compare(x.size() - n - 3, 3, "000") == 0) {
+    n += 3;
+  }
+  return n;
+}
+
+// remove a number of excess zeros, which must not exceed the count above
+template<class T>
+inline typename std::enable_if<is_datetime<T>::value, void>::type
+trim_zeros(std::string& x, size_t n) {
+  x.resize(x.size() - n);
+  if (!x.empty() && x.back() == '.') {
+    x.pop_back();
+  }
+}
+
 // remove excess zeros
 template<class T>
 inline typename std::enable_if<is_datetime<T>::value, std::string>::type
 trim_trailing_zeros(const std::string& x) {
   std::string y = x;
-  while (y.size() >= 4 && y.substr(y.size() - 3) == "000") {
-    y.pop_back();
-    y.pop_back();
-    y.pop_back();
-  }
-  if (!y.empty() && y.back() == '.') {
-    y.pop_back();
-  }
+  trim_zeros<T>(y, count_trailing_zeros<T>(y));
   return y;
 }
 
@@ -200,35 +252,67 @@ trim_trailing_zeros(std::vector<std::string>& xs) {
     return;
   }
 
-  // if all elements end in three zeros, remove them
-  bool all_zeros = true;
-  while (all_zeros) {
-    for (const auto& x: xs) {
-      if (!x.empty() && (x.size() < 4 || x.substr(x.size() - 3) != "000")) {
-        all_zeros = false;
-      }
-    }
-    if (all_zeros) {
-      for (auto& x: xs) {
-        x.pop_back();
-        x.pop_back();
-        x.pop_back();
-      }
+  // remove the groups of three zeros that all elements end in
+  size_t zeros = std::string::npos;
+  for (const auto& x: xs) {
+    if (!x.empty()) {
+      zeros = std::min(zeros, count_trailing_zeros<T>(x));
     }
   }
   for (auto& x: xs) {
-    if (!x.empty() && x.back() == '.') {
-      x.pop_back();
+    if (!x.empty()) {
+      trim_zeros<T>(x, zeros);
     }
   }
 }
 
+// generate string for internal use
+#define TO_STRING(TYPE,METHOD) inline std::string to_string(TYPE t) {\
+  if (is_nil(t)) {\
+    return std::string();\
+  }\
+  char buffer[NanosFormatter::max_size];\
+  NanosFormatter formatter;\
+  return std::string(buffer, formatter.METHOD(int64_t(t), buffer));\
+}
+
+TO_STRING(Timestamp,timestamp)
+TO_STRING(Timedelta,delta)
+TO_STRING(Date,date)
+TO_STRING(Time,time)
+
+#undef TO_STRING
+
+// generate strings for a range of a column; one formatter is shared so that
+// consecutive values on the same day reuse the date
+#define TO_STRINGS(TYPE,METHOD) inline void to_strings(\
+  const std::vector<TYPE>& xs, size_t begin, size_t end, std::string* ys) {\
+  char buffer[NanosFormatter::max_size];\
+  NanosFormatter formatter;\
+  for (size_t i = begin; i < end; i++) {\
+    TYPE t = xs[i];\
+    if (is_nil(t)) {\
+      ys[i - begin].clear();\
+    }\
+    else {\
+      ys[i - begin].assign(buffer, formatter.METHOD(int64_t(t), buffer));\
+    }\
+  }\
+}
+
+TO_STRINGS(Timestamp,timestamp)
+TO_STRINGS(Timedelta,delta)
+TO_STRINGS(Date,date)
+TO_STRINGS(Time,time)
+
+#undef TO_STRINGS
+
 // generate string for console
 inline std::string to_repr(Timestamp t) {
   if (is_nil(t)) {
     return "Timestamp(nil)";
   }
-  auto s = trim_trailing_zeros<Timestamp>(nanos_to_string(int64_t(t)));
+  auto s = trim_trailing_zeros<Timestamp>(to_string(t));
   return "Timestamp(\"" + s + "\")";
 }
 
@@ -236,7 +320,7 @@ inline std::string to_repr(Timedelta t) {
   if (is_nil(t)) {
     return "Timedelta(nil)";
   }
-  auto s = trim_trailing_zeros<Timedelta>(delta_to_string(int64_t(t)));
+  auto s = trim_trailing_zeros<Timedelta>(to_string(t));
   return "Timedelta(\"" + s + "\")";
 }
 
@@ -244,47 +328,17 @@ inline std::string to_repr(Date t) {
   if (is_nil(t)) {
     return "Date(nil)";
   }
-  return "Date(\"" + nanos_to_string(int64_t(t), "%Y-%m-%d") + "\")";
+  return "Date(\"" + to_string(t) + "\")";
 }
 
 inline std::string to_repr(Time t) {
   if (is_nil(t)) {
     return "Time(nil)";
   }
-  auto s =
-    trim_trailing_zeros<Time>(nanos_to_string(int64_t(t), "%H:%M:%S.%f"));
+  auto s = trim_trailing_zeros<Time>(to_string(t));
   return "Time(\"" + s + "\")";
 }
 
-// generate string for internal use
-inline std::string to_string(Timestamp t) {
-  if (is_nil(t)) {
-    return std::string();
-  }
-  return nanos_to_string(int64_t(t));
-}
-
-inline std::string to_string(Timedelta t) {
-  if (is_nil(t)) {
-    return std::string();
-  }
-  return delta_to_string(int64_t(t));
-}
-
-inline std::string to_string(Date t) {
-  if (is_nil(t)) {
-    return std::string();
-  }
-  return nanos_to_string(int64_t(t), "%Y-%m-%d");
-}
-
-inline std::string to_string(Time t) {
-  if (is_nil(t)) {
-    return std::string();
-  }
-  return nanos_to_string(int64_t(t), "%H:%M:%S.%f");
-}
-
 // parse string
 template<class T>
 inline typename std::enable_if<std::is_same<T, Timestamp>::value, T>::type
@@ -309,6 +363,31 @@ inline typename std::enable_if<std::is_same<T, Time>::value, T>::type
 from_string(const std::string& text) {
   return Time(nanos_from_string(text));
 }
+
+// parse pointer and size
+template<class T>
+inline typename std::enable_if<std::is_same<T, Timestamp>::value, T>::type
+from_string(const char* text, size_t size) {
+  return Timestamp(nanos_from_string(text, size));
+}
+
+template<class T>
+inline typename std::enable_if<std::is_same<T, Timedelta>::value, T>::type
+from_string(const char* text, size_t size) {
+  return Timedelta(delta_from_string(text, size));
+}
+
+template<class T>
+inline typename std::enable_if<std::is_same<T, Date>::value, T>::type
+from_string(const char* text, size_t size) {
+  return Date(nanos_from_string(text, size));
+}
+
+template<class T>
+inline typename std::enable_if<std::is_same<T, Time>::value, T>::type
+from_string(const char* text, size_t size) {
+  return Time(nanos_from_string(text, size));
+}
 }  // namespace VVM
 
 
@@ -0,0 +1,148 @@
+/*
+ * Validity -- combine validity bitmaps and convert them to and from nil
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include <stdexcept>
+
+#include <VVM/utils/validity.hpp>
+
+namespace VVM {
+// number of bits set in a word
+static size_t popcount(uint64_t x) {
+#if defined(__GNUC__)
+  return size_t(__builtin_popcountll(x));
+#else
+  size_t n = 0;
+  for (; x != 0; x &= x - 1) {
+    n++;
+  }
+  return n;
+#endif
+}
+
+// bits of the last word that belong to rows
+static uint64_t last_word_mask(size_t nrows) {
+  size_t used = nrows % 64;
+  return (used == 0) ? ~uint64_t(0) : (uint64_t(1) << used) - 1;
+}
+
+// count rows that are missing
+size_t count_missing(const Validity& validity, size_t nrows) {
+  if (validity.empty()) {
+    return 0;
+  }
+  size_t valid = 0;
+  for (uint64_t word: validity) {
+    valid += popcount(word);
+  }
+  return nrows - valid;
+}
+
+// a row is valid in the result only if it is valid in both operands
+Validity combine_validity(const Validity& x, const Validity& y) {
+  if (x.empty()) {
+    return y;
+  }
+  if (y.empty()) {
+    return x;
+  }
+  if (x.size() != y.size()) {
+    throw std::runtime_error("Mismatch array lengths");
+  }
+  Validity z(x.size());
+  for (size_t w = 0; w < z.size(); w++) {
+    z[w] = x[w] & y[w];
+  }
+  return z;
+}
+
+// "and" and "or" of Bools follow Kleene's logic, so a missing row doesn't
+// matter when the other operand decides the result (eg., false and missing
+// is false); xs and ys are the operands' words, and a single value's word
+// stands for every row
+Validity logical_validity(bool is_and, const uint64_t* xs, bool x_scalar,
+                          const Validity& vx, const uint64_t* ys,
+                          bool y_scalar, const Validity& vy, size_t nrows) {
+  Validity validity(validity_words(nrows));
+  uint64_t missing = 0;
+  for (size_t w = 0; w < validity.size(); w++) {
+    uint64_t x = xs[x_scalar ? 0 : w];
+    uint64_t y = ys[y_scalar ? 0 : w];
+    uint64_t valid_x = vx.empty() ? ~uint64_t(0) : vx[w];
+    uint64_t valid_y = vy.empty() ? ~uint64_t(0) : vy[w];
+    uint64_t decided = is_and ? (valid_x & ~x) | (valid_y & ~y)
+                              : (valid_x & x) | (valid_y & y);
+    uint64_t mask = (w + 1 == validity.size()) ? last_word_mask(nrows)
+                                               : ~uint64_t(0);
+    validity[w] = ((valid_x & valid_y) | decided) & mask;
+    missing |= ~validity[w] & mask;
+  }
+  if (missing == 0) {
+    validity.clear();
+  }
+  return validity;
+}
+
+// append a bitmap of count rows after the first nrows rows; either may be
+// empty if its rows are all valid
+void append_validity(Validity& validity, size_t nrows, const Validity& more,
+                     size_t count) {
+  if (more.empty() && validity.empty()) {
+    return;
+  }
+  if (validity.empty()) {
+    validity.assign(validity_words(nrows), ~uint64_t(0));
+    if (!validity.empty()) {
+      validity.back() = last_word_mask(nrows);
+    }
+  }
+  validity.resize(validity_words(nrows + count), 0);
+  size_t base = nrows / 64;
+  size_t shift = nrows % 64;
+  size_t nwords = validity_words(count);
+  for (size_t w = 0; w < nwords; w++) {
+    uint64_t word = !more.empty() ? more[w]
+                  : (w + 1 == nwords) ? last_word_mask(count) : ~uint64_t(0);
+    validity[base + w] |= word << shift;
+    if (shift != 0 && base + w + 1 < validity.size()) {
+      validity[base + w + 1] |= word >> (64 - shift);
+    }
+  }
+}
+
+// read a bitmap of Arrow's bytes, which may be null if every row is valid
+Validity read_validity(const char* bitmap, size_t nrows) {
+  Validity validity;
+  if (bitmap == nullptr || nrows == 0) {
+    return validity;
+  }
+  validity.resize(validity_words(nrows));
+  memcpy(validity.data(), bitmap, (nrows + 7) / 8);
+  validity.back() &= last_word_mask(nrows);
+  if (count_missing(validity, nrows) == 0) {
+    validity.clear();
+  }
+  return validity;
+}
+
+// write a bitmap as Arrow's bytes, which must have room for every row
+void write_validity(const Validity& validity, size_t nrows, char* bitmap) {
+  size_t nbytes = (nrows + 7) / 8;
+  if (nrows == 0) {
+    return;
+  }
+  if (validity.empty()) {
+    Validity all(validity_words(nrows), ~uint64_t(0));
+    all.back() = last_word_mask(nrows);
+    memcpy(bitmap, all.data(), nbytes);
+    return;
+  }
+  memcpy(bitmap, validity.data(), nbytes);
+}
+}  // namespace VVM
@@ -0,0 +1,100 @@
+/*
+ * Validity header -- declares conversions between nil and validity bitmaps
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <VVM/utils/nil.hpp>
+
+/*
+ * A validity bitmap has one bit per row, set if the row has a value. It is
+ * how Arrow marks missing rows, and the interpreter keeps one alongside a
+ * column that was loaded with missing rows (or computed from one) so that
+ * operations can combine whole words of rows rather than testing every
+ * element. The bitmap is left empty when every row is valid, so a column
+ * without nil costs nothing extra.
+ *
+ * Bits are in Arrow's order (row i is bit i % 64 of word i / 64, and words
+ * are little-endian), so a bitmap is copied to and from an Arrow buffer
+ * as-is. Bits past the last row are always zero.
+ *
+ * Columns with a sentinel keep it in their values, which is how they are
+ * converted back at the boundaries: a row is valid exactly when its value
+ * isn't nil. This means that a value which happens to equal the sentinel
+ * (eg., an integer at max) is missing when written, just as the
+ * interpreter's own arithmetic treats it. A Bool has no sentinel, so its
+ * bitmap is the only record of a missing row; the row's value is whatever
+ * the row would be if it were false, so anything that ignores the bitmap
+ * sees what it always has.
+ */
+namespace VVM {
+
+typedef std::vector<uint64_t> Validity;
+
+// number of words in a bitmap for the given number of rows
+inline size_t validity_words(size_t nrows) {
+  return (nrows + 63) / 64;
+}
+
+// whether a row has a value
+inline bool is_valid(const Validity& validity, size_t i) {
+  return validity.empty() || ((validity[i >> 6] >> (i & 63)) & 1) != 0;
+}
+
+size_t count_missing(const Validity& validity, size_t nrows);
+Validity combine_validity(const Validity& x, const Validity& y);
+Validity logical_validity(bool is_and, const uint64_t* xs, bool x_scalar,
+                          const Validity& vx, const uint64_t* ys,
+                          bool y_scalar, const Validity& vy, size_t nrows);
+void append_validity(Validity& validity, size_t nrows, const Validity& more,
+                     size_t count);
+Validity read_validity(const char* bitmap, size_t nrows);
+void write_validity(const Validity& validity, size_t nrows, char* bitmap);
+
+// find the rows that aren't nil; empty if there are no nils
+template<class T>
+Validity sentinel_validity(const T* xs, size_t nrows) {
+  Validity validity(validity_words(nrows));
+  bool has_nil = false;
+  for (size_t w = 0; w < validity.size(); w++) {
+    size_t first = w * 64;
+    size_t count = (nrows - first < 64) ? nrows - first : 64;
+    uint64_t word = 0;
+    for (size_t b = 0; b < count; b++) {
+      word |= uint64_t(!is_nil(xs[first + b])) << b;
+    }
+    has_nil |= (count == 64) ? (word != ~uint64_t(0))
+                             : (word != (uint64_t(1) << count) - 1);
+    validity[w] = word;
+  }
+  if (!has_nil) {
+    validity.clear();
+  }
+  return validity;
+}
+
+// replace each missing row with nil; words with every row valid are skipped
+template<class T>
+void apply_validity(const Validity& validity, T* xs, size_t nrows) {
+  for (size_t w = 0; w < validity.size(); w++) {
+    uint64_t missing = ~validity[w];
+    for (size_t i = w * 64; missing != 0 && i < nrows; i++, missing >>= 1) {
+      if (missing & 1) {
+        xs[i] = nil_value<T>();
+      }
+    }
+  }
+}
+
+}  // namespace VVM
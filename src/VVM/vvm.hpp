@@ -20,6 +20,7 @@
 
 #include <VVM/types.h>
 #include <VVM/opcodes.h>
+#include <VVM/utils/simd.hpp>
 
 /*
  * Instructions (instr) in VVM are an opcode and any number of operands. These
@@ -114,6 +115,22 @@ enum class AsofDirection: int64_t {
   kBackward = 0, kForward = 1, kNearest = 2
 };
 
+// which comparison to apply to a column while loading
+enum class Comparison: int64_t {
+  kLt = 0, kGt = 1, kEq = 2, kNe = 3, kLte = 4, kGte = 5
+};
+
+/*** fused regions ***/
+
+// an elementwise instruction that may appear in a 'fuse' region
+struct FusedOpcode {
+  SimdOp op;
+  bool   is_float;   // Float64 rather than Int64
+  size_t arity;      // operands, including the result
+  bool   x_vector;
+  bool   y_vector;   // unused for unary operators
+};
+
 /*** forward declarations (most defined in bytecode.cpp) ***/
 
 type_definition_t get_type_members(type_t typee, const defined_types_t& types);
@@ -141,6 +158,7 @@ std::string decode_ptr(tagged_ptr_t ptr);
 std::string disassemble(const const_pool_t& cp);
 
 size_t encode_opcode(std::string op);
+bool find_fused_opcode(size_t opcode, FusedOpcode& info);
 std::string to_string(const Program& program);
 
 // defined in disassembler.h
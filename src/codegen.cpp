@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <empirical.hpp>
 
@@ -102,6 +103,94 @@ class CodegenVisitor : public HIR::BaseVisitor {
     return op;
   }
 
+  // a query's table might not be a declaration (eg., a direct load)
+  std::unordered_map<HIR::expr_t, VVM::operand_t> table_map_;
+
+  // point a query's table at a register, shadowing its declaration
+  void set_table_register(HIR::expr_t table, VVM::operand_t op) {
+    if (table->expr_kind == HIR::expr_::ExprKind::kId) {
+      HIR::Id_t id = dynamic_cast<HIR::Id_t>(table);
+      HIR::DeclRef_t ref = dynamic_cast<HIR::DeclRef_t>(id->ref);
+      reg_map_[ref->ref] = op;
+    }
+    else {
+      table_map_[table] = op;
+    }
+  }
+
+  /* temporaries */
+
+  // a builtin's result that is dead once its statement finishes; a fused
+  // intermediate lives in a tile instead, so its register is never written
+  struct Temporary {
+    VVM::operand_t op;
+    std::string type;
+    bool written;
+  };
+  std::vector<Temporary> live_temporaries_;
+
+  // dead registers by VVM type; a reused vector keeps its capacity
+  std::unordered_map<std::string, std::vector<VVM::operand_t>>
+    free_temporaries_;
+
+  // vectors that the current top-level statement left in the pool
+  std::vector<Temporary> released_vectors_;
+
+  // claim a register for a temporary, reusing a dead one of the same type
+  VVM::operand_t reserve_temporary(HIR::datatype_t node, bool written = true) {
+    std::string type = get_vvm_type(node);
+    auto& pool = free_temporaries_[type];
+    VVM::operand_t op;
+    if (pool.empty()) {
+      op = reserve_space();
+    }
+    else {
+      op = pool.back();
+      pool.pop_back();
+    }
+    live_temporaries_.push_back({op, type, written});
+    return op;
+  }
+
+  // return the temporaries made since the mark to the pool, except for a
+  // value that is still needed
+  void release_temporaries(size_t mark, const VVM::operand_t* keep = nullptr) {
+    std::vector<Temporary> kept;
+    for (size_t i = mark; i < live_temporaries_.size(); i++) {
+      const Temporary& t = live_temporaries_[i];
+      if (keep != nullptr && t.op == *keep) {
+        kept.push_back(t);
+        continue;
+      }
+      free_temporaries_[t.type].push_back(t.op);
+      if (t.type.back() == 'v' && t.written) {
+        released_vectors_.push_back(t);
+      }
+    }
+    live_temporaries_.resize(mark);
+    live_temporaries_.insert(live_temporaries_.end(), kept.begin(),
+                             kept.end());
+  }
+
+  // free the vectors that a top-level statement no longer needs, so that a
+  // long session doesn't keep every intermediate result
+  void delete_temporaries() {
+    std::unordered_set<VVM::operand_t> deleted;
+    for (auto& t: released_vectors_) {
+      if (deleted.insert(t.op).second) {
+        emit(VVM::encode_opcode("del_" + t.type), {t.op});
+      }
+    }
+    released_vectors_.clear();
+  }
+
+  // visit a statement inside a block; its temporaries are then reusable
+  void visit_statement(HIR::stmt_t node) {
+    size_t mark = live_temporaries_.size();
+    visit(node);
+    release_temporaries(mark);
+  }
+
   // non-immediate constant values are stored in a pool
   VVM::const_pool_t constants_;
 
@@ -166,6 +255,209 @@ class CodegenVisitor : public HIR::BaseVisitor {
     return VVM::encode_opcode(opstr);
   }
 
+  /* predicate pushdown */
+
+  // return whether an expression is a literal that VVM can compare against
+  bool is_literal(HIR::expr_t node) {
+    switch (node->expr_kind) {
+      case HIR::expr_::ExprKind::kIntegerLiteral:
+      case HIR::expr_::ExprKind::kFloatingLiteral:
+      case HIR::expr_::ExprKind::kBoolLiteral:
+      case HIR::expr_::ExprKind::kStr:
+      case HIR::expr_::ExprKind::kChar:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // return the column's offset if the node is a member of the given table
+  bool is_table_column(HIR::expr_t node, HIR::expr_t table, size_t& column) {
+    if (node->expr_kind != HIR::expr_::ExprKind::kImpliedMember) {
+      return false;
+    }
+    HIR::ImpliedMember_t im = dynamic_cast<HIR::ImpliedMember_t>(node);
+    if (im->implied_value != table || im->ref == nullptr ||
+        im->ref->resolved_kind != HIR::resolved_::ResolvedKind::kDeclRef) {
+      return false;
+    }
+    HIR::DeclRef_t ref = dynamic_cast<HIR::DeclRef_t>(im->ref);
+    column = ref->ref->offset;
+    return true;
+  }
+
+  // split the leftmost term off of a chain of 'and'
+  HIR::expr_t split_first_term(HIR::expr_t node, HIR::expr_t& rest) {
+    rest = nullptr;
+    if (node->expr_kind == HIR::expr_::ExprKind::kBinOp) {
+      HIR::BinOp_t b = dynamic_cast<HIR::BinOp_t>(node);
+      if (b->op == "and" && b->ref != nullptr &&
+          b->ref->resolved_kind == HIR::resolved_::ResolvedKind::kVVMOpRef) {
+        HIR::expr_t inner_rest;
+        HIR::expr_t first = split_first_term(b->left, inner_rest);
+        rest = (inner_rest == nullptr) ? b->right
+                                       : HIR::BinOp(inner_rest, b->op,
+                                                    b->right, b->ref,
+                                                    b->type, b->name);
+        return first;
+      }
+    }
+    return node;
+  }
+
+  // return whether a term compares a table's column to a literal
+  bool is_pushable_term(HIR::expr_t node, HIR::expr_t table, size_t& column,
+                        VVM::Comparison& cmp, HIR::expr_t& literal) {
+    while (node->expr_kind == HIR::expr_::ExprKind::kParen) {
+      node = dynamic_cast<HIR::Paren_t>(node)->subexpr;
+    }
+    if (node->expr_kind != HIR::expr_::ExprKind::kBinOp) {
+      return false;
+    }
+    HIR::BinOp_t b = dynamic_cast<HIR::BinOp_t>(node);
+
+    // only builtin comparisons between matching types
+    if (b->ref == nullptr ||
+        b->ref->resolved_kind != HIR::resolved_::ResolvedKind::kVVMOpRef) {
+      return false;
+    }
+    static const std::unordered_map<std::string, VVM::Comparison> ops = {
+      {"<", VVM::Comparison::kLt},   {">", VVM::Comparison::kGt},
+      {"==", VVM::Comparison::kEq},  {"!=", VVM::Comparison::kNe},
+      {"<=", VVM::Comparison::kLte}, {">=", VVM::Comparison::kGte}
+    };
+    auto iter = ops.find(b->op);
+    if (iter == ops.end()) {
+      return false;
+    }
+    cmp = iter->second;
+
+    // the column may be on either side
+    HIR::expr_t col_expr = b->left;
+    literal = b->right;
+    if (!is_table_column(col_expr, table, column)) {
+      std::swap(col_expr, literal);
+      if (!is_table_column(col_expr, table, column)) {
+        return false;
+      }
+      static const std::unordered_map<size_t, VVM::Comparison> flips = {
+        {size_t(VVM::Comparison::kLt), VVM::Comparison::kGt},
+        {size_t(VVM::Comparison::kGt), VVM::Comparison::kLt},
+        {size_t(VVM::Comparison::kLte), VVM::Comparison::kGte},
+        {size_t(VVM::Comparison::kGte), VVM::Comparison::kLte}
+      };
+      auto flip = flips.find(size_t(cmp));
+      if (flip != flips.end()) {
+        cmp = flip->second;
+      }
+    }
+    if (!is_literal(literal)) {
+      return false;
+    }
+    std::string col_type = get_vvm_type(col_expr->type);
+    std::string lit_type = get_vvm_type(literal->type);
+    col_type.pop_back();
+    lit_type.pop_back();
+    return col_type == lit_type;
+  }
+
+  /* expression fusion */
+
+  // return the opcode and arguments if VVM can fuse the operation
+  bool is_fusable(HIR::expr_t node, size_t& opcode,
+                  std::vector<HIR::expr_t>& args) {
+    while (node->expr_kind == HIR::expr_::ExprKind::kParen) {
+      node = dynamic_cast<HIR::Paren_t>(node)->subexpr;
+    }
+    HIR::resolved_t ref = nullptr;
+    switch (node->expr_kind) {
+      case HIR::expr_::ExprKind::kBinOp: {
+        HIR::BinOp_t b = dynamic_cast<HIR::BinOp_t>(node);
+        ref = b->ref;
+        args = {b->left, b->right};
+        break;
+      }
+      case HIR::expr_::ExprKind::kUnaryOp: {
+        HIR::UnaryOp_t u = dynamic_cast<HIR::UnaryOp_t>(node);
+        ref = u->ref;
+        args = {u->operand};
+        break;
+      }
+      case HIR::expr_::ExprKind::kFunctionCall: {
+        HIR::FunctionCall_t fc = dynamic_cast<HIR::FunctionCall_t>(node);
+        if (fc->func->expr_kind != HIR::expr_::ExprKind::kId) {
+          return false;
+        }
+        ref = dynamic_cast<HIR::Id_t>(fc->func)->ref;
+        args = fc->args;
+        break;
+      }
+      default:
+        return false;
+    }
+    if (ref == nullptr ||
+        ref->resolved_kind != HIR::resolved_::ResolvedKind::kVVMOpRef) {
+      return false;
+    }
+    opcode = dynamic_cast<HIR::VVMOpRef_t>(ref)->opcode;
+    VVM::FusedOpcode info;
+    return VVM::find_fused_opcode(opcode, info);
+  }
+
+  // append an operation (and any fusable arguments) to a fused region
+  VVM::operand_t fuse_operation(HIR::expr_t node, size_t opcode,
+                                const std::vector<HIR::expr_t>& args,
+                                VVM::instructions_t& region, size_t& count) {
+    std::vector<VVM::operand_t> params;
+    for (auto arg: args) {
+      size_t arg_opcode;
+      std::vector<HIR::expr_t> arg_args;
+      if (is_fusable(arg, arg_opcode, arg_args)) {
+        params.push_back(fuse_operation(arg, arg_opcode, arg_args, region,
+                                        count));
+      }
+      else {
+        VVM::operand_t p = visit(arg);
+        params.push_back(p);
+      }
+    }
+    VVM::operand_t result = reserve_temporary(node->type, false);
+    region.push_back(opcode);
+    region.insert(region.end(), params.begin(), params.end());
+    region.push_back(result);
+    count++;
+    return result;
+  }
+
+  // evaluate a chain of elementwise operations in a single pass; the other
+  // arguments are computed first, so only the chain's temporaries are skipped
+  bool emit_fused(HIR::FunctionCall_t node, VVM::operand_t& result) {
+    size_t opcode;
+    std::vector<HIR::expr_t> args;
+    if (!is_fusable(node, opcode, args)) {
+      return false;
+    }
+    bool has_chain = false;
+    for (auto arg: args) {
+      size_t arg_opcode;
+      std::vector<HIR::expr_t> arg_args;
+      has_chain = has_chain || is_fusable(arg, arg_opcode, arg_args);
+    }
+    if (!has_chain) {
+      return false;
+    }
+
+    VVM::instructions_t region;
+    size_t count = 0;
+    result = fuse_operation(node, opcode, args, region, count);
+    // only the last instruction's result, reserved last, is stored
+    live_temporaries_.back().written = true;
+    emit(VVM::opcodes::fuse,
+         {VVM::encode_operand(count, VVM::OpMask::kImmediate)});
+    instructions_.insert(instructions_.end(), region.begin(), region.end());
+    return true;
+  }
+
   /* miscellaneous */
 
   bool interactive_;
@@ -190,11 +482,19 @@ class CodegenVisitor : public HIR::BaseVisitor {
     constants_.clear();
     instructions_.clear();
     labeler_.clear();
-    // iteratively scan statements
+    // anything left by a module that failed to compile is now dead
+    release_temporaries(0);
+    released_vectors_.clear();
+    // iteratively scan statements; temporaries are freed after each one,
+    // except for a displayed value
     VVM::operand_t last_stmt_value;
     for (HIR::stmt_t s: node->body) {
       VVM::operand_t op = visit(s);
       last_stmt_value = op;
+      bool displayed = interactive_ && s == node->body.back() &&
+                       s->stmt_kind == HIR::stmt_::StmtKind::kExpr;
+      release_temporaries(0, displayed ? &last_stmt_value : nullptr);
+      delete_temporaries();
     }
     // if last stmt is a non-void expr, then display its value
     if (interactive_ && !node->body.empty()) {
@@ -210,6 +510,8 @@ class CodegenVisitor : public HIR::BaseVisitor {
           last_stmt_value = repr_value;
         }
       }
+      release_temporaries(0);
+      delete_temporaries();
     }
     // finish instructions
     emit(VVM::opcodes::halt, {});
@@ -230,6 +532,12 @@ class CodegenVisitor : public HIR::BaseVisitor {
     last_operands_[local_mask] = 0;
     VVM::instructions_t saved_bytecode = std::move(instructions_);
     VVM::Labeler<> saved_labeler = std::move(labeler_);
+    auto saved_live = std::move(live_temporaries_);
+    auto saved_free = std::move(free_temporaries_);
+    auto saved_released = std::move(released_vectors_);
+    live_temporaries_.clear();
+    free_temporaries_.clear();
+    released_vectors_.clear();
     // function arguments get the first set of registers
     for (auto decl: node->args) {
       VVM::operand_t value = reserve_space();
@@ -243,7 +551,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
                                                : VVM::encode_type("i64s");
     // recursively visit body
     for (auto b: node->body) {
-      visit(b);
+      visit_statement(b);
     }
     emit(VVM::opcodes::halt, {});
     labeler_.resolve(instructions_);
@@ -252,6 +560,9 @@ class CodegenVisitor : public HIR::BaseVisitor {
     last_operands_[local_mask] = saved_last_operand_local;
     instructions_ = std::move(saved_bytecode);
     labeler_ = std::move(saved_labeler);
+    live_temporaries_ = std::move(saved_live);
+    free_temporaries_ = std::move(saved_free);
+    released_vectors_ = std::move(saved_released);
     return result;
   }
 
@@ -289,7 +600,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
       VVM::operand_t cond = visit(node->test);
       emit_label(VVM::opcodes::bfalse, cond, end);
       for (auto b: node->body) {
-        visit(b);
+        visit_statement(b);
       }
       use_block(end);
     }
@@ -299,12 +610,12 @@ class CodegenVisitor : public HIR::BaseVisitor {
       VVM::operand_t cond = visit(node->test);
       emit_label(VVM::opcodes::bfalse, cond, next);
       for (auto b: node->body) {
-        visit(b);
+        visit_statement(b);
       }
       emit_label(VVM::opcodes::br, end);
       use_block(next);
       for (auto o: node->orelse) {
-        visit(o);
+        visit_statement(o);
       }
       use_block(end);
     }
@@ -318,7 +629,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
     VVM::operand_t cond = visit(node->test);
     emit_label(VVM::opcodes::bfalse, cond, end);
     for (auto b: node->body) {
-      visit(b);
+      visit_statement(b);
     }
     emit_label(VVM::opcodes::br, loop);
     use_block(end);
@@ -343,7 +654,12 @@ class CodegenVisitor : public HIR::BaseVisitor {
       VVM::operand_t typee = get_type_operand(d->type);
       emit(VVM::opcodes::alloc, {typee, target});
 
-      if (d->value != nullptr) {
+      if (d->value != nullptr &&
+          d->value->expr_kind == HIR::expr_::ExprKind::kTemplateInst) {
+        // load straight into the variable, same as an assignment would
+        load_into(dynamic_cast<HIR::TemplateInst_t>(d->value), target);
+      }
+      else if (d->value != nullptr) {
         // assign the value
         // TODO should "move" temporaries and "copy" otherwise
         VVM::operand_t value = visit(d->value);
@@ -355,6 +671,12 @@ class CodegenVisitor : public HIR::BaseVisitor {
 
   antlrcpp::Any visitAssign(HIR::Assign_t node) override {
     VVM::operand_t target = visit(node->target);
+    // loading straight into a variable lets a reload just parse new rows
+    if (node->target->expr_kind == HIR::expr_::ExprKind::kId &&
+        node->value->expr_kind == HIR::expr_::ExprKind::kTemplateInst) {
+      load_into(dynamic_cast<HIR::TemplateInst_t>(node->value), target);
+      return target;
+    }
     VVM::operand_t value = visit(node->value);
     VVM::operand_t typee = get_type_operand(node->value->type);
     emit(VVM::opcodes::assign, {value, typee, target});
@@ -375,20 +697,36 @@ class CodegenVisitor : public HIR::BaseVisitor {
   }
 
   antlrcpp::Any visitQuery(HIR::Query_t node) override {
-    VVM::operand_t table = visit(node->table);
+    // a comparison against a file that is being loaded is applied while
+    // parsing, leaving the remaining terms for the regular filter
+    HIR::expr_t remaining_where = node->where;
+    VVM::operand_t table = 0;
+    size_t column;
+    VVM::Comparison cmp;
+    HIR::expr_t literal;
+    HIR::expr_t rest;
+    if (node->where != nullptr &&
+        node->table->expr_kind == HIR::expr_::ExprKind::kTemplateInst &&
+        is_pushable_term(split_first_term(node->where, rest), node->table,
+                         column, cmp, literal)) {
+      HIR::TemplateInst_t ti = dynamic_cast<HIR::TemplateInst_t>(node->table);
+      table = load_where(ti, column, cmp, literal);
+      remaining_where = rest;
+    }
+    else {
+      table = visit(node->table);
+    }
     // we might need to shadow the register temporarily
     VVM::operand_t orig_table = table;
-    HIR::Id_t id = dynamic_cast<HIR::Id_t>(node->table);
-    HIR::DeclRef_t ref = dynamic_cast<HIR::DeclRef_t>(id->ref);
-    HIR::declaration_t declaration = ref->ref;
+    set_table_register(node->table, table);
 
-    if (node->where) {
-      VVM::operand_t where = visit(node->where);
+    if (remaining_where) {
+      VVM::operand_t where = visit(remaining_where);
       VVM::operand_t typee = get_type_operand(node->table->type);
       VVM::operand_t result = reserve_space();
       emit(VVM::opcodes::where, {table, where, typee, result});
       table = result;
-      reg_map_[declaration] = table;
+      set_table_register(node->table, table);
     }
 
     VVM::operand_t by_table;
@@ -433,7 +771,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
         emit(VVM::opcodes::lt_i64s_i64s, {counter, length, cmp_result});
         emit_label(VVM::opcodes::bfalse, cmp_result, end);
         VVM::operand_t sub_table = reserve_space();
-        reg_map_[declaration] = sub_table;
+        set_table_register(node->table, sub_table);
         emit(VVM::opcodes::member, {groups, counter, sub_table});
         assign_opcode = VVM::opcodes::append;
         num_leading_cols = number_of_fields(node->by_type);
@@ -460,7 +798,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
       table = result;
     }
 
-    reg_map_[declaration] = orig_table;
+    set_table_register(node->table, orig_table);
     return table;
   }
 
@@ -672,6 +1010,9 @@ class CodegenVisitor : public HIR::BaseVisitor {
 
   antlrcpp::Any visitFunctionCall(HIR::FunctionCall_t node) override {
     VVM::operand_t result = 0;
+    if (emit_fused(node, result)) {
+      return result;
+    }
     std::vector<VVM::operand_t> params;
     for (auto arg: node->args) {
       VVM::operand_t p = visit(arg);
@@ -700,7 +1041,7 @@ class CodegenVisitor : public HIR::BaseVisitor {
           HIR::resolved_::ResolvedKind::kVVMOpRef) {
         HIR::VVMOpRef_t ptr = dynamic_cast<HIR::VVMOpRef_t>(id->ref);
         size_t opcode = ptr->opcode;
-        result = reserve_space();
+        result = reserve_temporary(node->type);
         params.push_back(result);
         emit(opcode, params);
       }
@@ -746,6 +1087,13 @@ class CodegenVisitor : public HIR::BaseVisitor {
   }
 
   antlrcpp::Any visitTemplateInst(HIR::TemplateInst_t node) override {
+    VVM::operand_t result = reserve_space();
+    load_into(node, result);
+    return result;
+  }
+
+  // load a file into the given register
+  void load_into(HIR::TemplateInst_t node, VVM::operand_t result) {
     // TODO for now value must be "load"; allow anything in future
     if (node->value->expr_kind != HIR::expr_::ExprKind::kId) {
       nyi("TemplateInst on non-Id");
@@ -755,7 +1103,6 @@ class CodegenVisitor : public HIR::BaseVisitor {
       nyi("TemplateInst on non-load");
     }
     // visit args, resolved type, and output
-    VVM::operand_t result = 0;
     std::vector<VVM::operand_t> params;
     for (auto arg: node->args) {
       VVM::operand_t p = visit(arg);
@@ -764,9 +1111,31 @@ class CodegenVisitor : public HIR::BaseVisitor {
     // TODO Sema should probably put the Dataframe type in resolved
     VVM::operand_t type_code = get_type_operand(node->type);
     params.push_back(type_code);
-    result = reserve_space();
+    // only parse the referenced columns if sema found a projection
+    if (node->projection != nullptr) {
+      params.push_back(get_type_operand(node->projection));
+    }
+    params.push_back(result);
+    emit(node->projection != nullptr ? VVM::opcodes::loadproj
+                                     : VVM::opcodes::load, params);
+  }
+
+  // load a file, keeping only rows whose column compares true to a literal
+  VVM::operand_t load_where(HIR::TemplateInst_t node, size_t column,
+                            VVM::Comparison cmp, HIR::expr_t literal) {
+    std::vector<VVM::operand_t> params;
+    for (auto arg: node->args) {
+      VVM::operand_t p = visit(arg);
+      params.push_back(p);
+    }
+    params.push_back(get_type_operand(node->type));
+    params.push_back(VVM::encode_operand(column, VVM::OpMask::kImmediate));
+    params.push_back(VVM::encode_operand(size_t(cmp),
+                                         VVM::OpMask::kImmediate));
+    params.push_back(visit(literal));
+    VVM::operand_t result = reserve_space();
     params.push_back(result);
-    emit(VVM::opcodes::load, params);
+    emit(VVM::opcodes::loadwhere, params);
     return result;
   }
 
@@ -778,6 +1147,9 @@ class CodegenVisitor : public HIR::BaseVisitor {
       HIR::declaration_t declaration = ref->ref;
       source = reg_map_[declaration];
     }
+    else if (table_map_.find(node->value) != table_map_.end()) {
+      source = table_map_[node->value];
+    }
     else {
       nyi("Member from non-id value");
     }
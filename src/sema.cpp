@@ -809,6 +809,75 @@ class SemaVisitor : public AST::BaseVisitor {
     return result;
   }
 
+  /* projection pushdown */
+
+  // a loaded Dataframe only needs the members that are referenced, as long
+  // as the value itself is never used whole
+  struct LoadUses {
+    HIR::TemplateInst_t load;
+    size_t whole_uses;
+    std::unordered_set<std::string> members;
+  };
+  std::unordered_map<HIR::declaration_t, LoadUses> load_uses_;
+
+  // start tracking a declaration if its value is loaded from a file
+  void track_load(HIR::declaration_t node) {
+    if (!interactive_ && node->value != nullptr &&
+        node->value->expr_kind == HIR::expr_::ExprKind::kTemplateInst) {
+      HIR::TemplateInst_t ti = dynamic_cast<HIR::TemplateInst_t>(node->value);
+      load_uses_[node] = LoadUses{ti, 0, {}};
+    }
+  }
+
+  // return tracked uses if the resolved item is a loaded declaration
+  LoadUses* find_load_uses(HIR::resolved_t ref) {
+    if (ref == nullptr ||
+        ref->resolved_kind != HIR::resolved_::ResolvedKind::kDeclRef) {
+      return nullptr;
+    }
+    HIR::DeclRef_t dr = dynamic_cast<HIR::DeclRef_t>(ref);
+    auto iter = load_uses_.find(dr->ref);
+    return (iter != load_uses_.end()) ? &iter->second : nullptr;
+  }
+
+  // return a type definition string of only the kept columns
+  std::string keep_columns(HIR::datatype_t orig_type,
+                           const std::unordered_set<std::string>& kept) {
+    HIR::DataDef_t orig_dd = get_data_def(orig_type);
+    std::string result;
+    for (HIR::declaration_t d: orig_dd->body) {
+      if (kept.find(d->name) != kept.end()) {
+        HIR::datatype_t dt = is_array_type(d->type) ?
+                               get_underlying_type(d->type) :
+                               d->type;
+        std::string new_item = d->name + ": " + to_string(dt);
+        if (result.empty()) {
+          result = new_item;
+        }
+        else {
+          result += ", " + new_item;
+        }
+      }
+    }
+    return result;
+  }
+
+  // restrict loads to their referenced members
+  void push_down_projections() {
+    for (auto& lu: load_uses_) {
+      LoadUses& uses = lu.second;
+      size_t ncols = get_data_def(uses.load->type)->body.size();
+      if (uses.whole_uses == 0 && !uses.members.empty() &&
+          uses.members.size() < ncols) {
+        std::string proj_name = anon_func_name();
+        (void) create_datatype(proj_name,
+                               keep_columns(uses.load->type, uses.members));
+        uses.load->projection = make_dataframe('!' + proj_name);
+      }
+    }
+    load_uses_.clear();
+  }
+
   /* builtin items */
 
   // save all builtin items so that id resolution will find them
@@ -840,6 +909,7 @@ class SemaVisitor : public AST::BaseVisitor {
     for (AST::stmt_t s: node->body) {
       results.push_back(visit(s));
     }
+    push_down_projections();
     history_.insert(history_.end(), results.begin(), results.end());
     return HIR::Module(results, node->docstring);
   }
@@ -1528,7 +1598,8 @@ class SemaVisitor : public AST::BaseVisitor {
       }
     }
     HIR::datatype_t rettype = make_dataframe('!' + type_name);
-    return HIR::TemplateInst(value, args, resolutions, rettype, value->name);
+    return HIR::TemplateInst(value, args, resolutions, nullptr, rettype,
+                             value->name);
   }
 
   antlrcpp::Any visitMember(AST::Member_t node) override {
@@ -1547,6 +1618,15 @@ class SemaVisitor : public AST::BaseVisitor {
     if (ref != nullptr && type == nullptr) {
       sema_err_ << "Error: unable to resolve type" << std::endl;
     }
+    // a member of a loaded value isn't a use of the whole value
+    if (value->expr_kind == HIR::expr_::ExprKind::kId) {
+      HIR::Id_t id = dynamic_cast<HIR::Id_t>(value);
+      LoadUses* uses = find_load_uses(id->ref);
+      if (uses != nullptr) {
+        uses->whole_uses--;
+        uses->members.insert(node->member);
+      }
+    }
     return HIR::Member(value, node->member, ref, type, node->member);
   }
 
@@ -1624,6 +1704,10 @@ class SemaVisitor : public AST::BaseVisitor {
         return HIR::ImpliedMember(node->s, ptr, preferred_scope_, type,
                                   node->s);
       }
+      LoadUses* uses = find_load_uses(ptr);
+      if (uses != nullptr) {
+        uses->whole_uses++;
+      }
       return HIR::Id(node->s, ptr, type, node->s);
     }
     HIR::datatype_t temp_type = get_type(resolveds[0]);
@@ -1758,6 +1842,7 @@ class SemaVisitor : public AST::BaseVisitor {
         sema_err_ << "Error: symbol " << node->name
                   << " was already defined" << std::endl;
       }
+      track_load(new_node);
     }
     return new_node;
   }
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Test that the columns of a binary file are read in place, by loading a file
+# that is larger than the process may allocate
+# (Must pass-in path to Empirical)
+
+mkdir -p scratch_mapped
+$1 mapped/store.vvm
+result=$(ulimit -d 20480; diff <($1 mapped/load.vvm 2>&1) <(grep ";;" mapped/load.vvm | sed "s/;;//"))
+ret=$?
+if [[ $ret -ne 0 ]]
+then
+  echo mapped/load.vvm
+  echo $result
+fi
+rm -rf scratch_mapped
+exit $ret
@@ -1,12 +1,24 @@
 #!/bin/bash
 
 # Test whether all VVM files produce their expected output
-# (Must pass-in path to Empirical)
+# (Must pass-in path to Empirical, followed by any files to skip)
+
+# files stored by the tests go in a scratch directory; several workers are
+# used even on a single core, so that the parallel paths are exercised
+mkdir -p scratch
+export EMPIRICAL_THREADS=4
+
+exe=$1
+shift
 
 ret=0
 for f in *.vvm
 do
-  result=$(diff <($1 $f) <(grep ";;" $f | sed "s/;;//"))
+  if [[ " $* " == *" $f "* ]]
+  then
+    continue
+  fi
+  result=$(diff <($exe $f) <(grep ";;" $f | sed "s/;;//"))
   if [[ $? -ne 0 ]]
   then
     echo $f
@@ -14,5 +26,6 @@ do
     ret=1
   fi
 done
+rm -rf scratch
 exit $ret
 
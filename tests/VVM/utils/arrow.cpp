@@ -0,0 +1,119 @@
+/*
+ * Tests for the Arrow IPC file format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include <VVM/utils/arrow.hpp>
+
+std::string read_file(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  std::ostringstream oss;
+  oss << in.rdbuf();
+  return oss.str();
+}
+
+int main() {
+  main_ret = 0;
+
+  TEST(VVM::is_arrow_file("prices.arrow"), true)
+  TEST(VVM::is_arrow_file("prices.feather"), true)
+  TEST(VVM::is_arrow_file("prices.csv"), false)
+  TEST(VVM::is_arrow_file(".arrow"), false)
+
+  TEST(VVM::arrow_padding(0), 0)
+  TEST(VVM::arrow_padding(5), 3)
+  TEST(VVM::arrow_padding(16), 0)
+
+  TEST(VVM::arrow_buffer_count(VVM::ArrowType::kInt), 2)
+  TEST(VVM::arrow_buffer_count(VVM::ArrowType::kUtf8), 3)
+
+  // a file of one batch: an Int64 with a null and a String
+  std::vector<VVM::ArrowField> fields{
+    {"a", VVM::ArrowType::kInt, 64, true, 0},
+    {"b", VVM::ArrowType::kUtf8, 0, false, 0}};
+  VVM::ArrowBatch batch{2, 0, 48, {{2, 1}, {2, 0}},
+                        {{0, 8}, {8, 16}, {24, 0}, {24, 16}, {40, 3}}};
+  std::string header = VVM::write_arrow_header(fields);
+  std::string message = VVM::write_arrow_batch(batch);
+  TEST(header.size() % 8, 0)
+  TEST(message.size() % 8, 0)
+  batch.body = header.size() + message.size();
+
+  std::string body(48, '\0');
+  body[0] = 2;
+  body[16] = 7;
+  body[28] = 1;
+  body[32] = 3;
+  body.replace(40, 3, "xyz");
+  std::vector<VVM::ArrowBatch> batches{batch};
+  std::vector<uint64_t> positions{header.size()};
+  std::string contents = header + message + body +
+                         VVM::write_arrow_footer(fields, batches, positions);
+
+  VVM::ArrowFile file = VVM::read_arrow_file(contents.data(),
+                                             contents.size());
+  TEST(VVM::arrow_type_def(file.fields), "a: Int64, b: String")
+  TEST(file.batches.size(), 1)
+  TEST(file.batches[0].nrows, 2)
+  TEST(file.batches[0].body, batch.body)
+  TEST(file.batches[0].nodes[0].null_count, 1)
+  TEST(file.batches[0].buffers[4].length, 3)
+
+  const char* data = contents.data() + file.batches[0].body;
+  TEST(VVM::arrow_is_valid(data, 0), false)
+  TEST(VVM::arrow_is_valid(data, 1), true)
+  TEST(VVM::arrow_int_at(data + 8, 64, true, 1), 7)
+
+  // files written by other tools
+  TEST(VVM::read_arrow_type("../../sample_csv/prices.feather"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+
+  contents = read_file("../../sample_csv/nulls.arrow");
+  file = VVM::read_arrow_file(contents.data(), contents.size());
+  TEST(VVM::arrow_type_def(file.fields),
+       "i: Int64, f: Float64, b: Bool, s: String, t: Timestamp, d: Date, tm: Time, dt: Timedelta")
+  TEST(file.fields[0].bit_width, 32)
+  TEST(file.fields[5].bit_width, 32)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[4]), 1000000)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[5]), 86400000000000)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[7]), 1000000000)
+  TEST(file.batches.size(), 2)
+  TEST(file.batches[0].nrows, 2)
+  TEST(file.batches[1].nrows, 1)
+
+  // units that the writer left out take each type's default
+  contents = read_file("../../sample_csv/seconds.arrow");
+  file = VVM::read_arrow_file(contents.data(), contents.size());
+  TEST(VVM::arrow_type_def(file.fields),
+       "t: Timestamp, d: Date, tm: Time, dt: Timedelta")
+  TEST(VVM::arrow_nanos_per_unit(file.fields[0]), 1000000000)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[1]), 1000000)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[2]), 1000000)
+  TEST(file.fields[2].bit_width, 32)
+  TEST(VVM::arrow_nanos_per_unit(file.fields[3]), 1000000)
+
+  contents = read_file("../../sample_csv/nulls.arrow");
+  file = VVM::read_arrow_file(contents.data(), contents.size());
+  const VVM::ArrowBatch& first = file.batches[0];
+  data = contents.data() + first.body;
+  TEST(first.nodes[0].null_count, 1)
+  TEST(VVM::arrow_is_valid(data + first.buffers[0].offset, 1), false)
+  TEST(VVM::arrow_int_at(data + first.buffers[1].offset, 32, true, 0), 1)
+
+  const VVM::ArrowBatch& second = file.batches[1];
+  data = contents.data() + second.body;
+  TEST(second.nodes[0].null_count, 0)
+  TEST(VVM::arrow_int_at(data + second.buffers[1].offset, 32, true, 0), -3)
+
+  return main_ret;
+}
@@ -0,0 +1,64 @@
+/*
+ * Tests for the native binary table format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <VVM/utils/columnar.hpp>
+
+int main() {
+  main_ret = 0;
+
+  TEST(VVM::is_columnar_file("prices.edf"), true)
+  TEST(VVM::is_columnar_file("prices.csv"), false)
+  TEST(VVM::is_columnar_file(".edf"), false)
+  TEST(VVM::is_columnar_file("prices.edfz"), true)
+  TEST(VVM::is_compressed_file("prices.edfz"), true)
+  TEST(VVM::is_compressed_file("prices.edf"), false)
+
+  TEST(VVM::columnar_padding(0), 0)
+  TEST(VVM::columnar_padding(5), 3)
+  TEST(VVM::columnar_padding(16), 0)
+
+  VVM::ColumnarHeader header{"a: Int64, b: String", 3, {80, 104}};
+  std::string bytes = VVM::write_columnar_header(header);
+  TEST(bytes.size(), VVM::columnar_header_size(header.type_def, 2))
+  TEST(bytes.size() % 8, 0)
+
+  std::string contents = bytes + std::string(40, '\0');
+  VVM::ColumnarHeader parsed = VVM::read_columnar_header(contents.data(),
+                                                         contents.size());
+  TEST(parsed.type_def, "a: Int64, b: String")
+  TEST(parsed.nrows, 3)
+  TEST(parsed.offsets.size(), 2)
+  TEST(parsed.offsets[1], 104)
+
+  TEST(VVM::read_columnar_type("../../sample_csv/prices.edf"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+  TEST(VVM::read_columnar_type("../../sample_csv/prices.edfz"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+
+  VVM::CompressedColumn column{VVM::Codec::kDictionary, {"AAPL", "EBAY"},
+                               {{200, 8, 30, 0, 0, 0}, {208, 16, 5, 0, 0, 0}}};
+  bytes = VVM::write_compressed_column(column);
+  TEST(bytes.size(), VVM::compressed_column_size(column))
+  TEST(bytes.size() % 8, 0)
+
+  contents = std::string(64, '\0') + bytes + std::string(160, '\0');
+  VVM::CompressedColumn decoded = VVM::read_compressed_column(
+    contents.data(), contents.size(), 64);
+  TEST(uint64_t(decoded.codec), uint64_t(VVM::Codec::kDictionary))
+  TEST(decoded.dictionary.size(), 2)
+  TEST(decoded.dictionary[1], "EBAY")
+  TEST(decoded.blocks.size(), 2)
+  TEST(decoded.blocks[1].offset, 208)
+  TEST(decoded.blocks[1].nrows, 5)
+
+  return main_ret;
+}
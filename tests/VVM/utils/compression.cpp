@@ -0,0 +1,110 @@
+/*
+ * Tests for the integer codecs of the compressed table format
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <limits>
+
+#include <VVM/utils/compression.hpp>
+
+int main() {
+  main_ret = 0;
+
+  const int64_t nil = std::numeric_limits<int64_t>::max();
+  const int64_t lowest = std::numeric_limits<int64_t>::min();
+
+  // varints
+  std::string buffer;
+  VVM::put_varint(buffer, 0);
+  VVM::put_varint(buffer, 300);
+  VVM::put_varint(buffer, ~uint64_t(0));
+  TEST(buffer.size(), 13)
+  const char* p = buffer.data();
+  const char* end = p + buffer.size();
+  TEST(VVM::get_varint(p, end), 0)
+  TEST(VVM::get_varint(p, end), 300)
+  TEST(VVM::get_varint(p, end), ~uint64_t(0))
+  TEST((p == end), true)
+
+  TEST(VVM::zigzag_encode(0), 0)
+  TEST(VVM::zigzag_encode(-1), 1)
+  TEST(VVM::zigzag_encode(1), 2)
+  TEST(VVM::zigzag_decode(VVM::zigzag_encode(lowest)), lowest)
+  TEST(VVM::zigzag_decode(VVM::zigzag_encode(nil)), nil)
+
+  TEST(VVM::bit_width(0), 0)
+  TEST(VVM::bit_width(1), 1)
+  TEST(VVM::bit_width(255), 8)
+  TEST(VVM::bit_width(256), 9)
+
+  // bit packing, including codes that straddle words
+  std::vector<uint64_t> codes{5, 0, 7, 3, 6, 1, 2, 4, 7, 7, 0, 5, 3, 1, 6, 2,
+                              4, 5, 6, 7, 1, 2, 3};
+  buffer.clear();
+  VVM::pack_bits(codes, 3, buffer);
+  TEST(buffer.size(), VVM::packed_size(codes.size(), 3))
+  std::vector<uint64_t> unpacked(codes.size());
+  VVM::unpack_bits(buffer.data(), buffer.data() + buffer.size(), codes.size(),
+                   3, unpacked.data());
+  TEST((unpacked == codes), true)
+
+  // delta-of-delta for regular series
+  std::vector<int64_t> times;
+  for (int64_t i = 0; i < 1000; i++) {
+    times.push_back(1546300800000000000 + i * 1000000000);
+  }
+  times[500] = nil;
+  buffer.clear();
+  VVM::encode_delta(times.data(), times.size(), buffer);
+  TEST((buffer.size() < times.size() * 2), true)
+  std::vector<int64_t> decoded(times.size());
+  VVM::decode_delta(buffer.data(), buffer.data() + buffer.size(),
+                    times.size(), decoded.data());
+  TEST((decoded == times), true)
+
+  // frame of reference, where nil gets its own code
+  std::vector<int64_t> ints{1000, 1003, nil, 1001, 1007, 1000};
+  buffer.clear();
+  VVM::encode_frame(ints.data(), ints.size(), nil, buffer);
+  TEST(buffer.size(), 24)
+  decoded.resize(ints.size());
+  VVM::decode_frame(buffer.data(), buffer.data() + buffer.size(), ints.size(),
+                    nil, decoded.data());
+  TEST((decoded == ints), true)
+
+  std::vector<int64_t> extremes{lowest, nil - 1, nil, 0};
+  buffer.clear();
+  VVM::encode_frame(extremes.data(), extremes.size(), nil, buffer);
+  decoded.resize(extremes.size());
+  VVM::decode_frame(buffer.data(), buffer.data() + buffer.size(),
+                    extremes.size(), nil, decoded.data());
+  TEST((decoded == extremes), true)
+
+  std::vector<int64_t> nils{nil, nil};
+  buffer.clear();
+  VVM::encode_frame(nils.data(), nils.size(), nil, buffer);
+  decoded.resize(nils.size());
+  VVM::decode_frame(buffer.data(), buffer.data() + buffer.size(),
+                    nils.size(), nil, decoded.data());
+  TEST((decoded == nils), true)
+
+  // malformed input throws
+  bool threw = false;
+  try {
+    VVM::decode_frame(buffer.data(), buffer.data() + 8, 2, nil,
+                      decoded.data());
+  }
+  catch (std::logic_error& e) {
+    threw = true;
+  }
+  TEST(threw, true)
+
+  return main_ret;
+}
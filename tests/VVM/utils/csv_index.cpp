@@ -0,0 +1,41 @@
+/*
+ * Tests for a CSV file's row index
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <VVM/utils/csv_index.hpp>
+
+int main() {
+  main_ret = 0;
+
+  // the index is hidden beside its file
+  TEST(VVM::csv_index_filename("prices.csv"), std::string(".prices.csv.idx"))
+  TEST(VVM::csv_index_filename("data/prices.csv"),
+       std::string("data/.prices.csv.idx"))
+  TEST(VVM::csv_index_filename("/data/daily/a.csv"),
+       std::string("/data/daily/.a.csv.idx"))
+
+  // a file without an index
+  VVM::CsvIndex index;
+  TEST(VVM::read_csv_index("../../sample_csv/prices.csv", index), false)
+  TEST(VVM::read_csv_index("../../sample_csv/missing.csv", index), false)
+
+  // find the last entry at or before a row
+  index.nrows = 300;
+  index.entries = {{10, 0}, {2000, 100}, {4100, 200}};
+  TEST(VVM::find_csv_index_entry(index, 0), 0)
+  TEST(VVM::find_csv_index_entry(index, 99), 0)
+  TEST(VVM::find_csv_index_entry(index, 100), 1)
+  TEST(VVM::find_csv_index_entry(index, 150), 1)
+  TEST(VVM::find_csv_index_entry(index, 200), 2)
+  TEST(VVM::find_csv_index_entry(index, 1000), 2)
+
+  return main_ret;
+}
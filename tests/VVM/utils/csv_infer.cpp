@@ -10,6 +10,8 @@
 
 #include "test.hpp"
 
+#include <sysconfig.hpp>
+
 #include <VVM/utils/csv_infer.hpp>
 
 int main() {
@@ -24,6 +26,32 @@ int main() {
   TEST(VVM::infer_table_from_file("../../sample_csv/malformed.csv"),
        "date: Date, quant_equity: Float64, model: String, live_backtest: String, unnamed_4: String, unnamed_5: String, date_1: Date, quant_macro: Float64")
 
+  TEST(VVM::infer_table_from_file("../../sample_csv/prices.edf"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+
+  TEST(VVM::infer_table_from_file("../../sample_csv/prices.feather"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+
+#ifdef EMPIRICAL_GZIP
+  TEST(VVM::infer_table_from_file("../../sample_csv/prices.csv.gz"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+#endif
+
+  TEST(VVM::infer_table_from_file("../../sample_csv/daily/*.csv"),
+       "symbol: String, date: Date, open: Float64, high: Float64, low: Float64, close: Float64, volume: Int64")
+
+  // types widen for values past the first few rows
+  TEST(VVM::infer_table_from_file("../../sample_csv/widening.csv"),
+       "id: Int64, price: Float64, when: Timestamp, flag: Bool")
+
+  TEST(VVM::infer_common_strtime_format({"2019-03-28", "", "2019-03-29"}),
+       "%Y-%m-%d")
+
+  TEST(VVM::infer_common_strtime_format({"2019-03-28", "2019-03-28 22:16:33"}),
+       "")
+
+  TEST(VVM::infer_common_strtime_format({""}), "")
+
   return main_ret;
 }
 
@@ -0,0 +1,90 @@
+/*
+ * Tests for expanding a load's or store's filename
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include <VVM/utils/file_pattern.hpp>
+
+int main() {
+  main_ret = 0;
+
+  TEST(VVM::is_file_pattern("prices.csv"), false)
+  TEST(VVM::is_file_pattern("prices_*.csv"), true)
+  TEST(VVM::is_file_pattern("prices_?.csv"), true)
+  TEST(VVM::is_file_pattern("{a,b}.csv"), true)
+
+  // plain names are left alone, even if missing
+  auto filenames = VVM::expand_file_pattern("missing.csv");
+  TEST(filenames.size(), 1)
+  TEST(filenames[0], "missing.csv")
+
+  // an existing file is taken literally even if it looks like a pattern
+  std::ofstream("literal[1].csv") << "a\n1\n";
+  filenames = VVM::expand_file_pattern("literal[1].csv");
+  TEST(filenames.size(), 1)
+  TEST(filenames[0], "literal[1].csv")
+  std::remove("literal[1].csv");
+
+  filenames = VVM::expand_file_pattern("../../sample_csv/daily/*.csv");
+  TEST(filenames.size(), 3)
+  TEST(filenames[0], "../../sample_csv/daily/AAPL.csv")
+  TEST(filenames[2], "../../sample_csv/daily/EBAY.csv")
+
+  bool threw = false;
+  try {
+    VVM::expand_file_pattern("../../sample_csv/daily/*.missing");
+  }
+  catch (std::logic_error& e) {
+    threw = true;
+  }
+  TEST(threw, true)
+
+  // a store's filename names members in braces
+  TEST(VVM::is_partition_pattern("daily/{symbol}.csv"), true)
+  TEST(VVM::is_partition_pattern("{jan,feb}.csv"), false)
+  auto keys = VVM::partition_keys("{date}/{symbol}_{jan,feb}.csv");
+  TEST(keys.size(), 2)
+  TEST(keys[0], "date")
+  TEST(keys[1], "symbol")
+  std::vector<std::string> values = {"2017-01-03", "AAPL"};
+  TEST(VVM::fill_partition("{date}/{symbol}_{jan,feb}.csv", values),
+       "2017-01-03/AAPL_{jan,feb}.csv")
+  values = {"BRK.B"};
+  TEST(VVM::fill_partition("daily/{symbol}.csv", values), "daily/BRK.B.csv")
+
+  // a key can't add or leave a directory
+  TEST(VVM::partition_value("a/b"), "a%2Fb")
+  TEST(VVM::partition_value("a\\b"), "a%5Cb")
+  TEST(VVM::partition_value(".."), "%2E%2E")
+  TEST(VVM::partition_value("."), "%2E")
+  TEST(VVM::partition_value("..."), "...")
+  TEST(VVM::partition_value("100%"), "100%25")
+  TEST(VVM::partition_value(""), "nil")
+  values = {"../etc"};
+  TEST(VVM::fill_partition("daily/{symbol}.csv", values),
+       "daily/..%2Fetc.csv")
+
+  // missing directories are created
+  VVM::make_parent_dirs("scratch_dirs/a/b/c.csv");
+  std::ofstream("scratch_dirs/a/b/c.csv") << "a\n1\n";
+  filenames = VVM::expand_file_pattern("scratch_dirs/a/*/*.csv");
+  TEST(filenames.size(), 1)
+  VVM::make_parent_dirs("scratch_dirs/a/b/c.csv");
+  std::remove("scratch_dirs/a/b/c.csv");
+  std::remove("scratch_dirs/a/b");
+  std::remove("scratch_dirs/a");
+  std::remove("scratch_dirs");
+
+  return main_ret;
+}
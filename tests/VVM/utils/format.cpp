@@ -0,0 +1,168 @@
+/*
+ * Tests for writing numbers as text
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <VVM/utils/format.hpp>
+
+// wrappers that return the written text
+std::string int64_text(int64_t x) {
+  char buffer[VVM::max_format_size];
+  return std::string(buffer, VVM::format_int64(x, buffer));
+}
+
+std::string uint64_text(uint64_t x) {
+  char buffer[VVM::max_format_size];
+  return std::string(buffer, VVM::format_uint64(x, buffer));
+}
+
+std::string float64_text(double x) {
+  char buffer[VVM::max_format_size];
+  return std::string(buffer, VVM::format_float64(x, buffer));
+}
+
+std::string shortest_text(double x) {
+  char buffer[VVM::max_format_size];
+  return std::string(buffer, VVM::format_shortest_float64(x, buffer));
+}
+
+// text of a float with all of its excess zeros removed
+std::string trimmed_text(double x) {
+  char buffer[VVM::max_format_size];
+  size_t n = VVM::format_float64(x, buffer);
+  n = VVM::trim_float_zeros(buffer, n, VVM::count_float_zeros(buffer, n));
+  return std::string(buffer, n);
+}
+
+// zeros counted from the formatted text
+size_t formatted_zeros(double x) {
+  char buffer[VVM::max_format_size];
+  return VVM::count_float_zeros(buffer, VVM::format_float64(x, buffer));
+}
+
+int main() {
+  main_ret = 0;
+
+  TEST(int64_text(0), "0")
+  TEST(int64_text(7), "7")
+  TEST(int64_text(10), "10")
+  TEST(int64_text(-5), "-5")
+  TEST(int64_text(1234567890), "1234567890")
+  TEST(int64_text(std::numeric_limits<int64_t>::max()), "9223372036854775807")
+  TEST(int64_text(std::numeric_limits<int64_t>::min()), "-9223372036854775808")
+  TEST(uint64_text(std::numeric_limits<uint64_t>::max()),
+       "18446744073709551615")
+
+  // floats have six places, just like std::to_string()
+  TEST(float64_text(0.0), "0.000000")
+  TEST(float64_text(115.8), "115.800000")
+  TEST(float64_text(-5.5), "-5.500000")
+  TEST(float64_text(0.1234567), "0.123457")
+  TEST(float64_text(1e20), "100000000000000000000.000000")
+  TEST(float64_text(1.0 / 3.0), std::to_string(1.0 / 3.0))
+  TEST(float64_text(-2.0 / 3.0), std::to_string(-2.0 / 3.0))
+  TEST(float64_text(std::numeric_limits<double>::max()).size(), 316)
+
+  // six places are rounded from the shortest digits just as printf() would
+  // round the float itself, including its ties and its largest values
+  TEST(float64_text(-0.0), "-0.000000")
+  TEST(float64_text(-0.0000001), "-0.000000")
+  TEST(float64_text(0.0000005), "0.000000")
+  TEST(float64_text(0.1234565), "0.123456")
+  TEST(float64_text(4294967296.0000005), "4294967296.000001")
+  TEST(float64_text(1e23), "99999999999999991611392.000000")
+  TEST(float64_text(1.0 / 0.0), "inf")
+  bool matches = true;
+  std::mt19937_64 generator(1);
+  for (int64_t i = 0; i < 200000; i++) {
+    uint64_t bits = generator();
+    double xs[] = {0, double(i - 100000) * 0.0000005,
+                   double(int64_t(bits % 20000000000ULL) - 10000000000LL) / 1024,
+                   std::ldexp(double(bits >> 11), -int(bits % 80))};
+    std::memcpy(&xs[0], &bits, sizeof(bits));
+    for (double x: xs) {
+      char expected[VVM::max_format_size];
+      int n = std::snprintf(expected, sizeof(expected), "%.6f", x);
+      if (float64_text(x) != std::string(expected, n)) {
+        matches = false;
+      }
+    }
+  }
+  TEST(matches, true)
+
+  // the shortest text reads back as the same float
+  TEST(shortest_text(0.0), "0.0")
+  TEST(shortest_text(-0.0), "-0.0")
+  TEST(shortest_text(0.1), "0.1")
+  TEST(shortest_text(-115.8), "-115.8")
+  TEST(shortest_text(100.0), "100.0")
+  TEST(shortest_text(1.0 / 3.0), "0.3333333333333333")
+  TEST(shortest_text(0.0001), "0.0001")
+  TEST(shortest_text(0.00001), "1e-05")
+  TEST(shortest_text(1e16), "1e+16")
+  TEST(shortest_text(1234567890123456.0), "1234567890123456.0")
+  TEST(shortest_text(1e23), "1e+23")
+  TEST(shortest_text(5e-324), "5e-324")
+  TEST(shortest_text(std::numeric_limits<double>::max()),
+       "1.7976931348623157e+308")
+  bool round_trips = true;
+  for (int64_t i = 0; i < 200000; i++) {
+    uint64_t bits = generator();
+    double x;
+    std::memcpy(&x, &bits, sizeof(bits));
+    if (std::isfinite(x) &&
+        std::strtod(shortest_text(x).c_str(), nullptr) != x) {
+      round_trips = false;
+    }
+  }
+  TEST(round_trips, true)
+
+  // excess zeros are removed, but a digit is kept after the point
+  TEST(VVM::count_float_zeros("115.800000", 10), 5)
+  TEST(VVM::count_float_zeros("0.123457", 8), 0)
+  TEST(trimmed_text(115.8), "115.8")
+  TEST(trimmed_text(100.0), "100.0")
+  TEST(trimmed_text(-0.25), "-0.25")
+  TEST(trimmed_text(0.123457), "0.123457")
+  char column[] = "115.850000";
+  TEST(VVM::trim_float_zeros(column, 10, 2), 8)
+  TEST(std::string(column, 8), "115.8500")
+
+  // the zeros of a float are the same whether it is formatted or not
+  TEST(VVM::count_float64_zeros(115.8), 5)
+  TEST(VVM::count_float64_zeros(-115.85), 4)
+  TEST(VVM::count_float64_zeros(100.0), 6)
+  TEST(VVM::count_float64_zeros(0.0), 6)
+  TEST(VVM::count_float64_zeros(-0.0), 6)
+  TEST(VVM::count_float64_zeros(0.123456), 0)
+  TEST(VVM::count_float64_zeros(0.1234567), 0)
+  TEST(VVM::count_float64_zeros(0.0000004), 6)
+  TEST(VVM::count_float64_zeros(1e300), 6)
+  TEST(VVM::count_float64_zeros(0.0000005), formatted_zeros(0.0000005))
+  TEST(VVM::count_float64_zeros(2.0000005), formatted_zeros(2.0000005))
+  TEST(VVM::count_float64_zeros(1.0 / 0.0), formatted_zeros(1.0 / 0.0))
+  bool same = true;
+  for (int64_t i = -100000; i < 100000; i++) {
+    double x = double(i) * 0.0000125;
+    if (VVM::count_float64_zeros(x) != formatted_zeros(x)) {
+      same = false;
+    }
+  }
+  TEST(same, true)
+
+  return main_ret;
+}
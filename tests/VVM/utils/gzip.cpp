@@ -0,0 +1,81 @@
+/*
+ * Tests for reading gzip-compressed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <VVM/utils/gzip.hpp>
+
+std::string read_file(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  std::ostringstream oss;
+  oss << in.rdbuf();
+  return oss.str();
+}
+
+int main() {
+  main_ret = 0;
+
+  TEST(VVM::is_gzip_file("prices.csv.gz"), true)
+  TEST(VVM::is_gzip_file("prices.csv"), false)
+  TEST(VVM::is_gzip_file(".gz"), false)
+
+  std::string expected = read_file("../../sample_csv/prices.csv");
+
+  // read the whole file in small pieces
+  VVM::GzipReader reader("../../sample_csv/prices.csv.gz");
+  std::string text;
+  char buffer[100];
+  size_t n;
+  while ((n = reader.read(buffer, sizeof(buffer))) != 0) {
+    text.append(buffer, n);
+  }
+  TEST(text.size(), expected.size())
+  TEST((text == expected), true)
+
+  // a file that isn't compressed is read as is
+  VVM::GzipReader plain("../../sample_csv/prices.csv");
+  text.assign(expected.size() + 1, '\0');
+  text.resize(plain.read(&text[0], text.size()));
+  TEST((text == expected), true)
+
+  // blocks are all full except for the last
+  VVM::GzipStream stream("../../sample_csv/prices.csv.gz", 256);
+  text.clear();
+  size_t nblocks = 0;
+  while (stream.next(text)) {
+    nblocks++;
+    TEST((text.size() == expected.size() || text.size() == nblocks * 256),
+         true)
+  }
+  TEST(nblocks, (expected.size() + 255) / 256)
+  TEST((text == expected), true)
+  TEST(stream.next(text), false)
+
+  // a stream that is abandoned early still stops its thread
+  {
+    VVM::GzipStream early("../../sample_csv/prices.csv.gz", 16);
+    TEST(early.next(text), true)
+  }
+
+  bool threw = false;
+  try {
+    VVM::GzipReader missing("../../sample_csv/missing.csv.gz");
+  }
+  catch (std::logic_error& e) {
+    threw = true;
+  }
+  TEST(threw, true)
+
+  return main_ret;
+}
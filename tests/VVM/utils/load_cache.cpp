@@ -0,0 +1,48 @@
+/*
+ * Tests for snapshots of parsed files
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <VVM/utils/load_cache.hpp>
+
+int main() {
+  main_ret = 0;
+
+  const std::string type_def = "symbol: String, volume: Int64";
+  std::string snapshot = VVM::snapshot_filename("cache",
+                                                "../../sample_csv/prices.csv",
+                                                type_def);
+  TEST(snapshot.size(), std::string("cache/0123456789abcdef.edf").size())
+  TEST(snapshot.compare(0, 6, "cache/"), 0)
+
+  // the same file through another path has the same snapshot
+  TEST(VVM::snapshot_filename("cache", "../../sample_csv/daily/../prices.csv",
+                              type_def),
+       snapshot)
+
+  // another type or file has its own snapshot
+  TEST((VVM::snapshot_filename("cache", "../../sample_csv/prices.csv",
+                               "symbol: String") != snapshot), true)
+  TEST((VVM::snapshot_filename("cache", "../../sample_csv/listings.csv",
+                               type_def) != snapshot), true)
+
+  // a missing file has none
+  TEST(VVM::snapshot_filename("cache", "../../sample_csv/missing.csv",
+                              type_def),
+       std::string())
+
+  // every save writes to its own temporary file
+  std::string temp = VVM::snapshot_temp_filename(snapshot);
+  TEST(temp.compare(0, snapshot.size() + 1, snapshot + '.'), 0)
+  TEST(temp.compare(temp.size() - 4, 4, ".tmp"), 0)
+  TEST((VVM::snapshot_temp_filename(snapshot) != temp), true)
+
+  return main_ret;
+}
@@ -0,0 +1,106 @@
+/*
+ * Tests for numeric parsing
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <random>
+
+#include <VVM/utils/numeric.hpp>
+
+#define INT(s) VVM::parse_int64(s, strlen(s))
+#define FLOAT(s) VVM::parse_float64(s, strlen(s))
+#define BOOL(s) VVM::parse_bool(s, strlen(s))
+
+// whether the fast parse matches strtod exactly
+bool matches_strtod(const char* s) {
+  double x = FLOAT(s);
+  double y = strtod(s, nullptr);
+  return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+int main() {
+  main_ret = 0;
+
+  TEST(INT("5"), 5)
+  TEST(INT("-5"), -5)
+  TEST(INT("+5"), 5)
+  TEST(INT("0"), 0)
+  TEST(INT("  42"), 42)
+  TEST(INT("-9223372036854775808"), INT64_MIN)
+  TEST(INT("9223372036854775806"), 9223372036854775806)
+  TEST_NIL(INT("9223372036854775808"))
+  TEST_NIL(INT("-9223372036854775809"))
+  TEST_NIL(INT("99999999999999999999"))
+  TEST_NIL(INT(""))
+  TEST_NIL(INT("-"))
+  TEST_NIL(INT("x"))
+  TEST_NIL(INT("5x"))
+  TEST_NIL(INT("5 "))
+  TEST_NIL(INT("5.0"))
+
+  // only the first two characters are looked at
+  TEST(VVM::parse_int64("12,34", 2), 12)
+
+  TEST(FLOAT("5.5"), 5.5)
+  TEST(FLOAT("-5.5"), -5.5)
+  TEST(FLOAT("0.0"), 0.0)
+  TEST(FLOAT(".5"), 0.5)
+  TEST(FLOAT("5."), 5.0)
+  TEST(FLOAT("  1e3"), 1000.0)
+  TEST(FLOAT("1E-3"), 0.001)
+  TEST(FLOAT("0x10"), 16.0)
+  TEST(FLOAT("inf"), HUGE_VAL)
+  TEST(FLOAT("-1e400"), -HUGE_VAL)
+  TEST(std::signbit(FLOAT("-0.0")), true)
+  TEST_NIL(FLOAT("nan"))
+  TEST_NIL(FLOAT(""))
+  TEST_NIL(FLOAT("."))
+  TEST_NIL(FLOAT("x"))
+  TEST_NIL(FLOAT("1e"))
+  TEST_NIL(FLOAT("1.5x"))
+  TEST_NIL(FLOAT("1.5 "))
+  TEST(VVM::parse_float64("116.15,28781865", 6), 116.15)
+
+  // fast path must round exactly as the standard library does
+  TEST(matches_strtod("0.1"), true)
+  TEST(matches_strtod("115.80"), true)
+  TEST(matches_strtod("9007199254740993"), true)
+  TEST(matches_strtod("1.7976931348623157e308"), true)
+  TEST(matches_strtod("4.9e-324"), true)
+  TEST(matches_strtod("123456789012345678901234567890"), true)
+  TEST(matches_strtod("0.000000000000000000000000000001"), true)
+  TEST(matches_strtod("1e37"), true)
+  TEST(matches_strtod("123e30"), true)
+
+  std::mt19937_64 gen(42);
+  bool all_match = true;
+  for (size_t i = 0; i < 100000; i++) {
+    char buffer[64];
+    uint64_t digits = gen() % 100000000000000000;
+    int scale = int(gen() % 40) - 20;
+    snprintf(buffer, sizeof(buffer), "%llu.%llue%d",
+             (unsigned long long)(digits / 1000),
+             (unsigned long long)(digits % 1000), scale);
+    all_match &= matches_strtod(buffer);
+    snprintf(buffer, sizeof(buffer), "%.*f", int(gen() % 8),
+             double(gen() % 100000000) / 100.0);
+    all_match &= matches_strtod(buffer);
+  }
+  TEST(all_match, true)
+
+  TEST(BOOL("true"), true)
+  TEST(BOOL("false"), false)
+  TEST(BOOL("True"), false)
+  TEST(BOOL(""), false)
+
+  return main_ret;
+}
+
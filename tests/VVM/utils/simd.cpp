@@ -0,0 +1,360 @@
+/*
+ * Tests for vectorized arithmetic on columns
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <VVM/utils/simd.hpp>
+
+const int64_t int_nil = std::numeric_limits<int64_t>::max();
+const int64_t int_min = std::numeric_limits<int64_t>::min();
+const double float_nil = std::numeric_limits<double>::quiet_NaN();
+
+const VVM::SimdLevel levels[] = {VVM::SimdLevel::kSse42,
+                                 VVM::SimdLevel::kAvx2,
+                                 VVM::SimdLevel::kAvx512};
+
+// random values, including nil and the edges of each type
+std::vector<int64_t> random_ints(std::mt19937_64& gen, size_t n) {
+  const int64_t specials[] = {int_nil, int_min, 0, -1, 1, int_nil - 1,
+                              int64_t(1) << 32, -(int64_t(1) << 32)};
+  std::vector<int64_t> xs(n);
+  for (auto& x: xs) {
+    size_t pick = gen() % 16;
+    x = (pick < 8) ? specials[pick] : int64_t(gen());
+  }
+  return xs;
+}
+
+std::vector<double> random_doubles(std::mt19937_64& gen, size_t n) {
+  const double specials[] = {float_nil, 0.0, -0.0, 1.0, -1.0,
+                             std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::max(),
+                             std::numeric_limits<double>::denorm_min()};
+  std::uniform_real_distribution<double> dist(-1e6, 1e6);
+  std::vector<double> xs(n);
+  for (auto& x: xs) {
+    size_t pick = gen() % 16;
+    x = (pick < 8) ? specials[pick] : dist(gen);
+  }
+  return xs;
+}
+
+// results must match the scalar loop bit for bit (including NaN and -0.0)
+template<class T>
+size_t binop_mismatches(VVM::SimdOp op, const std::vector<T>& xs,
+                        const std::vector<T>& ys) {
+  const size_t n = xs.size();
+  size_t mismatches = 0;
+  for (int shape = 0; shape < 3; shape++) {
+    bool x_scalar = (shape == 1), y_scalar = (shape == 2);
+    std::vector<T> expected(n), actual(n);
+    VVM::set_simd_level(VVM::SimdLevel::kScalar);
+    VVM::simd_binop(op, xs.data(), x_scalar, ys.data(), y_scalar,
+                    expected.data(), n);
+    for (auto level: levels) {
+      VVM::set_simd_level(level);
+      VVM::simd_binop(op, xs.data(), x_scalar, ys.data(), y_scalar,
+                      actual.data(), n);
+      if (n != 0 &&
+          memcmp(expected.data(), actual.data(), n * sizeof(T)) != 0) {
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+template<class T>
+size_t unop_mismatches(VVM::SimdOp op, const std::vector<T>& xs) {
+  const size_t n = xs.size();
+  size_t mismatches = 0;
+  std::vector<T> expected(n), actual(n);
+  VVM::set_simd_level(VVM::SimdLevel::kScalar);
+  VVM::simd_unop(op, xs.data(), expected.data(), n);
+  for (auto level: levels) {
+    VVM::set_simd_level(level);
+    VVM::simd_unop(op, xs.data(), actual.data(), n);
+    if (n != 0 &&
+        memcmp(expected.data(), actual.data(), n * sizeof(T)) != 0) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+// the nil-free flag only applies to integers
+bool compare(VVM::SimdOp op, const int64_t* xs, bool x_scalar,
+             const int64_t* ys, bool y_scalar, uint8_t* mask, size_t n,
+             bool nil_free) {
+  return VVM::simd_compare(op, xs, x_scalar, ys, y_scalar, mask, n, nil_free);
+}
+
+bool compare(VVM::SimdOp op, const double* xs, bool x_scalar,
+             const double* ys, bool y_scalar, uint8_t* mask, size_t n,
+             bool) {
+  return VVM::simd_compare(op, xs, x_scalar, ys, y_scalar, mask, n);
+}
+
+// comparisons must match the scalar loop for every shape of operands, and
+// also when the operands are known to have no nil
+template<class T>
+size_t compare_mismatches(VVM::SimdOp op, std::vector<T> xs,
+                          std::vector<T> ys, bool nil_free) {
+  const size_t n = xs.size();
+  if (nil_free) {
+    std::replace(xs.begin(), xs.end(), T(int_nil), T(0));
+    std::replace(ys.begin(), ys.end(), T(int_nil), T(0));
+  }
+  size_t mismatches = 0;
+  for (int shape = 0; shape < 3; shape++) {
+    bool x_scalar = (shape == 1), y_scalar = (shape == 2);
+    std::vector<uint8_t> expected(n), actual(n);
+    VVM::set_simd_level(VVM::SimdLevel::kScalar);
+    VVM::simd_compare(op, xs.data(), x_scalar, ys.data(), y_scalar,
+                      expected.data(), n);
+    for (auto level: levels) {
+      VVM::set_simd_level(level);
+      compare(op, xs.data(), x_scalar, ys.data(), y_scalar, actual.data(), n,
+              nil_free);
+      if (expected != actual) {
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+// a packed mask must have exactly the bits of its bytes
+size_t pack_mismatches(std::mt19937_64& gen, size_t n) {
+  std::vector<uint8_t> mask(n);
+  for (auto& m: mask) {
+    m = gen() % 2;
+  }
+  size_t mismatches = 0;
+  for (auto level: levels) {
+    VVM::set_simd_level(level);
+    std::vector<uint64_t> words((n + 63) / 64, ~uint64_t(0));
+    VVM::simd_pack(mask.data(), n, words.data());
+    for (size_t i = 0; i < words.size() * 64; i++) {
+      bool bit = (words[i / 64] >> (i % 64)) & 1;
+      if (bit != (i < n && mask[i] != 0)) {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  return mismatches;
+}
+
+// operands without nil give the same results without the nil check, and the
+// result is reported to be nil-free exactly when it is
+size_t nil_free_mismatches(VVM::SimdOp op, std::vector<int64_t> xs,
+                           std::vector<int64_t> ys) {
+  const size_t n = xs.size();
+  std::replace(xs.begin(), xs.end(), int_nil, int64_t(0));
+  std::replace(ys.begin(), ys.end(), int_nil, int64_t(0));
+  size_t mismatches = 0;
+  std::vector<int64_t> expected(n), actual(n);
+  VVM::set_simd_level(VVM::SimdLevel::kScalar);
+  VVM::simd_binop(op, xs.data(), false, ys.data(), false, expected.data(), n);
+  bool expected_nil_free = std::find(expected.begin(), expected.end(),
+                                     int_nil) == expected.end();
+  for (auto level: levels) {
+    VVM::set_simd_level(level);
+    bool nil_free = true;
+    VVM::simd_binop(op, xs.data(), false, ys.data(), false, actual.data(), n,
+                    nil_free);
+    if (nil_free != expected_nil_free ||
+        (n != 0 &&
+         memcmp(expected.data(), actual.data(), n * sizeof(int64_t)) != 0)) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+int main() {
+  main_ret = 0;
+  const VVM::SimdLevel detected = VVM::simd_level();
+
+  // the scalar loop is always available and no level exceeds the CPU's
+  TEST(int(VVM::set_simd_level(VVM::SimdLevel::kScalar)),
+       int(VVM::SimdLevel::kScalar))
+  TEST(int(VVM::set_simd_level(VVM::SimdLevel::kAvx512)), int(detected))
+
+  // operations without a vectorized form
+  std::vector<int64_t> is = {6, 7}, js = {2, 3}, ks(2);
+  std::vector<double> ds = {6.0, 7.0}, es = {2.0, 4.0}, fs(2);
+  TEST(VVM::simd_binop(VVM::SimdOp::kDiv, is.data(), false, js.data(), false,
+                       ks.data(), 2), false)
+  TEST(VVM::simd_binop(VVM::SimdOp::kBitAnd, ds.data(), false, es.data(),
+                       false, fs.data(), 2), false)
+  TEST(VVM::simd_binop(VVM::SimdOp::kNone, is.data(), false, js.data(), false,
+                       ks.data(), 2), false)
+  TEST(VVM::simd_unop(VVM::SimdOp::kAdd, is.data(), ks.data(), 2), false)
+
+  // integers
+  TEST(VVM::simd_binop(VVM::SimdOp::kAdd, is.data(), false, js.data(), false,
+                       ks.data(), 2), true)
+  TEST(ks[0], 8)
+  TEST(ks[1], 10)
+  TEST(VVM::simd_binop(VVM::SimdOp::kMul, is.data(), false, js.data(), true,
+                       ks.data(), 2), true)
+  TEST(ks[0], 12)
+  TEST(ks[1], 14)
+  TEST(VVM::simd_binop(VVM::SimdOp::kSub, is.data(), true, js.data(), false,
+                       ks.data(), 2), true)
+  TEST(ks[0], 4)
+  TEST(ks[1], 3)
+  TEST(VVM::simd_binop(VVM::SimdOp::kBitOr, is.data(), true, js.data(), true,
+                       ks.data(), 2), true)
+  TEST(ks[0], 6)
+  TEST(ks[1], 6)
+  TEST(VVM::simd_unop(VVM::SimdOp::kNeg, is.data(), ks.data(), 2), true)
+  TEST(ks[0], -6)
+  TEST(ks[1], -7)
+
+  // nil in either operand gives nil
+  is = {int_nil, 5, 5};
+  js = {1, int_nil, 1};
+  ks.resize(3);
+  VVM::simd_binop(VVM::SimdOp::kAdd, is.data(), false, js.data(), false,
+                  ks.data(), 3);
+  TEST(ks[0], int_nil)
+  TEST(ks[1], int_nil)
+  TEST(ks[2], 6)
+  VVM::simd_unop(VVM::SimdOp::kNeg, is.data(), ks.data(), 3);
+  TEST(ks[0], int_nil)
+  TEST(ks[1], -5)
+
+  // the nil check can be skipped, but the result can still be nil
+  bool nil_free = true;
+  is = {1, int_nil - 1};
+  js = {2, 1};
+  ks.resize(2);
+  VVM::simd_binop(VVM::SimdOp::kAdd, is.data(), false, js.data(), false,
+                  ks.data(), 2, nil_free);
+  TEST(nil_free, false)
+  TEST(ks[0], 3)
+  TEST(ks[1], int_nil)
+  nil_free = true;
+  VVM::simd_binop(VVM::SimdOp::kSub, is.data(), false, js.data(), false,
+                  ks.data(), 2, nil_free);
+  TEST(nil_free, true)
+  nil_free = false;
+  is = {int_nil, 5};
+  VVM::simd_binop(VVM::SimdOp::kMul, is.data(), false, js.data(), true,
+                  ks.data(), 2, nil_free);
+  TEST(nil_free, false)
+  nil_free = true;
+  is = {-int_nil, 5};
+  VVM::simd_unop(VVM::SimdOp::kNeg, is.data(), ks.data(), 2, nil_free);
+  TEST(nil_free, false)
+  TEST(ks[0], int_nil)
+  nil_free = true;
+  VVM::simd_unop(VVM::SimdOp::kNeg, js.data(), ks.data(), 2, nil_free);
+  TEST(nil_free, true)
+
+  // floats
+  TEST(VVM::simd_binop(VVM::SimdOp::kDiv, ds.data(), false, es.data(), false,
+                       fs.data(), 2), true)
+  TEST(fs[0], 3.0)
+  TEST(fs[1], 1.75)
+  ds = {float_nil, 1.0};
+  VVM::simd_binop(VVM::SimdOp::kMul, ds.data(), false, es.data(), false,
+                  fs.data(), 2);
+  TEST(std::isnan(fs[0]), true)
+  TEST(fs[1], 4.0)
+
+  // comparisons are false where an integer is nil, but NaN is unequal
+  std::vector<uint8_t> mask(3);
+  is = {int_nil, 5, 3};
+  js = {1, int_nil, 1};
+  TEST(VVM::simd_compare(VVM::SimdOp::kAdd, is.data(), false, js.data(),
+                         false, mask.data(), 3), false)
+  TEST(VVM::simd_compare(VVM::SimdOp::kNe, is.data(), false, js.data(),
+                         false, mask.data(), 3), true)
+  TEST(int(mask[0]), 0)
+  TEST(int(mask[1]), 0)
+  TEST(int(mask[2]), 1)
+  TEST(VVM::simd_compare(VVM::SimdOp::kGte, is.data(), false, js.data(), true,
+                         mask.data(), 3), true)
+  TEST(int(mask[0]), 0)
+  TEST(int(mask[1]), 1)
+  TEST(int(mask[2]), 1)
+  ds = {float_nil, 1.0, 2.0};
+  es = {1.0, float_nil, 2.0};
+  VVM::simd_compare(VVM::SimdOp::kNe, ds.data(), false, es.data(), false,
+                    mask.data(), 3);
+  TEST(int(mask[0]), 1)
+  TEST(int(mask[1]), 1)
+  TEST(int(mask[2]), 0)
+  VVM::simd_compare(VVM::SimdOp::kLte, ds.data(), false, es.data(), false,
+                    mask.data(), 3);
+  TEST(int(mask[0]), 0)
+  TEST(int(mask[1]), 0)
+  TEST(int(mask[2]), 1)
+
+  // a mask packs into words of bits
+  std::vector<uint8_t> bytes = {1, 0, 1, 1};
+  std::vector<uint64_t> words = {~uint64_t(0)};
+  VVM::simd_pack(bytes.data(), 4, words.data());
+  TEST(words[0], 13)
+
+  // every instruction set agrees with the scalar loop for every length
+  std::mt19937_64 gen(20190101);
+  const VVM::SimdOp int_ops[] = {VVM::SimdOp::kAdd, VVM::SimdOp::kSub,
+                                 VVM::SimdOp::kMul, VVM::SimdOp::kBitAnd,
+                                 VVM::SimdOp::kBitOr};
+  const VVM::SimdOp float_ops[] = {VVM::SimdOp::kAdd, VVM::SimdOp::kSub,
+                                   VVM::SimdOp::kMul, VVM::SimdOp::kDiv};
+  const VVM::SimdOp compare_ops[] = {VVM::SimdOp::kLt, VVM::SimdOp::kGt,
+                                     VVM::SimdOp::kEq, VVM::SimdOp::kNe,
+                                     VVM::SimdOp::kLte, VVM::SimdOp::kGte};
+  size_t mismatches = 0;
+  for (size_t n = 0; n <= 70; n++) {
+    for (auto op: int_ops) {
+      mismatches += binop_mismatches(op, random_ints(gen, n),
+                                     random_ints(gen, n));
+    }
+    mismatches += unop_mismatches(VVM::SimdOp::kNeg, random_ints(gen, n));
+    for (auto op: int_ops) {
+      mismatches += nil_free_mismatches(op, random_ints(gen, n),
+                                        random_ints(gen, n));
+    }
+    for (auto op: float_ops) {
+      mismatches += binop_mismatches(op, random_doubles(gen, n),
+                                     random_doubles(gen, n));
+    }
+    mismatches += unop_mismatches(VVM::SimdOp::kNeg, random_doubles(gen, n));
+    for (auto op: compare_ops) {
+      mismatches += compare_mismatches(op, random_ints(gen, n),
+                                       random_ints(gen, n), false);
+      mismatches += compare_mismatches(op, random_ints(gen, n),
+                                       random_ints(gen, n), true);
+      mismatches += compare_mismatches(op, random_doubles(gen, n),
+                                       random_doubles(gen, n), false);
+    }
+  }
+  for (size_t n = 0; n <= 300; n++) {
+    mismatches += pack_mismatches(gen, n);
+  }
+  TEST(mismatches, 0)
+
+  VVM::set_simd_level(detected);
+  return main_ret;
+}
@@ -10,9 +10,69 @@
 
 #include "test.hpp"
 
+#include <vector>
+
 #include <VVM/utils/timestamp.hpp>
 #include <VVM/utils/conversion.hpp>
 
+// the text from strftime, which NanosFormatter must match
+std::string strftime_delta(int64_t delta) {
+  static const int64_t ns_per_day = 86400000000000;
+  int64_t sign = delta < 0 ? -1 : 1;
+  std::string str = sign == -1 ? "-" : "";
+  int64_t full_days = (sign * delta) / ns_per_day;
+  if (full_days != 0) {
+    str += std::to_string(full_days) + " days";
+  }
+  int64_t sub_days = (sign * delta) % ns_per_day;
+  if (sub_days != 0) {
+    if (full_days != 0) {
+      str += ' ';
+    }
+    str += VVM::nanos_to_string(sub_days, "%H:%M:%S.%f");
+  }
+  return str;
+}
+
+// check every method of one formatter against strftime, so that the date it
+// keeps from the previous value is exercised as well
+bool matches_strftime(const std::vector<int64_t>& values) {
+  VVM::NanosFormatter formatter;
+  char buffer[VVM::NanosFormatter::max_size];
+  bool same = true;
+  for (int64_t x: values) {
+    std::string expected = VVM::nanos_to_string(x, "%Y-%m-%d %H:%M:%S.%f");
+    std::string actual(buffer, formatter.timestamp(x, buffer));
+    if (actual != expected) {
+      std::cout << "timestamp " << x << ": " << actual << " != " << expected
+                << std::endl;
+      same = false;
+    }
+    expected = VVM::nanos_to_string(x, "%Y-%m-%d");
+    actual.assign(buffer, formatter.date(x, buffer));
+    if (actual != expected) {
+      std::cout << "date " << x << ": " << actual << " != " << expected
+                << std::endl;
+      same = false;
+    }
+    expected = VVM::nanos_to_string(x, "%H:%M:%S.%f");
+    actual.assign(buffer, formatter.time(x, buffer));
+    if (actual != expected) {
+      std::cout << "time " << x << ": " << actual << " != " << expected
+                << std::endl;
+      same = false;
+    }
+    expected = strftime_delta(x);
+    actual.assign(buffer, formatter.delta(x, buffer));
+    if (actual != expected) {
+      std::cout << "delta " << x << ": " << actual << " != " << expected
+                << std::endl;
+      same = false;
+    }
+  }
+  return same;
+}
+
 int main() {
   main_ret = 0;
 
@@ -81,6 +141,69 @@ int main() {
        "22:16:33.441076")
 
 
+  // the fixed formats match strftime, including before the epoch
+  const int64_t ns_per_day = 86400000000000;
+  std::vector<int64_t> values = {
+    0, 1, 999999999, 1000000000, 59999999999, 3600000000000,
+    ns_per_day - 1, ns_per_day, ns_per_day + 1,
+    1553811393441076000, 1553811393441076000, 1553811393441076001,
+    1553731200000000000, 951782400000000000, 951868800000000000,
+    4102444800000000000, 9223372036854775806,
+    -1, -999999999, -1000000000, -60000000000, -ns_per_day,
+    -ns_per_day - 1, -86400000000000 * 365, -1553811393441076000
+  };
+  for (int64_t day = -800; day < 800; day += 7) {
+    values.push_back(day * 37 * ns_per_day + day * 1234567891011);
+  }
+  TEST(matches_strftime(values), true)
+
+  // nil has no text, and doesn't disturb its neighbors in a column
+  TEST(VVM::to_string(VVM::nil_value<VVM::Timestamp>()), "")
+  TEST(VVM::to_string(VVM::nil_value<VVM::Date>()), "")
+  TEST(VVM::to_string(VVM::nil_value<VVM::Time>()), "")
+  TEST(VVM::to_string(VVM::nil_value<VVM::Timedelta>()), "")
+  std::vector<VVM::Timestamp> ts = {VVM::Timestamp(1553811393441076000),
+                                    VVM::nil_value<VVM::Timestamp>(),
+                                    VVM::Timestamp(1553811393441076000)};
+  std::vector<std::string> texts(ts.size());
+  VVM::to_strings(ts, 0, ts.size(), texts.data());
+  TEST(texts[0], "2019-03-28 22:16:33.441076000")
+  TEST(texts[1], "")
+  TEST(texts[2], "2019-03-28 22:16:33.441076000")
+  std::vector<VVM::Timedelta> ds = {VVM::Timedelta(-90000000000000),
+                                    VVM::nil_value<VVM::Timedelta>()};
+  VVM::to_strings(ds, 0, ds.size(), texts.data());
+  TEST(texts[0], "-1 days 01:00:00.000000000")
+  TEST(texts[1], "")
+
+
+  TEST(VVM::StrtimeFormat("%Y-%m-%d %H:%M:%S.%f").parse("2019-03-28 22:16:33.441076", 26),
+       1553811393441076000)
+
+  TEST(VVM::StrtimeFormat("%Y-%m-%d %H:%M:%S").parse("2019-03-28 22:16:33", 19),
+       1553811393000000000)
+
+  TEST(VVM::StrtimeFormat("%Y-%m-%d").parse("2019-03-28", 10),
+       1553731200000000000)
+
+  TEST(VVM::StrtimeFormat("%H:%M:%S.%f").parse("22:16:33.441076", 15),
+       80193441076000)
+
+  TEST(VVM::StrtimeFormat("%Y/%m/%d").parse("2019/03/28", 10),
+       1553731200000000000)
+
+  TEST(VVM::StrtimeFormat("%Y-%m-%d").parse("2019-03-28 22:16:33", 19),
+       1553811393000000000)
+
+  TEST(VVM::StrtimeFormat().parse("2019-03-28", 10),
+       1553731200000000000)
+
+  TEST(VVM::StrtimeFormat("%Y-%m-%d").parse("2050-01-01", 10),
+       2524608000000000000)
+
+  TEST_NIL(VVM::StrtimeFormat("%Y-%m-%d").parse("err", 3))
+
+
   TEST(VVM::Date(1553731200000000000) + VVM::Time(80193441076000), VVM::Timestamp(1553811393441076000))
 
 
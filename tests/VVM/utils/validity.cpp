@@ -0,0 +1,131 @@
+/*
+ * Tests for validity bitmaps
+ *
+ * Copyright (C) 2019 Empirical Software Solutions, LLC
+ *
+ * This program is distributed under the terms of the GNU Affero General
+ * Public License with the Commons Clause.
+ *
+ */
+
+#include "test.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <VVM/utils/validity.hpp>
+
+const int64_t int_nil = std::numeric_limits<int64_t>::max();
+const double float_nil = std::numeric_limits<double>::quiet_NaN();
+
+int main() {
+  main_ret = 0;
+
+  // a column without nil has no bitmap
+  std::vector<int64_t> xs = {1, 2, 3};
+  VVM::Validity vxs = VVM::sentinel_validity(xs.data(), xs.size());
+  TEST(vxs.empty(), true)
+  TEST(VVM::count_missing(vxs, 3), 0)
+  std::vector<int64_t> xs_back = xs;
+  VVM::apply_validity(vxs, xs_back.data(), xs_back.size());
+  TEST((xs_back == xs), true)
+
+  // nil rows are clear bits; bits past the last row stay clear
+  std::vector<int64_t> ys = {int_nil, 5, int_nil};
+  VVM::Validity vys = VVM::sentinel_validity(ys.data(), ys.size());
+  TEST(vys.size(), 1)
+  TEST(vys[0], 2)
+  TEST(VVM::count_missing(vys, 3), 2)
+  std::vector<int64_t> ys_back = {7, 5, 9};
+  VVM::apply_validity(vys, ys_back.data(), ys_back.size());
+  TEST((ys_back == ys), true)
+
+  // rows span several words
+  std::vector<double> ds(130, 1.5);
+  ds[64] = float_nil;
+  ds[129] = float_nil;
+  VVM::Validity vds = VVM::sentinel_validity(ds.data(), ds.size());
+  TEST(vds.size(), 3)
+  TEST(vds[0], ~uint64_t(0))
+  TEST(vds[1], ~uint64_t(1))
+  TEST(vds[2], 1)
+  TEST(VVM::count_missing(vds, 130), 2)
+  std::vector<double> back(130, 1.5);
+  VVM::apply_validity(vds, back.data(), back.size());
+  TEST(std::isnan(back[64]), true)
+  TEST(std::isnan(back[129]), true)
+  TEST(back[128], 1.5)
+
+  // only the rows given are replaced, so a batch can be appended in place
+  std::vector<int64_t> batch = {1, 2, 3, 4};
+  VVM::apply_validity(VVM::Validity{0x1}, batch.data() + 2, 2);
+  TEST(batch[1], 2)
+  TEST(batch[2], 3)
+  TEST(batch[3], int_nil)
+
+  // Arrow's bitmaps are bytes in the same order
+  const char bitmap[] = {char(0xfd), char(0x01)};
+  VVM::Validity arrow = VVM::read_validity(bitmap, 9);
+  TEST(arrow.size(), 1)
+  TEST(arrow[0], 0x1fd)
+  TEST(VVM::count_missing(arrow, 9), 1)
+  char out[2] = {0, 0};
+  VVM::write_validity(arrow, 9, out);
+  TEST(int(uint8_t(out[0])), 0xfd)
+  TEST(int(uint8_t(out[1])), 0x01)
+  TEST(VVM::read_validity(nullptr, 9).empty(), true)
+  const char full[] = {char(0xff), char(0xff)};
+  TEST(VVM::read_validity(full, 9).empty(), true)
+  VVM::write_validity(VVM::Validity(), 9, out);
+  TEST(int(uint8_t(out[0])), 0xff)
+  TEST(int(uint8_t(out[1])), 0x01)
+
+  // a row is valid after combining only if it's valid in both
+  VVM::Validity both = VVM::combine_validity(VVM::Validity{0x6},
+                                             VVM::Validity{0x3});
+  TEST(both.size(), 1)
+  TEST(both[0], 0x2)
+  TEST(VVM::combine_validity(VVM::Validity(), vys)[0], 2)
+  TEST(VVM::combine_validity(vys, VVM::Validity())[0], 2)
+  TEST(VVM::is_valid(both, 1), true)
+  TEST(VVM::is_valid(both, 2), false)
+  TEST(VVM::is_valid(VVM::Validity(), 2), true)
+
+  // "and" with a valid false, or "or" with a valid true, is valid anyway;
+  // rows are (x, y): (T, -), (F, -), (-, -), (T, T)
+  uint64_t bx = 0x9;
+  uint64_t by = 0x8;
+  VVM::Validity bvx{0xb};
+  VVM::Validity bvy{0x8};
+  VVM::Validity band = VVM::logical_validity(true, &bx, false, bvx, &by,
+                                             false, bvy, 4);
+  TEST(band[0], 0xa)
+  VVM::Validity bor = VVM::logical_validity(false, &bx, false, bvx, &by,
+                                            false, bvy, 4);
+  TEST(bor[0], 0x9)
+
+  // a single value stands for every row, and it may decide every row
+  uint64_t all_false = 0;
+  TEST(VVM::logical_validity(true, &all_false, true, VVM::Validity(), &by,
+                             false, bvy, 4).empty(), true)
+  TEST(VVM::logical_validity(false, &all_false, true, VVM::Validity(), &by,
+                             false, bvy, 4)[0], 0x8)
+
+  // batches are appended at any bit, and stay empty while every row is valid
+  VVM::Validity appended;
+  VVM::append_validity(appended, 0, VVM::Validity(), 60);
+  TEST(appended.empty(), true)
+  VVM::append_validity(appended, 60, VVM::Validity{0x5}, 3);
+  TEST(appended.size(), 1)
+  TEST(appended[0], (uint64_t(1) << 60) - 1 + (uint64_t(0x5) << 60))
+  VVM::append_validity(appended, 63, VVM::Validity{0x2}, 2);
+  TEST(appended.size(), 2)
+  TEST((appended[0] >> 60), 0x5)
+  TEST(appended[1], 0x1)
+  VVM::append_validity(appended, 65, VVM::Validity(), 2);
+  TEST(appended[1], 0x7)
+  TEST(VVM::count_missing(appended, 67), 2)
+
+  return main_ret;
+}
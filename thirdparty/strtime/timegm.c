@@ -51,7 +51,7 @@ time_t fast_timegm(struct tm *timeptr) {
     total_days--;
   }
 
-  return (total_days * 86400) + (timeptr->tm_hour * 3600) +
+  return ((time_t) total_days * 86400) + (timeptr->tm_hour * 3600) +
          (timeptr->tm_min * 60) + timeptr->tm_sec;
 }
 